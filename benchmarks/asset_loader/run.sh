@@ -0,0 +1,10 @@
+#!/bin/sh
+set -eu
+
+HERE=$(CDPATH= cd -- "$(dirname -- "$0")" && pwd)
+RAE_ROOT=$(CDPATH= cd -- "$HERE/../.." && pwd)
+RAE_BIN="$RAE_ROOT/compiler/bin/rae"
+
+make -C "$RAE_ROOT/compiler" build >/dev/null
+# image.loadPng logs every file it loads; the sync case loads 200.
+"$RAE_BIN" run --target compiled --profile release "$HERE/main.rae" 2>&1 | grep -v '^\[image\] loaded '
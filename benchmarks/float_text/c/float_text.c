@@ -0,0 +1,119 @@
+/* Float <-> text: the runtime routines against libc printf/strtod.
+ * Links rae_runtime.c for rae_format_f64 / rae_parse_f64 and friends.
+ *
+ * Prints RESULT,<case>,<M conversions/s>,<checksum>; the rae_* and libc_*
+ * pair of a case handle identical inputs. */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rae_runtime.h"
+
+static int64_t now_ns(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (int64_t)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static void report(const char* name, int64_t start, int64_t count, int64_t checksum) {
+  double secs = (double)(now_ns() - start) / 1e9;
+  printf("RESULT,%s,%.2f,%lld\n", name, (double)count / secs / 1e6, (long long)checksum);
+}
+
+static uint64_t g_state = 0x9E3779B97F4A7C15ull;
+
+static uint64_t next_random(void) {
+  g_state ^= g_state << 13;
+  g_state ^= g_state >> 7;
+  g_state ^= g_state << 17;
+  return g_state;
+}
+
+int main(void) {
+  const char* env = getenv("RAE_FLOAT_BENCH_N");
+  const int64_t n = env && env[0] ? atoll(env) : 1000000;
+
+  /* "random": uniformly random bit patterns, full 17-digit output.
+   * "short": values with few digits (prices, coordinates), the common
+   * case in scene files and logs. */
+  double* random = malloc((size_t)n * sizeof(double));
+  double* short_vals = malloc((size_t)n * sizeof(double));
+  float* random32 = malloc((size_t)n * sizeof(float));
+  for (int64_t i = 0; i < n; i++) {
+    uint64_t bits;
+    do {
+      bits = next_random();
+      memcpy(&random[i], &bits, sizeof(double));
+    } while (!isfinite(random[i]));
+    short_vals[i] = (double)(int64_t)(next_random() % 2000000 - 1000000) / 100.0;
+    uint32_t b32;
+    do {
+      b32 = (uint32_t)next_random();
+      memcpy(&random32[i], &b32, sizeof(float));
+    } while (!isfinite(random32[i]));
+  }
+
+  char buf[RAE_FLOAT_FIXED_MAX];
+  int64_t sum, t0;
+
+  t0 = now_ns(); sum = 0;
+  for (int64_t i = 0; i < n; i++) sum += rae_format_f64(buf, random[i]);
+  report("format_random_rae", t0, n, sum);
+  t0 = now_ns(); sum = 0;
+  for (int64_t i = 0; i < n; i++) sum += snprintf(buf, sizeof buf, "%.17g", random[i]);
+  report("format_random_libc_17g", t0, n, sum);
+
+  t0 = now_ns(); sum = 0;
+  for (int64_t i = 0; i < n; i++) sum += rae_format_f64(buf, short_vals[i]);
+  report("format_short_rae", t0, n, sum);
+  t0 = now_ns(); sum = 0;
+  for (int64_t i = 0; i < n; i++) sum += snprintf(buf, sizeof buf, "%.17g", short_vals[i]);
+  report("format_short_libc_17g", t0, n, sum);
+  t0 = now_ns(); sum = 0;
+  for (int64_t i = 0; i < n; i++) sum += snprintf(buf, sizeof buf, "%g", short_vals[i]);
+  report("format_short_libc_g", t0, n, sum);
+
+  t0 = now_ns(); sum = 0;
+  for (int64_t i = 0; i < n; i++) sum += rae_format_f32(buf, random32[i]);
+  report("format_f32_rae", t0, n, sum);
+  t0 = now_ns(); sum = 0;
+  for (int64_t i = 0; i < n; i++) sum += snprintf(buf, sizeof buf, "%.9g", (double)random32[i]);
+  report("format_f32_libc_9g", t0, n, sum);
+
+  t0 = now_ns(); sum = 0;
+  for (int64_t i = 0; i < n; i++) sum += rae_format_f64_fixed(buf, short_vals[i], 3);
+  report("fixed3_rae", t0, n, sum);
+  t0 = now_ns(); sum = 0;
+  for (int64_t i = 0; i < n; i++) sum += snprintf(buf, sizeof buf, "%.3f", short_vals[i]);
+  report("fixed3_libc", t0, n, sum);
+
+  /* Parsing reads back the shortest text of the same values. */
+  char** texts = malloc((size_t)n * sizeof(char*));
+  int64_t* lens = malloc((size_t)n * sizeof(int64_t));
+  for (int pass = 0; pass < 2; pass++) {
+    const double* vals = pass == 0 ? random : short_vals;
+    for (int64_t i = 0; i < n; i++) {
+      int len = rae_format_f64(buf, vals[i]);
+      texts[i] = malloc((size_t)len + 1);
+      memcpy(texts[i], buf, (size_t)len);
+      texts[i][len] = '\0';
+      lens[i] = len;
+    }
+    double v, acc = 0;
+    t0 = now_ns();
+    for (int64_t i = 0; i < n; i++) {
+      rae_parse_f64((const uint8_t*)texts[i], lens[i], &v);
+      acc += v == vals[i];
+    }
+    report(pass == 0 ? "parse_random_rae" : "parse_short_rae", t0, n, (int64_t)acc);
+    acc = 0;
+    t0 = now_ns();
+    for (int64_t i = 0; i < n; i++) acc += strtod(texts[i], NULL) == vals[i];
+    report(pass == 0 ? "parse_random_libc" : "parse_short_libc", t0, n, (int64_t)acc);
+    for (int64_t i = 0; i < n; i++) free(texts[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,16 @@
+#!/bin/sh
+set -eu
+
+HERE=$(CDPATH= cd -- "$(dirname -- "$0")" && pwd)
+RAE_ROOT=$(CDPATH= cd -- "$HERE/../.." && pwd)
+RAE_BIN="$RAE_ROOT/compiler/bin/rae"
+RUNTIME="$RAE_ROOT/compiler/runtime"
+CC=${CC:-cc}
+
+make -C "$RAE_ROOT/compiler" build >/dev/null
+"$RAE_BIN" run --target compiled --profile release "$HERE/main.rae"
+
+BIN=${TMPDIR:-/tmp}/rae_float_text_bench
+$CC -std=gnu11 -O2 -I"$RUNTIME" "$HERE/c/float_text.c" "$RUNTIME/rae_runtime.c" \
+  -lm -lpthread -ldl -o "$BIN"
+"$BIN"
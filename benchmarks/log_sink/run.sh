@@ -0,0 +1,25 @@
+#!/bin/sh
+set -eu
+
+HERE=$(CDPATH= cd -- "$(dirname -- "$0")" && pwd)
+RAE_ROOT=$(CDPATH= cd -- "$HERE/../.." && pwd)
+RAE_BIN="$RAE_ROOT/compiler/bin/rae"
+RUNTIME="$RAE_ROOT/compiler/runtime"
+CC=${CC:-cc}
+WORK=${TMPDIR:-/tmp}/rae_log_sink_bench
+mkdir -p "$WORK"
+
+# Built once, outside the timing: the cases measure the program's own
+# output, so it runs with stdout redirected rather than under `rae run`.
+make -C "$RAE_ROOT/compiler" build >/dev/null
+"$RAE_BIN" build --emit-c --entry "$HERE/main.rae" --out "$WORK/log_sink.c"
+$CC -std=gnu11 -O2 -I"$RUNTIME" "$WORK/log_sink.c" "$RUNTIME/rae_runtime.c" \
+  -lm -lpthread -ldl -o "$WORK/log_sink"
+
+for policy in line size interval; do
+  echo "# RAE_LOG_FLUSH=$policy, stdout to a file"
+  RAE_LOG_FLUSH=$policy "$WORK/log_sink" > "$WORK/out.txt"
+  grep '^RESULT' "$WORK/out.txt"
+  echo "# RAE_LOG_FLUSH=$policy, stdout to a pipe"
+  RAE_LOG_FLUSH=$policy "$WORK/log_sink" | grep '^RESULT'
+done
@@ -0,0 +1,15 @@
+#!/bin/sh
+set -eu
+
+HERE=$(CDPATH= cd -- "$(dirname -- "$0")" && pwd)
+RAE_ROOT=$(CDPATH= cd -- "$HERE/../.." && pwd)
+RAE_BIN="$RAE_ROOT/compiler/bin/rae"
+SCENE="${TMPDIR:-/tmp}/rae_scene_bin_bench.raescene"
+
+make -C "$RAE_ROOT/compiler" build >/dev/null
+# Write the JSON source, pack it the way a build would, then time both loads.
+RAE_SCENE_BENCH_FILE="$SCENE" RAE_SCENE_BENCH_STAGE=write \
+  "$RAE_BIN" run --target compiled --profile release "$HERE/main.rae"
+"$RAE_BIN" pack "$SCENE" -o "$SCENE.bin" >/dev/null
+RAE_SCENE_BENCH_FILE="$SCENE" \
+  "$RAE_BIN" run --target compiled --profile release "$HERE/main.rae"
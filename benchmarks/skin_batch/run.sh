@@ -0,0 +1,11 @@
+#!/bin/sh
+set -eu
+
+HERE=$(CDPATH= cd -- "$(dirname -- "$0")" && pwd)
+RAE_ROOT=$(CDPATH= cd -- "$HERE/../.." && pwd)
+RAE_BIN="$RAE_ROOT/compiler/bin/rae"
+
+make -C "$RAE_ROOT/compiler" build >/dev/null
+# The walker assets are opened relative to compiler/, like the test cases.
+cd "$RAE_ROOT/compiler"
+"$RAE_BIN" run --target compiled --profile release "$HERE/main.rae"
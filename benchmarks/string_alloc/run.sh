@@ -0,0 +1,12 @@
+#!/bin/sh
+set -eu
+
+HERE=$(CDPATH= cd -- "$(dirname -- "$0")" && pwd)
+RAE_ROOT=$(CDPATH= cd -- "$HERE/../.." && pwd)
+RAE_BIN="$RAE_ROOT/compiler/bin/rae"
+
+make -C "$RAE_ROOT/compiler" build >/dev/null
+echo "# slab allocator"
+"$RAE_BIN" run --target compiled --profile release "$HERE/main.rae"
+echo "# RAE_ALLOC=libc"
+RAE_ALLOC=libc "$RAE_BIN" run --target compiled --profile release "$HERE/main.rae"
@@ -10,6 +10,9 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <dirent.h>
+#if !defined(__wasm__) && !defined(_WIN32)
+#include <sys/mman.h>
+#endif
 
 /* WASM (wasip1) lacks signals, threads, flock, and fork/exec. Pure-compute
  * Rae programs (the raytracer, etc.) use none of these, but the runtime is one
@@ -37,18 +40,35 @@
  * unit to preserve existing static helper visibility, linker behavior, and
  * emitted-app build mechanics. See docs/runtime-kernel-abi.md. */
 #include "runtime_threads.c"
+/* Ahead of every String and Buffer producer: they allocate through it. */
+#include "runtime_alloc.c"
 #include "runtime_core_memory.c"
+/* Ahead of the string modules: toString and interpolation format with it. */
+#include "runtime_float_text.c"
 #include "runtime_strings_core.c"
+/* Ahead of the log functions, which format into its per-thread lines. */
+#include "runtime_log_sink.c"
 #include "runtime_system_log.c"
 #include "runtime_strings_algorithms.c"
 #include "runtime_filesystem.c"
 #include "runtime_buffers_math.c"
+/* After the clock in runtime_system_log.c: event timestamps use nowNs. */
+#include "runtime_profile.c"
+/* After the profiler: profiles reuse its protobuf helpers. */
+#include "runtime_heap_profile.c"
+/* After the profiler: counter deltas become profile counter events. */
+#include "runtime_perf_counters.c"
+/* After the clock in runtime_system_log.c and the perf counters: each
+ * sample is timed with nowNs and counted with the counters. */
+#include "runtime_bench.c"
 /* The cooked sky table. Ahead of every renderer that reads it, and outside
  * the WebGPU guards because the stub builds answer the same push. */
 #include "runtime_sky_state.c"
 #include "runtime_platform_apple.c"
 #include "runtime_raylib.c"
 #include "runtime_image_sdl3.c"
+/* After the image codecs: loader workers decode with rae_image_decode_rgba. */
+#include "runtime_asset_loader.c"
 #ifdef RAE_HAS_WEBGPU
 #include "runtime_webgpu.c"
 #ifdef RAE_HAS_SDL3
@@ -49,8 +49,8 @@ typedef int8_t rae_Bool;
 // String-ownership design):
 //   - is_owned == 0: borrowed / static literal. `drop` must NOT free.
 //                    capacity is meaningless (kept 0).
-//   - is_owned == 1: owned heap allocation made with malloc.
-//                    `drop` frees `data`. `capacity` is the malloc'd
+//   - is_owned == 1: owned heap allocation made with rae_mem_alloc.
+//                    `drop` frees `data`. `capacity` is the allocated
 //                    size (in bytes, including the trailing NUL).
 //
 // Positional initializers like `(rae_String){p, n}` from generated
@@ -111,6 +111,11 @@ typedef struct {
 } RaeAny;
 
 void rae_flush_stdout(void);
+/* The runtime allocator behind String bodies and Buffers (runtime_alloc.c).
+ * rae_mem_free takes its blocks and plain malloc blocks alike; a block it
+ * handed out must never reach libc free. */
+void* rae_mem_alloc(size_t bytes);
+void rae_mem_free(void* p);
 void* rae_ext_rae_buf_alloc(int64_t count, int64_t elem_size);
 void rae_ext_rae_buf_free(void* buf);
 void* rae_ext_rae_buf_resize(void* buf, int64_t new_count, int64_t elem_size);
@@ -140,11 +145,16 @@ void rae_ext_rae_log_any(RaeAny value);
 void rae_ext_rae_log_stream_any(RaeAny value);
 
 /* Mangled wrappers for primitives (used by specialized generics) */
-RAE_UNUSED static void rae_log_stream_int64_t_(int64_t v) { printf("%lld", (long long)v); }
-RAE_UNUSED static void rae_log_stream_double_(double v) { printf("%g", v); }
-RAE_UNUSED static void rae_log_stream_rae_Bool_(rae_Bool v) { printf("%s", v ? "true" : "false"); }
-RAE_UNUSED static void rae_log_stream_rae_String_(rae_String v) { printf("%.*s", (int)v.len, (char*)v.data); }
-RAE_UNUSED static void rae_log_stream_uint32_t_(uint32_t v) { printf("%lc", (wint_t)v); }
+void rae_ext_rae_log_stream_i64(int64_t value);
+void rae_ext_rae_log_stream_f64(double value);
+void rae_ext_rae_log_stream_bool(int8_t value);
+void rae_ext_rae_log_stream_string(rae_String value);
+void rae_ext_rae_log_stream_char(uint32_t value);
+RAE_UNUSED static void rae_log_stream_int64_t_(int64_t v) { rae_ext_rae_log_stream_i64(v); }
+RAE_UNUSED static void rae_log_stream_double_(double v) { rae_ext_rae_log_stream_f64(v); }
+RAE_UNUSED static void rae_log_stream_rae_Bool_(rae_Bool v) { rae_ext_rae_log_stream_bool(v); }
+RAE_UNUSED static void rae_log_stream_rae_String_(rae_String v) { rae_ext_rae_log_stream_string(v); }
+RAE_UNUSED static void rae_log_stream_uint32_t_(uint32_t v) { rae_ext_rae_log_stream_char(v); }
 RAE_UNUSED static void rae_log_stream_RaeAny_(RaeAny v) { rae_ext_rae_log_stream_any(v); }
 
 /* Conversion Helpers */
@@ -303,13 +313,9 @@ RAE_UNUSED static RaeAny rae_any_bool_ptr(rae_Bool* v) { return rae_any_view(v,
 void rae_ext_rae_log_cstr(const char* text);
 void rae_ext_rae_log_stream_cstr(const char* text);
 void rae_ext_rae_log_i64(int64_t value);
-void rae_ext_rae_log_stream_i64(int64_t value);
 void rae_ext_rae_log_bool(int8_t value);
-void rae_ext_rae_log_stream_bool(int8_t value);
 void rae_ext_rae_log_string(rae_String value);
-void rae_ext_rae_log_stream_string(rae_String value);
 void rae_ext_rae_log_char(uint32_t value);
-void rae_ext_rae_log_stream_char(uint32_t value);
 void rae_ext_rae_log_id(int64_t value);
 void rae_ext_rae_log_stream_id(int64_t value);
 void rae_ext_rae_log_key(rae_String value);
@@ -401,16 +407,17 @@ RAE_UNUSED static inline rae_String rae_string_borrow(rae_String s) {
 // Codegen contract:
 //   - emit_stmt wraps each potentially-temp-producing statement
 //     with `int __m = rae_string_pool_mark(); ... rae_string_pool_flush(__m);`
+//   - every loop iteration is a scope too: the body (and, separately,
+//     the condition) runs between a mark and a flush, so temps of
+//     lets, ifs and conditions don't pile up across iterations
 //   - rae_ext_rae_str_interp registers its result before returning
 //     (so the flush sweeps it up)
 //   - let/assign/struct-init that captures a registered result
 //     wraps with rae_string_pool_take(expr) to detach the entry
 //     and keep ownership in the captured binding.
 //
-// Sized for ~hundreds of nested temps per statement; statements
-// that genuinely exceed this still won't crash — extra registrations
-// are silently dropped (which means they'll leak, the conservative
-// failure mode).
+// Register, remove/take and contains are O(1) at any pool depth and the
+// pool grows as needed; flush is O(entries freed).
 void rae_string_pool_register(void* ptr);
 int rae_string_pool_mark(void);
 void rae_string_pool_flush(int saved);
@@ -491,8 +498,21 @@ rae_String rae_ext_rae_str_trim(rae_String s);
 rae_String rae_ext_rae_str_to_lower(rae_String s);
 uint32_t rae_ext_rae_str_at(rae_String s, int64_t index);
 double rae_ext_rae_str_to_f64(rae_String s);
+float rae_ext_rae_str_to_f32(rae_String s);
 int64_t rae_ext_rae_str_to_i64(rae_String s);
 
+/* Float <-> text (runtime_float_text.c). The formatters write no NUL and
+ * return the length; the parsers read s[0, len) and return the index just
+ * past the number, 0 when there is none. */
+enum { RAE_FLOAT_TEXT_MAX = 32, RAE_FLOAT_FIXED_MAX = 128 };
+int rae_format_f64(char* out, double v);
+int rae_format_f32(char* out, float v);
+int rae_format_f64_fixed(char* out, double v, int digits);
+int rae_format_f64_exp(char* out, double v, int digits);
+int64_t rae_parse_f64(const uint8_t* s, int64_t len, double* out);
+int64_t rae_parse_f32(const uint8_t* s, int64_t len, float* out);
+int64_t rae_parse_i64(const uint8_t* s, int64_t len, int64_t* out);
+
 rae_String rae_ext_rae_io_read_line(void);
 rae_Char rae_ext_rae_io_read_char(void);
 
@@ -524,13 +544,126 @@ int64_t rae_ext_rae_chan_recv(int64_t ch);
 int64_t rae_ext_rae_chan_received(int64_t ch);
 void rae_ext_rae_chan_free(int64_t ch);
 
+/* Frame profiler — see lib/profile.rae and runtime_profile.c: per-thread
+ * event rings drained to a Chrome JSON / Perfetto trace by a writer thread. */
+rae_Bool rae_ext_rae_sys_prof_start(rae_String path);
+int64_t rae_ext_rae_sys_prof_stop(void);
+int64_t rae_ext_rae_sys_prof_dropped(void);
+rae_Bool rae_ext_rae_sys_prof_active(void);
+void rae_ext_rae_sys_prof_event(rae_String name, int64_t ph, int64_t value);
+void rae_ext_rae_sys_prof_thread_name(rae_String name);
+/* `rae build --instrument`: each instrumented function owns a static site
+ * that caches its interned zone name and its timing, which can mute it.
+ * The recording test is inlined so an idle instrumented build pays one
+ * load and branch per call. */
+typedef struct {
+  const char* name;
+  int64_t len;
+  uint32_t id;
+  int muted;
+  int64_t calls;
+  int64_t total_ns;
+} RaeProfSite;
+extern int rae_prof_recording;
+int64_t rae_prof_enter_slow(RaeProfSite* site);
+void rae_prof_leave_slow(RaeProfSite* site, int64_t t0);
+RAE_UNUSED static inline int64_t rae_prof_enter(RaeProfSite* site) {
+  if (!__atomic_load_n(&rae_prof_recording, __ATOMIC_RELAXED) ||
+      __atomic_load_n(&site->muted, __ATOMIC_RELAXED)) return 0;
+  return rae_prof_enter_slow(site);
+}
+RAE_UNUSED static inline void rae_prof_leave(RaeProfSite* site, int64_t t0) {
+  if (t0) rae_prof_leave_slow(site, t0);
+}
+void rae_prof_instrument_start(void);
+void rae_prof_crash_flush(void);
+
+/* Log sink — see lib/logging.rae and runtime_log_sink.c: per-thread line
+ * buffers, line/size/interval flush policies and run-time levels behind
+ * every log and logS. */
+void rae_ext_rae_log_at(int64_t level, rae_String text);
+void rae_ext_rae_log_flush(void);
+void rae_ext_rae_log_set_flush(int64_t policy, int64_t bytes, int64_t ms);
+int64_t rae_ext_rae_log_flush_policy(void);
+void rae_ext_rae_log_set_level(int64_t level);
+int64_t rae_ext_rae_log_level(void);
+int64_t rae_ext_rae_log_written(void);
+void rae_log_crash_flush(void);
+
+/* Performance counters — see lib/sys.rae and runtime_perf_counters.c:
+ * per-thread cycles, instructions, cache and branch misses and page faults
+ * via perf_event_open; -1 where a counter is unavailable. */
+rae_Bool rae_ext_rae_sys_perf_available(int64_t which);
+void rae_ext_rae_sys_perf_begin(void);
+void rae_ext_rae_sys_perf_end(void);
+int64_t rae_ext_rae_sys_perf_value(int64_t which);
+void rae_ext_rae_sys_perf_profile(void);
+
+/* Benchmark harness — see runtime_bench.c. `rae bench` builds a main that
+ * passes the program's `bench` functions here. */
+typedef int64_t (*RaeBenchFn)(int64_t n);
+typedef struct {
+  const char* name;
+  RaeBenchFn fn;
+} RaeBenchCase;
+int rae_bench_main(int argc, char** argv, const RaeBenchCase* cases, int count);
+
+/* Sampling heap profiler — see lib/heap_profile.rae and
+ * runtime_heap_profile.c: allocation stacks sampled every ~rate bytes,
+ * live/peak per stack, snapshots, pprof output. */
+rae_Bool rae_ext_rae_sys_heap_start(int64_t rate);
+void rae_ext_rae_sys_heap_stop(void);
+rae_Bool rae_ext_rae_sys_heap_active(void);
+int64_t rae_ext_rae_sys_heap_live_bytes(void);
+int64_t rae_ext_rae_sys_heap_peak_bytes(void);
+int64_t rae_ext_rae_sys_heap_snapshot(void);
+rae_Bool rae_ext_rae_sys_heap_write(rae_String path, int64_t since);
+rae_String rae_ext_rae_sys_heap_report(int64_t top, int64_t since);
+
+/* Runtime allocator — see runtime_alloc.c: per-thread size-class slabs
+ * behind String bodies and Buffer storage, and per-thread frame arenas
+ * (lib/frame_arena.rae). */
+void rae_ext_rae_sys_frame_arena_begin(void);
+void rae_ext_rae_sys_frame_arena_end(void);
+rae_Bool rae_ext_rae_sys_frame_arena_reset(void);
+int64_t rae_ext_rae_sys_frame_arena_used(void);
+int64_t rae_ext_rae_sys_frame_arena_peak(void);
+int64_t rae_ext_rae_mem_live_bytes(void);
+
+/* Background asset loader — see lib/asset_loader.rae and
+ * runtime_asset_loader.c: worker-pool decode + lock-free completion queue. */
+int64_t rae_ext_rae_asset_loader_new(int64_t workers);
+int64_t rae_ext_rae_asset_request_image(int64_t loader, rae_String path, int64_t priority);
+int64_t rae_ext_rae_asset_request_external(int64_t loader, rae_String path, int64_t priority);
+int64_t rae_ext_rae_asset_next_external(int64_t loader);
+void rae_ext_rae_asset_complete(int64_t loader, int64_t job, rae_Bool ok);
+void rae_ext_rae_asset_set_priority(int64_t loader, int64_t job, int64_t priority);
+rae_Bool rae_ext_rae_asset_cancel(int64_t loader, int64_t job);
+int64_t rae_ext_rae_asset_poll(int64_t loader);
+int64_t rae_ext_rae_asset_outstanding(int64_t loader);
+int64_t rae_ext_rae_asset_status(int64_t loader, int64_t job);
+rae_String rae_ext_rae_asset_error(int64_t loader, int64_t job);
+rae_String rae_ext_rae_asset_path(int64_t loader, int64_t job);
+int64_t rae_ext_rae_asset_width(int64_t loader, int64_t job);
+int64_t rae_ext_rae_asset_height(int64_t loader, int64_t job);
+void* rae_ext_rae_asset_take_pixels(int64_t loader, int64_t job, rae_Mod_Int64 w, rae_Mod_Int64 h);
+void rae_ext_rae_asset_release(int64_t loader, int64_t job);
+void rae_ext_rae_asset_loader_free(int64_t loader);
+/* Runtime-internal: hand a decoded job's RGBA8 bytes to gpu2d upload. */
+unsigned char* rae_asset_take_rgba(int64_t loader, int64_t job, unsigned* w, unsigned* h);
+
 void rae_ext_rae_sys_exit(int64_t code);
 rae_String rae_ext_rae_sys_get_env(rae_String name);
 rae_String rae_ext_rae_sys_read_file(rae_String path);
 /* Binary counterpart: a Buffer of one-byte-per-Int values, for container
  * formats whose content is not text. */
 void* rae_ext_rae_sys_read_file_bytes(rae_String path, rae_Mod_Int64 out);
+rae_Bool rae_ext_rae_sys_write_file_bytes(rae_String path, const int64_t* data, int64_t len);
 rae_String rae_ext_rae_sys_read_file_text(rae_String path, int64_t offset, int64_t len);
+void* rae_ext_rae_sys_map_file(rae_String path, rae_Mod_Int64 out);
+void rae_ext_rae_sys_unmap_file(void* data, int64_t len);
+void* rae_ext_rae_sys_mapped_at(void* data, int64_t byteOffset);
+rae_String rae_ext_rae_sys_mapped_string(void* data, int64_t byteOffset, int64_t len);
 rae_String rae_ext_rae_sys_list_dir(rae_String folder);
 /* captureAndBlurRegion and loadCircleCroppedTexture are declared
  * in the raylib.h-scope helper block above (RAE_HAS_RAYLIB);
@@ -546,12 +679,23 @@ rae_Bool rae_ext_rae_sys_lock_file(rae_String path);
 rae_Bool rae_ext_rae_sys_unlock_file(rae_String path);
 double rae_ext_rae_sys_file_mtime(rae_String path);
 int64_t rae_ext_rae_sys_rss_kb(void);
+int64_t rae_ext_rae_sys_cpu_count(void);
 
 rae_String rae_ext_rae_str_i64(int64_t v);
 rae_String rae_ext_rae_str_i64_ptr(const int64_t* v);
 rae_String rae_ext_rae_str_f64(double v);
 rae_String rae_ext_rae_str_f64_ptr(const double* v);
+rae_String rae_ext_rae_str_f32(float v);
 rae_String rae_ext_rae_str_f32_ptr(const float* v);
+rae_String rae_ext_rae_str_f64_fixed(double v, int64_t digits);
+rae_String rae_ext_rae_str_f64_exp(double v, int64_t digits);
+rae_String rae_ext_rae_str_f32_fixed(float v, int64_t digits);
+rae_String rae_ext_rae_str_f32_exp(float v, int64_t digits);
+/* Whole-string parses: *error_at gets the byte index the number stopped
+ * at, or -1 when all of s was the number. */
+float rae_ext_rae_str_parse_f32(rae_String s, rae_Mod_Int64 error_at);
+double rae_ext_rae_str_parse_f64(rae_String s, rae_Mod_Int64 error_at);
+int64_t rae_ext_rae_str_parse_i64(rae_String s, rae_Mod_Int64 error_at);
 rae_String rae_ext_rae_str_bool(rae_Bool v);
 rae_String rae_ext_rae_str_bool_ptr(const rae_Bool* v);
 rae_String rae_ext_rae_str_char(uint32_t v);
@@ -564,7 +708,7 @@ rae_String rae_ext_rae_str_any(RaeAny v); // String-format any boxed value (incl
 
 /* JSON helpers */
 RAE_UNUSED static rae_String rae_json_build(const char* s, int64_t len) {
-    uint8_t* copy = (uint8_t*)malloc((size_t)len + 1);
+    uint8_t* copy = (uint8_t*)rae_mem_alloc((size_t)len + 1);
     if (copy) { memcpy(copy, s, (size_t)len); copy[len] = 0; }
     return (rae_String){copy, len, len + 1, 1};
 }
@@ -626,7 +770,7 @@ RAE_UNUSED static const char* rae_str_any(RaeAny v) {
         case RAE_TYPE_INT32: res = rae_ext_rae_str_to_cstr(rae_ext_rae_str_i64(v.as.i)); break;
         case RAE_TYPE_UINT64: res = rae_ext_rae_str_to_cstr(rae_ext_rae_str_i64(v.as.i)); break;
         case RAE_TYPE_FLOAT64: res = rae_ext_rae_str_to_cstr(rae_ext_rae_str_f64(v.as.f)); break;
-        case RAE_TYPE_FLOAT32: res = rae_ext_rae_str_to_cstr(rae_ext_rae_str_f64(v.as.f)); break;
+        case RAE_TYPE_FLOAT32: res = rae_ext_rae_str_to_cstr(rae_ext_rae_str_f32((float)v.as.f)); break;
         case RAE_TYPE_BOOL: res = rae_ext_rae_str_to_cstr(rae_ext_rae_str_bool(v.as.b)); break;
         case RAE_TYPE_STRING: res = rae_ext_rae_str_to_cstr(v.as.s); break;
         case RAE_TYPE_CHAR: res = rae_ext_rae_str_to_cstr(rae_ext_rae_str_char((uint32_t)v.as.i)); break;
@@ -657,7 +801,7 @@ RAE_UNUSED static void rae_any_drop(RaeAny* v) {
         case RAE_TYPE_ANY:
             if (v->as.ptr) {
                 if (v->drop) v->drop(v->as.ptr);
-                free(v->as.ptr);
+                rae_mem_free(v->as.ptr);
             }
             break;
         default:
@@ -772,7 +916,7 @@ void rae_ext_drawTextWithFont(int64_t slot, rae_String text, float x, float y, f
     const double*: rae_ext_rae_str_f64_ptr, \
     float*: rae_ext_rae_str_f32_ptr, \
     const float*: rae_ext_rae_str_f32_ptr, \
-    float: rae_ext_rae_str_f64, \
+    float: rae_ext_rae_str_f32, \
     bool: rae_ext_rae_str_bool, \
     int8_t: rae_ext_rae_str_bool, \
     rae_String: rae_ext_rae_str_string, \
@@ -788,6 +932,86 @@ void rae_ext_drawTextWithFont(int64_t slot, rae_String text, float x, float y, f
     default: rae_ext_rae_str_string \
 )(X)
 
+// Single-pass interpolation. Codegen lowers `"x={a} y={b}"` to
+//
+//   ({ RaeFmt f; rae_fmt_begin(&f); rae_fmt_put(&f, "x="); rae_fmt_put(&f, a);
+//      rae_fmt_put(&f, " y="); rae_fmt_put(&f, b); rae_fmt_finish(&f); })
+//
+// Each part is formatted straight into f's buffer, which lives on the
+// stack until a result outgrows RAE_FMT_INLINE bytes. rae_fmt_finish
+// makes the one owned String and registers it with the temp pool, like
+// rae_ext_rae_str_interp. Parts are appended left to right, with no
+// per-part String temporaries; only rae_fmt_str_owned consumes one (a
+// user struct's toString result).
+enum { RAE_FMT_INLINE = 256 };
+typedef struct {
+  uint8_t* buf;
+  int64_t len;
+  int64_t cap;
+  uint8_t inline_buf[RAE_FMT_INLINE];
+} RaeFmt;
+
+void rae_fmt_grow(RaeFmt* f, int64_t extra);
+void rae_fmt_i64(RaeFmt* f, int64_t v);
+void rae_fmt_f64(RaeFmt* f, double v);
+void rae_fmt_f32(RaeFmt* f, float v);
+void rae_fmt_bool(RaeFmt* f, rae_Bool v);
+void rae_fmt_char(RaeFmt* f, uint32_t v);
+void rae_fmt_any(RaeFmt* f, RaeAny v);
+void rae_fmt_str_owned(RaeFmt* f, rae_String s);
+rae_String rae_fmt_finish(RaeFmt* f);
+
+RAE_UNUSED static inline void rae_fmt_begin(RaeFmt* f) {
+  f->buf = f->inline_buf;
+  f->len = 0;
+  f->cap = RAE_FMT_INLINE;
+}
+
+// Room for `extra` more bytes at f->buf + f->len.
+RAE_UNUSED static inline uint8_t* rae_fmt_reserve(RaeFmt* f, int64_t extra) {
+  if (f->len + extra > f->cap) rae_fmt_grow(f, extra);
+  return f->buf + f->len;
+}
+
+RAE_UNUSED static inline void rae_fmt_str(RaeFmt* f, rae_String s) {
+  if (!s.data || s.len <= 0) return;
+  memcpy(rae_fmt_reserve(f, s.len), s.data, (size_t)s.len);
+  f->len += s.len;
+}
+
+RAE_UNUSED static inline void rae_fmt_str_ptr(RaeFmt* f, const rae_String* s) { rae_fmt_str(f, *s); }
+RAE_UNUSED static inline void rae_fmt_i64_ptr(RaeFmt* f, const int64_t* v) { rae_fmt_i64(f, *v); }
+RAE_UNUSED static inline void rae_fmt_u8(RaeFmt* f, unsigned char v) { rae_fmt_i64(f, (int64_t)v); }
+RAE_UNUSED static inline void rae_fmt_f64_ptr(RaeFmt* f, const double* v) { rae_fmt_f64(f, *v); }
+RAE_UNUSED static inline void rae_fmt_f32_ptr(RaeFmt* f, const float* v) { rae_fmt_f32(f, *v); }
+RAE_UNUSED static inline void rae_fmt_char_ptr(RaeFmt* f, const uint32_t* v) { rae_fmt_char(f, *v); }
+
+// Same type mapping as rae_ext_rae_str, appending instead of allocating.
+#define rae_fmt_put(F, X) _Generic((X), \
+    int64_t: rae_fmt_i64, \
+    int64_t*: rae_fmt_i64_ptr, \
+    const int64_t*: rae_fmt_i64_ptr, \
+    double: rae_fmt_f64, \
+    double*: rae_fmt_f64_ptr, \
+    const double*: rae_fmt_f64_ptr, \
+    float*: rae_fmt_f32_ptr, \
+    const float*: rae_fmt_f32_ptr, \
+    float: rae_fmt_f32, \
+    bool: rae_fmt_bool, \
+    int8_t: rae_fmt_bool, \
+    rae_String: rae_fmt_str, \
+    rae_String*: rae_fmt_str_ptr, \
+    uint32_t: rae_fmt_char, \
+    uint32_t*: rae_fmt_char_ptr, \
+    unsigned char: rae_fmt_u8, \
+    int16_t: rae_fmt_i64, \
+    uint16_t: rae_fmt_i64, \
+    int32_t: rae_fmt_i64, \
+    uint64_t: rae_fmt_i64, \
+    RaeAny: rae_fmt_any, \
+    default: rae_fmt_str \
+)(F, X)
+
 #ifdef RAE_HAS_WEBGPU
 /* WebGPU context bootstrap accessors (#501). Bound from Rae via extern("…") in
  * lib/webgpu/context.rae. Declared here (not by a WebGPU header) so the
@@ -0,0 +1,602 @@
+/* Runtime allocator for String bodies and Buffer storage.
+ *
+ * This module is included by rae_runtime.c into one translation unit.
+ */
+
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#endif
+#if defined(__linux__) || defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+static int64_t rae_malloc_size_safe(void* p) {
+  if (!p) return 0;
+#if defined(__APPLE__)
+  return (int64_t)malloc_size(p);
+#elif defined(__linux__) || defined(__GLIBC__)
+  return (int64_t)malloc_usable_size(p);
+#else
+  return 0;
+#endif
+}
+
+/* ----- Size-class slabs ------------------------------------------------ */
+/* String temporaries and small List buffers are born and die by the
+ * thousand per frame, and glibc's malloc/free pair (plus the calloc memset
+ * and malloc_usable_size on every buffer free) showed up as 15-25% of
+ * string-heavy UI profiles. Requests up to RAE_SLAB_MAX bytes are served
+ * from 64 KiB chunks that each hold one size class. The chunks are carved
+ * from a single address-space reservation, committed a megabyte at a time,
+ * so a range check and one byte load say whether a pointer is a slab block
+ * and of which class; no header, no lookup.
+ *
+ * Each thread keeps a LIFO free list and a bump range per class, so the
+ * common allocation and free are a handful of instructions with no atomics.
+ * A block freed on another thread goes onto that thread's list (chunks are
+ * not owned by threads); a list that grows past 2 * RAE_SLAB_BATCH blocks
+ * hands a batch to a shared per-class pool under the lock, and an empty
+ * list takes one back before carving new chunk space. Chunks are never
+ * returned to the OS: peak string memory stays mapped, as it does for
+ * glibc's arenas in practice.
+ *
+ * Larger requests, and everything when the reservation is unavailable
+ * (WASM, 32-bit, RAE_ALLOC=libc, or builds defining RAE_ALLOC_LIBC such as
+ * the compiler's own VM, which frees adopted runtime strings with libc
+ * free), go to malloc. rae_free accepts any pointer either path returned,
+ * and pointers from plain malloc too, so a String body produced elsewhere
+ * can still be dropped through rae_ext_rae_str_free.
+ *
+ * Zeroing is on demand: rae_alloc_zeroed skips the memset for blocks
+ * carved from chunk space that was never handed out, which the kernel
+ * already zeroed, and for large blocks leaves it to calloc.
+ *
+ * Frame arenas: between rae_sys_frame_arena_begin and _end, the thread's
+ * allocations bump through its own arena segments instead, frees of arena
+ * blocks are no-ops, and rae_sys_frame_arena_reset releases everything at
+ * once (lib/frame_arena.rae). */
+#if defined(RAE_ALLOC_LIBC) || defined(__wasm__) || defined(_WIN32) || UINTPTR_MAX <= 0xffffffffu
+#define RAE_SLAB_ENABLED 0
+#else
+#define RAE_SLAB_ENABLED 1
+#endif
+
+#define RAE_SLAB_CHUNK_SHIFT 16           /* 64 KiB chunks, one class each */
+#define RAE_SLAB_CHUNK ((size_t)1 << RAE_SLAB_CHUNK_SHIFT)
+#define RAE_SLAB_CHUNKS 65536             /* 4 GiB of address space reserved */
+#define RAE_SLAB_COMMIT 16                /* chunks committed per mprotect */
+#define RAE_SLAB_MAX 1024                 /* larger requests go to malloc */
+#define RAE_SLAB_CLASSES 20
+#define RAE_SLAB_BATCH 64                 /* blocks per shared-pool transfer */
+#define RAE_ARENA_SEG_CHUNKS 16           /* 1 MiB frame arena segments */
+#define RAE_ARENA_HEADER 16               /* size word, keeps 16-byte alignment */
+#define RAE_CHUNK_ARENA 0xff              /* g_rae_chunk_kind: 0 unused, 1+class */
+
+static const uint16_t g_rae_slab_size[RAE_SLAB_CLASSES] = {
+  16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+  320, 384, 448, 512, 640, 768, 896, 1024
+};
+#if RAE_SLAB_ENABLED
+/* Class of a request, indexed by (bytes + 15) / 16. */
+static uint8_t g_rae_slab_class_of[RAE_SLAB_MAX / 16 + 1];
+#endif
+
+typedef struct RaeArenaSeg {
+  struct RaeArenaSeg* next;
+  uint8_t* dirty;                  /* bytes below this were handed out before */
+} RaeArenaSeg;
+
+typedef struct {
+  RaeArenaSeg* head;               /* first segment; reset returns here */
+  RaeArenaSeg* cur;
+  uint8_t* pos;
+  uint8_t* end;
+  int depth;                       /* open begin/end scopes */
+  int64_t used, peak, resets;      /* bytes since the last reset */
+} RaeFrameArena;
+
+typedef struct RaeSlabCache {
+  void* free[RAE_SLAB_CLASSES];
+  uint8_t* bump[RAE_SLAB_CLASSES];
+  uint8_t* bump_end[RAE_SLAB_CLASSES];
+  int32_t free_n[RAE_SLAB_CLASSES];
+  RaeFrameArena arena;
+  int registered;
+  struct RaeSlabCache* next;       /* g_rae_alloc.caches, for stats */
+  int64_t allocs[RAE_SLAB_CLASSES], frees[RAE_SLAB_CLASSES];
+} RaeSlabCache;
+
+static struct {
+  uint8_t* base;
+  uintptr_t span;                  /* bytes reserved; 0 = no slabs */
+  int libc;                        /* RAE_ALLOC=libc or reservation failed */
+  int tried;
+  uint32_t next_chunk, committed;
+  void* pool[RAE_SLAB_CLASSES];    /* chains of freed blocks: word 0 links a chain, word 1 the next chain */
+  int64_t chunks[RAE_SLAB_CLASSES];
+  RaeArenaSeg* arena_spare;        /* segments of exited threads */
+  int64_t arena_segs;
+  RaeSlabCache* caches;
+  RaeSlabCache retired;            /* counters of exited threads */
+  int64_t large_allocs, large_frees, large_bytes;  /* atomic */
+#if RAE_SLAB_ENABLED
+  pthread_mutex_t lock;
+  pthread_key_t key;
+#endif
+} g_rae_alloc = {
+#if RAE_SLAB_ENABLED
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+#endif
+  .base = NULL
+};
+#if RAE_SLAB_ENABLED
+static uint8_t g_rae_chunk_kind[RAE_SLAB_CHUNKS];
+#endif
+static __thread RaeSlabCache g_rae_slab_tls;
+
+/* Large blocks are at least a kilobyte, so shared atomic counters cost
+ * nothing next to the malloc itself. */
+static void* rae_large_alloc(size_t n, int zero) {
+  void* p = zero ? calloc(1, n) : malloc(n);
+  if (p) {
+    __atomic_add_fetch(&g_rae_alloc.large_allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&g_rae_alloc.large_bytes, rae_malloc_size_safe(p), __ATOMIC_RELAXED);
+  }
+  return p;
+}
+
+static void rae_large_free(void* p) {
+  __atomic_add_fetch(&g_rae_alloc.large_frees, 1, __ATOMIC_RELAXED);
+  __atomic_sub_fetch(&g_rae_alloc.large_bytes, rae_malloc_size_safe(p), __ATOMIC_RELAXED);
+  free(p);
+}
+
+static void* rae_large_realloc(void* p, size_t n) {
+  int64_t old = rae_malloc_size_safe(p);
+  void* q = realloc(p, n);
+  if (q) __atomic_add_fetch(&g_rae_alloc.large_bytes, rae_malloc_size_safe(q) - old, __ATOMIC_RELAXED);
+  return q;
+}
+
+#if RAE_SLAB_ENABLED
+
+static inline uintptr_t rae_slab_offset(const void* p) {
+  return (uintptr_t)p - (uintptr_t)g_rae_alloc.base;
+}
+
+static inline int rae_alloc_is_arena(const void* p) {
+  uintptr_t off = rae_slab_offset(p);
+  return off < g_rae_alloc.span && g_rae_chunk_kind[off >> RAE_SLAB_CHUNK_SHIFT] == RAE_CHUNK_ARENA;
+}
+
+static void rae_slab_thread_exit(void* arg);
+
+/* Lock held. Reserve the address range on first use. */
+static int rae_slab_reserve(void) {
+  if (g_rae_alloc.tried) return g_rae_alloc.span != 0;
+  g_rae_alloc.tried = 1;
+  const char* mode = getenv("RAE_ALLOC");
+  if (mode && strcmp(mode, "libc") == 0) { g_rae_alloc.libc = 1; return 0; }
+  size_t bytes = (size_t)RAE_SLAB_CHUNKS << RAE_SLAB_CHUNK_SHIFT;
+  /* Over-reserve one chunk so the base can be chunk-aligned. */
+  void* raw = mmap(NULL, bytes + RAE_SLAB_CHUNK, PROT_NONE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+  if (raw == MAP_FAILED) { g_rae_alloc.libc = 1; return 0; }
+  uintptr_t aligned = ((uintptr_t)raw + RAE_SLAB_CHUNK - 1) & ~(uintptr_t)(RAE_SLAB_CHUNK - 1);
+  for (int i = 0, c = 0; i <= RAE_SLAB_MAX / 16; i++) {
+    while (g_rae_slab_size[c] < i * 16) c++;
+    g_rae_slab_class_of[i] = (uint8_t)c;
+  }
+  pthread_key_create(&g_rae_alloc.key, rae_slab_thread_exit);
+  g_rae_alloc.base = (uint8_t*)aligned;
+  __atomic_store_n(&g_rae_alloc.span, (uintptr_t)bytes, __ATOMIC_RELEASE);
+  return 1;
+}
+
+/* Lock held. `count` contiguous fresh chunks of `kind`, or NULL. */
+static uint8_t* rae_slab_new_chunks(uint32_t count, uint8_t kind) {
+  if (!rae_slab_reserve() || g_rae_alloc.next_chunk + count > RAE_SLAB_CHUNKS) return NULL;
+  uint32_t first = g_rae_alloc.next_chunk;
+  if (first + count > g_rae_alloc.committed) {
+    uint32_t upto = (first + count + RAE_SLAB_COMMIT - 1) / RAE_SLAB_COMMIT * RAE_SLAB_COMMIT;
+    if (upto > RAE_SLAB_CHUNKS) upto = RAE_SLAB_CHUNKS;
+    uint8_t* from = g_rae_alloc.base + ((size_t)g_rae_alloc.committed << RAE_SLAB_CHUNK_SHIFT);
+    if (mprotect(from, (size_t)(upto - g_rae_alloc.committed) << RAE_SLAB_CHUNK_SHIFT, PROT_READ | PROT_WRITE) != 0) return NULL;
+    g_rae_alloc.committed = upto;
+  }
+  g_rae_alloc.next_chunk = first + count;
+  for (uint32_t i = 0; i < count; i++) g_rae_chunk_kind[first + i] = kind;
+  return g_rae_alloc.base + ((size_t)first << RAE_SLAB_CHUNK_SHIFT);
+}
+
+/* Lock held. */
+static void rae_slab_register(RaeSlabCache* t) {
+  t->registered = 1;
+  t->next = g_rae_alloc.caches;
+  g_rae_alloc.caches = t;
+  pthread_setspecific(g_rae_alloc.key, t);
+}
+
+/* Slow path of rae_alloc: the thread's free list for class c is empty. */
+static void* rae_slab_refill(RaeSlabCache* t, unsigned c, int zero) {
+  size_t size = g_rae_slab_size[c];
+  if (t->bump[c] < t->bump_end[c]) {
+    /* Never handed out since the chunk was committed: already zero. */
+    void* p = t->bump[c];
+    t->bump[c] += size;
+    t->allocs[c]++;
+    return p;
+  }
+  pthread_mutex_lock(&g_rae_alloc.lock);
+  if (!t->registered && rae_slab_reserve()) rae_slab_register(t);
+  void* chain = g_rae_alloc.pool[c];
+  if (chain) {
+    g_rae_alloc.pool[c] = ((void**)chain)[1];
+    pthread_mutex_unlock(&g_rae_alloc.lock);
+    t->free[c] = *(void**)chain;
+    t->free_n[c] = RAE_SLAB_BATCH - 1;
+    t->allocs[c]++;
+    if (zero) memset(chain, 0, size);
+    return chain;
+  }
+  uint8_t* chunk = rae_slab_new_chunks(1, (uint8_t)(c + 1));
+  if (chunk) g_rae_alloc.chunks[c]++;
+  pthread_mutex_unlock(&g_rae_alloc.lock);
+  if (!chunk) return rae_large_alloc(size, zero);
+  t->bump[c] = chunk + size;
+  t->bump_end[c] = chunk + (RAE_SLAB_CHUNK / size) * size;
+  t->allocs[c]++;
+  return chunk;
+}
+
+/* Slow path of rae_free. A thread that only frees registers here, so its
+ * blocks and counters are handed back when it exits. Once the free list
+ * holds 2 * RAE_SLAB_BATCH blocks, keep the most recently freed
+ * (cache-warm) half and hand the rest to the shared pool. */
+static void rae_slab_free_slow(RaeSlabCache* t, unsigned c) {
+  if (!t->registered) {
+    pthread_mutex_lock(&g_rae_alloc.lock);
+    rae_slab_register(t);
+    pthread_mutex_unlock(&g_rae_alloc.lock);
+  }
+  if (t->free_n[c] < 2 * RAE_SLAB_BATCH) return;
+  void** keep = (void**)t->free[c];
+  int32_t n = 1;
+  while (n < RAE_SLAB_BATCH && *keep) { keep = (void**)*keep; n++; }
+  void* chain = *keep;
+  t->free_n[c] = n;
+  if (!chain) return;
+  *keep = NULL;
+  pthread_mutex_lock(&g_rae_alloc.lock);
+  ((void**)chain)[1] = g_rae_alloc.pool[c];
+  g_rae_alloc.pool[c] = chain;
+  pthread_mutex_unlock(&g_rae_alloc.lock);
+}
+
+/* ----- Frame arena ----------------------------------------------------- */
+
+static uint8_t* rae_arena_seg_data(RaeArenaSeg* s) { return (uint8_t*)s + RAE_ARENA_HEADER * 2; }
+static uint8_t* rae_arena_seg_end(RaeArenaSeg* s) {
+  return (uint8_t*)s + ((size_t)RAE_ARENA_SEG_CHUNKS << RAE_SLAB_CHUNK_SHIFT);
+}
+
+static void rae_arena_enter_seg(RaeFrameArena* a, RaeArenaSeg* s) {
+  if (a->cur && a->pos > a->cur->dirty) a->cur->dirty = a->pos;
+  a->cur = s;
+  a->pos = rae_arena_seg_data(s);
+  a->end = rae_arena_seg_end(s);
+}
+
+/* Arena block of n bytes, or NULL when the request is too large for a
+ * segment (the caller then uses the heap, and that block frees normally). */
+static void* rae_arena_alloc(RaeFrameArena* a, size_t n, int zero) {
+  size_t need = RAE_ARENA_HEADER + ((n + 15) & ~(size_t)15);
+  if (need > ((size_t)RAE_ARENA_SEG_CHUNKS << RAE_SLAB_CHUNK_SHIFT) / 4) return NULL;
+  if (!a->cur || a->pos + need > a->end) {
+    RaeArenaSeg* next = a->cur ? a->cur->next : a->head;
+    if (!next) {
+      pthread_mutex_lock(&g_rae_alloc.lock);
+      next = g_rae_alloc.arena_spare;
+      if (next) {
+        g_rae_alloc.arena_spare = next->next;
+        next->next = NULL;
+      } else {
+        next = (RaeArenaSeg*)rae_slab_new_chunks(RAE_ARENA_SEG_CHUNKS, RAE_CHUNK_ARENA);
+        if (next) {
+          next->dirty = rae_arena_seg_data(next);
+          g_rae_alloc.arena_segs++;
+        }
+      }
+      pthread_mutex_unlock(&g_rae_alloc.lock);
+      if (!next) return NULL;
+      if (a->cur) a->cur->next = next; else a->head = next;
+    }
+    rae_arena_enter_seg(a, next);
+  }
+  uint8_t* block = a->pos;
+  a->pos += need;
+  a->used += (int64_t)need;
+  *(size_t*)block = n;
+  uint8_t* p = block + RAE_ARENA_HEADER;
+  if (zero && p < a->cur->dirty) memset(p, 0, n);
+  return p;
+}
+
+static size_t rae_arena_block_size(const void* p) {
+  return *(const size_t*)((const uint8_t*)p - RAE_ARENA_HEADER);
+}
+
+/* Thread exit: give free blocks, bump space and arena segments back. */
+static void rae_slab_thread_exit(void* arg) {
+  RaeSlabCache* t = (RaeSlabCache*)arg;
+  for (unsigned c = 0; c < RAE_SLAB_CLASSES; c++) {
+    size_t size = g_rae_slab_size[c];
+    while (t->bump[c] < t->bump_end[c]) {
+      void** b = (void**)t->bump[c];
+      *b = t->free[c];
+      t->free[c] = b;
+      t->bump[c] += size;
+    }
+    while (t->free[c]) {
+      t->free_n[c] = 2 * RAE_SLAB_BATCH;
+      void* chain = t->free[c];
+      t->free[c] = NULL;
+      /* Cut the list into chains; the pool tolerates a short last one. */
+      void** tail = (void**)chain;
+      for (int n = 1; n < RAE_SLAB_BATCH && *tail; n++) tail = (void**)*tail;
+      t->free[c] = *tail;
+      *tail = NULL;
+      pthread_mutex_lock(&g_rae_alloc.lock);
+      ((void**)chain)[1] = g_rae_alloc.pool[c];
+      g_rae_alloc.pool[c] = chain;
+      pthread_mutex_unlock(&g_rae_alloc.lock);
+    }
+    t->free_n[c] = 0;
+  }
+  pthread_mutex_lock(&g_rae_alloc.lock);
+  RaeArenaSeg* s = t->arena.head;
+  while (s) {
+    RaeArenaSeg* next = s->next;
+    if (s == t->arena.cur && t->arena.pos > s->dirty) s->dirty = t->arena.pos;
+    s->next = g_rae_alloc.arena_spare;
+    g_rae_alloc.arena_spare = s;
+    s = next;
+  }
+  memset(&t->arena, 0, sizeof(t->arena));
+  for (RaeSlabCache** link = &g_rae_alloc.caches; *link; link = &(*link)->next) {
+    if (*link == t) { *link = t->next; break; }
+  }
+  for (unsigned c = 0; c < RAE_SLAB_CLASSES; c++) {
+    g_rae_alloc.retired.allocs[c] += t->allocs[c];
+    g_rae_alloc.retired.frees[c] += t->frees[c];
+    t->allocs[c] = t->frees[c] = 0;
+  }
+  t->registered = 0;
+  pthread_mutex_unlock(&g_rae_alloc.lock);
+}
+
+/* Slab or malloc block, never the frame arena. */
+static inline void* rae_heap_alloc_impl(RaeSlabCache* t, size_t n, int zero) {
+  if (n - 1 < RAE_SLAB_MAX && !g_rae_alloc.libc) {
+    unsigned c = g_rae_slab_class_of[(n + 15) >> 4];
+    if (g_rae_alloc.span) {
+      void** p = (void**)t->free[c];
+      if (p) {
+        t->free[c] = *p;
+        t->free_n[c]--;
+        t->allocs[c]++;
+        if (zero) memset(p, 0, n);
+        return p;
+      }
+    } else {
+      /* The class table is filled with the reservation: size it here. */
+      c = 0;
+      while (g_rae_slab_size[c] < n) c++;
+    }
+    return rae_slab_refill(t, c, zero);
+  }
+  return rae_large_alloc(n, zero);
+}
+
+static inline void* rae_alloc_impl(size_t n, int zero) {
+  RaeSlabCache* t = &g_rae_slab_tls;
+  if (__builtin_expect(t->arena.depth > 0, 0)) {
+    void* p = rae_arena_alloc(&t->arena, n, zero);
+    if (p) return p;
+  }
+  return rae_heap_alloc_impl(t, n, zero);
+}
+
+static inline void rae_free(void* p) {
+  if (!p) return;
+  uintptr_t off = rae_slab_offset(p);
+  if (off < g_rae_alloc.span) {
+    uint8_t kind = g_rae_chunk_kind[off >> RAE_SLAB_CHUNK_SHIFT];
+    if (kind == RAE_CHUNK_ARENA) return;   /* released by the arena reset */
+    unsigned c = kind - 1u;
+    RaeSlabCache* t = &g_rae_slab_tls;
+    *(void**)p = t->free[c];
+    t->free[c] = p;
+    t->frees[c]++;
+    if (++t->free_n[c] >= 2 * RAE_SLAB_BATCH || !t->registered) rae_slab_free_slow(t, c);
+    return;
+  }
+  rae_large_free(p);
+}
+
+/* Usable bytes of a block from any rae_alloc path. */
+static int64_t rae_alloc_size(void* p) {
+  if (!p) return 0;
+  uintptr_t off = rae_slab_offset(p);
+  if (off < g_rae_alloc.span) {
+    uint8_t kind = g_rae_chunk_kind[off >> RAE_SLAB_CHUNK_SHIFT];
+    return kind == RAE_CHUNK_ARENA ? (int64_t)rae_arena_block_size(p) : (int64_t)g_rae_slab_size[kind - 1u];
+  }
+  return rae_malloc_size_safe(p);
+}
+
+/* Slab and arena blocks move by copy (a request that still fits keeps
+ * its block); malloc blocks stay with realloc. Only an arena block may
+ * move into the arena: a List made before a frame scope and grown inside
+ * it must outlive the scope's reset. */
+static void* rae_realloc(void* p, size_t n) {
+  if (!p) return rae_alloc_impl(n, 0);
+  if (rae_slab_offset(p) >= g_rae_alloc.span) return rae_large_realloc(p, n);
+  size_t old = (size_t)rae_alloc_size(p);
+  if (n <= old) return p;
+  void* q = rae_alloc_is_arena(p) ? rae_alloc_impl(n, 0) : rae_heap_alloc_impl(&g_rae_slab_tls, n, 0);
+  if (!q) return NULL;
+  memcpy(q, p, old);
+  rae_free(p);
+  return q;
+}
+
+#else /* !RAE_SLAB_ENABLED */
+
+static inline int rae_alloc_is_arena(const void* p) { (void)p; return 0; }
+
+static inline void* rae_alloc_impl(size_t n, int zero) { return rae_large_alloc(n, zero); }
+
+static inline void rae_free(void* p) {
+  if (p) rae_large_free(p);
+}
+
+static int64_t rae_alloc_size(void* p) { return rae_malloc_size_safe(p); }
+
+static void* rae_realloc(void* p, size_t n) {
+  return p ? rae_large_realloc(p, n) : rae_large_alloc(n, 0);
+}
+
+#endif /* RAE_SLAB_ENABLED */
+
+static inline void* rae_alloc(size_t n) { return rae_alloc_impl(n, 0); }
+static inline void* rae_alloc_zeroed(size_t n) { return rae_alloc_impl(n, 1); }
+
+/* For header inlines compiled into the generated program's own TU. */
+void* rae_mem_alloc(size_t bytes) { return rae_alloc(bytes); }
+void rae_mem_free(void* p) { rae_free(p); }
+
+/* ----- Frame arena scopes (lib/frame_arena.rae) ------------------------ */
+
+void rae_ext_rae_sys_frame_arena_begin(void) {
+  g_rae_slab_tls.arena.depth++;
+}
+
+void rae_ext_rae_sys_frame_arena_end(void) {
+  if (g_rae_slab_tls.arena.depth > 0) g_rae_slab_tls.arena.depth--;
+}
+
+/* Release every block the thread's arena handed out. Refused (false) while
+ * a scope is open, since its caller may still hold blocks from it. */
+rae_Bool rae_ext_rae_sys_frame_arena_reset(void) {
+  RaeFrameArena* a = &g_rae_slab_tls.arena;
+  if (a->depth > 0) return 0;
+  if (a->used > a->peak) a->peak = a->used;
+  a->used = 0;
+  a->resets++;
+#if RAE_SLAB_ENABLED
+  if (!a->head) return 1;
+  if (a->pos > a->cur->dirty) a->cur->dirty = a->pos;
+#ifdef RAE_DEBUG_BOUNDS
+  /* A block kept past the reset now reads as 0xdd instead of stale data. */
+  for (RaeArenaSeg* s = a->head; s; s = s->next) {
+    memset(rae_arena_seg_data(s), 0xdd, (size_t)(s->dirty - rae_arena_seg_data(s)));
+  }
+#endif
+  a->cur = NULL;
+  rae_arena_enter_seg(a, a->head);
+#endif
+  return 1;
+}
+
+int64_t rae_ext_rae_sys_frame_arena_used(void) {
+  return g_rae_slab_tls.arena.used;
+}
+
+int64_t rae_ext_rae_sys_frame_arena_peak(void) {
+  RaeFrameArena* a = &g_rae_slab_tls.arena;
+  return a->used > a->peak ? a->used : a->peak;
+}
+
+/* ----- Statistics ------------------------------------------------------- */
+/* Live blocks per class are allocations minus frees summed over every
+ * thread cache (a block freed on another thread lowers that thread's
+ * count), read without stopping the threads: exact at quiescence, close
+ * enough mid-run. */
+static void rae_alloc_stats_collect(int64_t* live_n, int64_t* total_n) {
+  for (unsigned c = 0; c < RAE_SLAB_CLASSES; c++) live_n[c] = total_n[c] = 0;
+#if RAE_SLAB_ENABLED
+  pthread_mutex_lock(&g_rae_alloc.lock);
+  for (unsigned c = 0; c < RAE_SLAB_CLASSES; c++) {
+    live_n[c] = g_rae_alloc.retired.allocs[c] - g_rae_alloc.retired.frees[c];
+    total_n[c] = g_rae_alloc.retired.allocs[c];
+  }
+  for (RaeSlabCache* t = g_rae_alloc.caches; t; t = t->next) {
+    for (unsigned c = 0; c < RAE_SLAB_CLASSES; c++) {
+      live_n[c] += t->allocs[c] - t->frees[c];
+      total_n[c] += t->allocs[c];
+    }
+  }
+  pthread_mutex_unlock(&g_rae_alloc.lock);
+#endif
+}
+
+/* Bytes in live String and Buffer blocks: slab blocks at their class size,
+ * malloc blocks at their usable size. Frame arena blocks are not counted. */
+int64_t rae_ext_rae_mem_live_bytes(void) {
+  int64_t live_n[RAE_SLAB_CLASSES], total_n[RAE_SLAB_CLASSES];
+  rae_alloc_stats_collect(live_n, total_n);
+  int64_t bytes = __atomic_load_n(&g_rae_alloc.large_bytes, __ATOMIC_RELAXED);
+  for (unsigned c = 0; c < RAE_SLAB_CLASSES; c++) bytes += live_n[c] * g_rae_slab_size[c];
+  return bytes;
+}
+
+static void rae_alloc_stats_print(void) {
+  int64_t live_n[RAE_SLAB_CLASSES], total_n[RAE_SLAB_CLASSES];
+  rae_alloc_stats_collect(live_n, total_n);
+  for (unsigned c = 0; c < RAE_SLAB_CLASSES; c++) {
+    if (!total_n[c]) continue;
+    fprintf(stderr, "  [mem:slab %4uB          ] alloc=%lld live=%lld (%lld B) chunks=%lld\n",
+      (unsigned)g_rae_slab_size[c], (long long)total_n[c], (long long)live_n[c],
+      (long long)(live_n[c] * g_rae_slab_size[c]), (long long)g_rae_alloc.chunks[c]);
+  }
+  int64_t la = __atomic_load_n(&g_rae_alloc.large_allocs, __ATOMIC_RELAXED);
+  int64_t lf = __atomic_load_n(&g_rae_alloc.large_frees, __ATOMIC_RELAXED);
+  fprintf(stderr, "  [mem:malloc            ] alloc=%lld live=%lld (%lld B)%s\n",
+    (long long)la, (long long)(la - lf),
+    (long long)__atomic_load_n(&g_rae_alloc.large_bytes, __ATOMIC_RELAXED),
+    g_rae_alloc.libc ? " (slabs off: RAE_ALLOC=libc or no reservation)" : "");
+  if (g_rae_alloc.arena_segs) {
+    fprintf(stderr, "  [mem:frame arena       ] segments=%lld (%lld KiB)\n",
+      (long long)g_rae_alloc.arena_segs,
+      (long long)(g_rae_alloc.arena_segs * ((int64_t)RAE_ARENA_SEG_CHUNKS << RAE_SLAB_CHUNK_SHIFT) / 1024));
+  }
+}
+
+/* Per-site attribution (RAE_MEM_STATS=1) keeps each slab block's site in a
+ * byte array per chunk, allocated when the chunk first holds a tagged
+ * block, so only malloc blocks need the side hash. NULL for those. */
+#if RAE_SLAB_ENABLED
+static uint8_t** g_rae_chunk_sites;
+#endif
+
+static uint8_t* rae_alloc_site_slot(void* p) {
+#if RAE_SLAB_ENABLED
+  uintptr_t off = rae_slab_offset(p);
+  if (off >= g_rae_alloc.span) return NULL;
+  uint32_t chunk = (uint32_t)(off >> RAE_SLAB_CHUNK_SHIFT);
+  uint8_t kind = g_rae_chunk_kind[chunk];
+  if (kind == RAE_CHUNK_ARENA) return NULL;
+  size_t size = g_rae_slab_size[kind - 1u];
+  if (!g_rae_chunk_sites || !g_rae_chunk_sites[chunk]) {
+    pthread_mutex_lock(&g_rae_alloc.lock);
+    if (!g_rae_chunk_sites) g_rae_chunk_sites = (uint8_t**)calloc(RAE_SLAB_CHUNKS, sizeof(uint8_t*));
+    if (g_rae_chunk_sites && !g_rae_chunk_sites[chunk]) g_rae_chunk_sites[chunk] = (uint8_t*)calloc(RAE_SLAB_CHUNK / size, 1);
+    pthread_mutex_unlock(&g_rae_alloc.lock);
+    if (!g_rae_chunk_sites || !g_rae_chunk_sites[chunk]) return NULL;
+  }
+  return &g_rae_chunk_sites[chunk][(off & (RAE_SLAB_CHUNK - 1)) / size];
+#else
+  (void)p;
+  return NULL;
+#endif
+}
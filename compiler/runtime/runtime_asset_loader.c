@@ -0,0 +1,449 @@
+/* Background asset loader: a worker pool that decodes images off the calling
+ * thread and hands results back through a lock-free completion queue. Threads,
+ * atomics and the codec calls are permanent C kernel; request bookkeeping,
+ * glTF parsing and registry policy live in lib/asset_loader.rae.
+ *
+ * This module is included by rae_runtime.c into one translation unit, after
+ * runtime_image_sdl3.c (it calls rae_image_decode_rgba).
+ */
+
+/* ----- Asset loader (lib/asset_loader.rae) ---------------------------- */
+/* A loader owns N worker threads and a table of jobs addressed by 1-based
+ * Int ids. Two kinds of job share the table:
+ *   - IMAGE: decoded to RGBA8 by a worker (rae_image_decode_rgba).
+ *   - EXTERNAL: run elsewhere (the Rae side spawns a task to parse a glTF);
+ *     the loader only orders, cancels and reports it.
+ * Queued jobs are picked highest-priority first, FIFO among equals; the
+ * submit side is a mutex + condvar (submission is rare, workers sleep).
+ *
+ * Completion is the per-frame path, so it is lock-free: a finishing worker
+ * CAS-pushes its job onto an intrusive Treiber stack (`done_head`). The
+ * single consumer (the thread that polls) swaps the whole stack out with one
+ * atomic exchange and reverses it into a private FIFO (`ready`), so there is
+ * no ABA and a poll with nothing finished is one relaxed load. Job fields a
+ * worker writes (pixels, size, state) are published by the release-ordered
+ * push and read after the acquire-ordered exchange.
+ *
+ * Cancellation: a still-queued job is removed outright (no work done); a
+ * running or finished-but-unpolled job is flagged and its result is dropped
+ * when the poll reaches it, so a cancelled id is never reported.
+ *
+ * Single-threaded wasm has no workers: requests decode inline and complete
+ * immediately, keeping the poll contract identical. */
+#define RAE_ASSET_IMAGE 0
+#define RAE_ASSET_EXTERNAL 1
+
+/* Job states; the order is AssetStatus in lib/asset_loader.rae. */
+#define RAE_ASSET_QUEUED 0
+#define RAE_ASSET_RUNNING 1
+#define RAE_ASSET_DONE 2
+#define RAE_ASSET_FAILED 3
+#define RAE_ASSET_CANCELLED 4
+
+#if !defined(__wasm__) || defined(RAE_WASM_THREADS)
+#define RAE_ASSET_THREADS 1
+#else
+#define RAE_ASSET_THREADS 0
+#endif
+
+typedef struct RaeAssetJob {
+  int64_t id;
+  int kind;
+  char* path;
+  int64_t priority;
+  int64_t seq;             /* submission order, the FIFO tiebreak */
+  int state;               /* RAE_ASSET_*; atomic */
+  int cancelled;           /* atomic */
+  int polled;              /* consumer-only: popped off the completion queue */
+  unsigned char* rgba;     /* IMAGE result, malloc'd; NULL once taken */
+  unsigned w, h;
+  const char* err;         /* IMAGE: static reason string on failure */
+  struct RaeAssetJob* next_done;
+} RaeAssetJob;
+
+typedef struct {
+  pthread_mutex_t mu;
+  pthread_cond_t cv;
+  pthread_t* threads;
+  int nthreads;
+  int shutdown;
+  RaeAssetJob** jobs;      /* by id - 1; entries are stable heap pointers */
+  int64_t njobs, jobs_cap;
+  RaeAssetJob** queue;     /* queued jobs of both kinds, unordered */
+  int64_t nqueue, queue_cap;
+  int64_t seq;
+  RaeAssetJob* done_head;  /* lock-free completion stack (multi-producer) */
+  RaeAssetJob* ready;      /* consumer-private FIFO drained by poll */
+  int64_t outstanding;     /* requested, not yet polled or cancelled */
+} RaeAssetLoader;
+
+static void rae_asset_lock(RaeAssetLoader* L) {
+#if RAE_ASSET_THREADS
+  pthread_mutex_lock(&L->mu);
+#else
+  (void)L;
+#endif
+}
+
+static void rae_asset_unlock(RaeAssetLoader* L) {
+#if RAE_ASSET_THREADS
+  pthread_mutex_unlock(&L->mu);
+#else
+  (void)L;
+#endif
+}
+
+/* Job by id, or NULL. Caller holds the lock (the table may grow). */
+static RaeAssetJob* rae_asset_find(RaeAssetLoader* L, int64_t id) {
+  if (!L || id < 1 || id > L->njobs) return NULL;
+  return L->jobs[id - 1];
+}
+
+static RaeAssetJob* rae_asset_job_locked(int64_t loader, int64_t id) {
+  RaeAssetLoader* L = (RaeAssetLoader*)(intptr_t)loader;
+  if (!L) return NULL;
+  rae_asset_lock(L);
+  RaeAssetJob* j = rae_asset_find(L, id);
+  rae_asset_unlock(L);
+  return j;
+}
+
+static void rae_asset_push_done(RaeAssetLoader* L, RaeAssetJob* j) {
+  RaeAssetJob* head = __atomic_load_n(&L->done_head, __ATOMIC_RELAXED);
+  do {
+    j->next_done = head;
+  } while (!__atomic_compare_exchange_n(&L->done_head, &head, j, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static void rae_asset_run_image(RaeAssetJob* j) {
+  unsigned char* rgba = NULL; unsigned w = 0, h = 0;
+  const char* why = "decode failed";
+  int ok = 0;
+  if (__atomic_load_n(&j->cancelled, __ATOMIC_ACQUIRE)) {
+    why = "cancelled";
+  } else {
+    ok = rae_image_decode_rgba(j->path, &rgba, &w, &h, &why);
+  }
+  j->rgba = rgba; j->w = w; j->h = h;
+  j->err = ok ? "" : why;
+  __atomic_store_n(&j->state, ok ? RAE_ASSET_DONE : RAE_ASSET_FAILED, __ATOMIC_RELEASE);
+}
+
+/* Remove and return the best queued job of `kind`, or NULL. Lock held. */
+static RaeAssetJob* rae_asset_pick(RaeAssetLoader* L, int kind) {
+  int64_t best = -1;
+  for (int64_t i = 0; i < L->nqueue; i++) {
+    RaeAssetJob* q = L->queue[i];
+    if (q->kind != kind) continue;
+    if (best < 0 || q->priority > L->queue[best]->priority
+        || (q->priority == L->queue[best]->priority && q->seq < L->queue[best]->seq)) {
+      best = i;
+    }
+  }
+  if (best < 0) return NULL;
+  RaeAssetJob* j = L->queue[best];
+  L->queue[best] = L->queue[--L->nqueue];
+  __atomic_store_n(&j->state, RAE_ASSET_RUNNING, __ATOMIC_RELAXED);
+  return j;
+}
+
+#if RAE_ASSET_THREADS
+static void* rae_asset_worker(void* arg) {
+  RaeAssetLoader* L = (RaeAssetLoader*)arg;
+  for (;;) {
+    pthread_mutex_lock(&L->mu);
+    RaeAssetJob* j = NULL;
+    while (!L->shutdown && (j = rae_asset_pick(L, RAE_ASSET_IMAGE)) == NULL) {
+      pthread_cond_wait(&L->cv, &L->mu);
+    }
+    pthread_mutex_unlock(&L->mu);
+    if (!j) return NULL;   /* shutdown */
+    rae_asset_run_image(j);
+    rae_asset_push_done(L, j);
+  }
+}
+#endif
+
+int64_t rae_ext_rae_asset_loader_new(int64_t workers) {
+  RaeAssetLoader* L = (RaeAssetLoader*)calloc(1, sizeof(RaeAssetLoader));
+  if (!L) return 0;
+#if RAE_ASSET_THREADS
+  pthread_mutex_init(&L->mu, NULL);
+  pthread_cond_init(&L->cv, NULL);
+  if (workers < 1) workers = 1;
+  if (workers > 64) workers = 64;
+  L->threads = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)workers);
+  for (int64_t i = 0; i < workers; i++) {
+    if (pthread_create(&L->threads[L->nthreads], NULL, rae_asset_worker, L) == 0) L->nthreads++;
+  }
+#else
+  (void)workers;
+#endif
+  return (int64_t)(intptr_t)L;
+}
+
+static int64_t rae_asset_submit(int64_t loader, int kind, rae_String path, int64_t priority) {
+  RaeAssetLoader* L = (RaeAssetLoader*)(intptr_t)loader;
+  if (!L) return 0;
+  RaeAssetJob* j = (RaeAssetJob*)calloc(1, sizeof(RaeAssetJob));
+  if (!j) return 0;
+  size_t n = path.data ? (size_t)path.len : 0;
+  j->path = (char*)malloc(n + 1);
+  if (n) memcpy(j->path, path.data, n);
+  j->path[n] = '\0';
+  j->kind = kind;
+  j->priority = priority;
+  j->err = "";
+  rae_asset_lock(L);
+  if (L->njobs == L->jobs_cap) {
+    L->jobs_cap = L->jobs_cap ? L->jobs_cap * 2 : 64;
+    L->jobs = (RaeAssetJob**)realloc(L->jobs, sizeof(RaeAssetJob*) * (size_t)L->jobs_cap);
+  }
+  if (L->nqueue == L->queue_cap) {
+    L->queue_cap = L->queue_cap ? L->queue_cap * 2 : 64;
+    L->queue = (RaeAssetJob**)realloc(L->queue, sizeof(RaeAssetJob*) * (size_t)L->queue_cap);
+  }
+  L->jobs[L->njobs++] = j;
+  j->id = L->njobs;
+  j->seq = L->seq++;
+  L->queue[L->nqueue++] = j;
+  L->outstanding++;
+#if RAE_ASSET_THREADS
+  if (kind == RAE_ASSET_IMAGE) pthread_cond_signal(&L->cv);
+#endif
+  rae_asset_unlock(L);
+#if !RAE_ASSET_THREADS
+  if (kind == RAE_ASSET_IMAGE) {
+    RaeAssetJob* run = rae_asset_pick(L, RAE_ASSET_IMAGE);
+    if (run) { rae_asset_run_image(run); rae_asset_push_done(L, run); }
+  }
+#endif
+  return j->id;
+}
+
+/* Queue `path` for decode; returns the job id (0 on failure). */
+int64_t rae_ext_rae_asset_request_image(int64_t loader, rae_String path, int64_t priority) {
+  return rae_asset_submit(loader, RAE_ASSET_IMAGE, path, priority);
+}
+
+/* Queue an EXTERNAL job; the caller starts it via _next_external. */
+int64_t rae_ext_rae_asset_request_external(int64_t loader, rae_String path, int64_t priority) {
+  return rae_asset_submit(loader, RAE_ASSET_EXTERNAL, path, priority);
+}
+
+/* Highest-priority queued EXTERNAL job, now marked running (0 if none). */
+int64_t rae_ext_rae_asset_next_external(int64_t loader) {
+  RaeAssetLoader* L = (RaeAssetLoader*)(intptr_t)loader;
+  if (!L) return 0;
+  rae_asset_lock(L);
+  RaeAssetJob* j = rae_asset_pick(L, RAE_ASSET_EXTERNAL);
+  rae_asset_unlock(L);
+  return j ? j->id : 0;
+}
+
+/* Post an EXTERNAL job's outcome. Callable from any thread. The outcome is
+ * one CAS out of RUNNING, so of two racing posts (or a post racing cancel's
+ * CAS out of QUEUED) exactly one wins, and the job is queued for poll once.
+ * Its error text follows from the state alone (rae_ext_rae_asset_error), so
+ * nothing else is written. */
+void rae_ext_rae_asset_complete(int64_t loader, int64_t job, rae_Bool ok) {
+  RaeAssetLoader* L = (RaeAssetLoader*)(intptr_t)loader;
+  RaeAssetJob* j = rae_asset_job_locked(loader, job);
+  if (!j || j->kind != RAE_ASSET_EXTERNAL) return;
+  int running = RAE_ASSET_RUNNING;
+  if (!__atomic_compare_exchange_n(&j->state, &running, ok ? RAE_ASSET_DONE : RAE_ASSET_FAILED,
+                                   0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) return;
+  rae_asset_push_done(L, j);
+}
+
+/* Re-rank a job; only affects it while it is still queued. */
+void rae_ext_rae_asset_set_priority(int64_t loader, int64_t job, int64_t priority) {
+  RaeAssetLoader* L = (RaeAssetLoader*)(intptr_t)loader;
+  if (!L) return;
+  rae_asset_lock(L);
+  RaeAssetJob* j = rae_asset_find(L, job);
+  if (j) j->priority = priority;
+  rae_asset_unlock(L);
+}
+
+/* Cancel a job. Returns true when it was still queued (no work was spent);
+ * false when it had already started or finished — its result is then
+ * discarded at poll time instead. Either way the id is never reported. */
+rae_Bool rae_ext_rae_asset_cancel(int64_t loader, int64_t job) {
+  RaeAssetLoader* L = (RaeAssetLoader*)(intptr_t)loader;
+  if (!L) return 0;
+  rae_Bool saved = 0;
+  rae_asset_lock(L);
+  RaeAssetJob* j = rae_asset_find(L, job);
+  if (j && !j->polled && !__atomic_load_n(&j->cancelled, __ATOMIC_RELAXED)) {
+    __atomic_store_n(&j->cancelled, 1, __ATOMIC_RELEASE);
+    int queued = RAE_ASSET_QUEUED;
+    if (__atomic_compare_exchange_n(&j->state, &queued, RAE_ASSET_CANCELLED,
+                                    0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+      for (int64_t i = 0; i < L->nqueue; i++) {
+        if (L->queue[i] == j) { L->queue[i] = L->queue[--L->nqueue]; break; }
+      }
+      j->polled = 1;
+      L->outstanding--;
+      saved = 1;
+    }
+  }
+  rae_asset_unlock(L);
+  return saved;
+}
+
+/* Next finished job id in completion order, or 0 when nothing is ready.
+ * Consumer thread only. Cancelled results are freed and skipped. */
+int64_t rae_ext_rae_asset_poll(int64_t loader) {
+  RaeAssetLoader* L = (RaeAssetLoader*)(intptr_t)loader;
+  if (!L) return 0;
+  for (;;) {
+    if (!L->ready) {
+      if (!__atomic_load_n(&L->done_head, __ATOMIC_RELAXED)) return 0;
+      RaeAssetJob* stack = __atomic_exchange_n(&L->done_head, NULL, __ATOMIC_ACQUIRE);
+      RaeAssetJob* fifo = NULL;
+      while (stack) {
+        RaeAssetJob* next = stack->next_done;
+        stack->next_done = fifo;
+        fifo = stack;
+        stack = next;
+      }
+      L->ready = fifo;
+      if (!L->ready) return 0;
+    }
+    RaeAssetJob* j = L->ready;
+    L->ready = j->next_done;
+    j->next_done = NULL;
+    rae_asset_lock(L);
+    j->polled = 1;
+    L->outstanding--;
+    int dropped = __atomic_load_n(&j->cancelled, __ATOMIC_ACQUIRE);
+    if (dropped) __atomic_store_n(&j->state, RAE_ASSET_CANCELLED, __ATOMIC_RELAXED);
+    rae_asset_unlock(L);
+    if (dropped) {
+      free(j->rgba); j->rgba = NULL;
+      continue;
+    }
+    return j->id;
+  }
+}
+
+/* Requested jobs not yet reported by poll (or cancelled). */
+int64_t rae_ext_rae_asset_outstanding(int64_t loader) {
+  RaeAssetLoader* L = (RaeAssetLoader*)(intptr_t)loader;
+  if (!L) return 0;
+  rae_asset_lock(L);
+  int64_t n = L->outstanding;
+  rae_asset_unlock(L);
+  return n;
+}
+
+int64_t rae_ext_rae_asset_status(int64_t loader, int64_t job) {
+  RaeAssetJob* j = rae_asset_job_locked(loader, job);
+  if (!j) return RAE_ASSET_FAILED;
+  return __atomic_load_n(&j->state, __ATOMIC_ACQUIRE);
+}
+
+rae_String rae_ext_rae_asset_error(int64_t loader, int64_t job) {
+  RaeAssetJob* j = rae_asset_job_locked(loader, job);
+  const char* e = "unknown job";
+  if (j) {
+    int state = __atomic_load_n(&j->state, __ATOMIC_ACQUIRE);
+    if (j->kind == RAE_ASSET_EXTERNAL) e = state == RAE_ASSET_FAILED ? "load failed" : "";
+    else e = state < RAE_ASSET_DONE ? "" : j->err;
+  }
+  return (rae_String){ (uint8_t*)e, (int64_t)strlen(e), 0, 0 };
+}
+
+rae_String rae_ext_rae_asset_path(int64_t loader, int64_t job) {
+  RaeAssetJob* j = rae_asset_job_locked(loader, job);
+  const char* p = j ? j->path : "";
+  return (rae_String){ (uint8_t*)p, (int64_t)strlen(p), 0, 0 };
+}
+
+int64_t rae_ext_rae_asset_width(int64_t loader, int64_t job) {
+  RaeAssetJob* j = rae_asset_job_locked(loader, job);
+  if (!j || __atomic_load_n(&j->state, __ATOMIC_ACQUIRE) != RAE_ASSET_DONE) return 0;
+  return (int64_t)j->w;
+}
+
+int64_t rae_ext_rae_asset_height(int64_t loader, int64_t job) {
+  RaeAssetJob* j = rae_asset_job_locked(loader, job);
+  if (!j || __atomic_load_n(&j->state, __ATOMIC_ACQUIRE) != RAE_ASSET_DONE) return 0;
+  return (int64_t)j->h;
+}
+
+/* Hand a finished IMAGE job's RGBA8 bytes to the caller (who frees them).
+ * NULL if the job did not decode or was already taken. Used by gpu2d's
+ * upload path, so only the texture upload runs on the render thread. */
+unsigned char* rae_asset_take_rgba(int64_t loader, int64_t job, unsigned* w, unsigned* h) {
+  RaeAssetJob* j = rae_asset_job_locked(loader, job);
+  if (w) *w = 0;
+  if (h) *h = 0;
+  if (!j || __atomic_load_n(&j->state, __ATOMIC_ACQUIRE) != RAE_ASSET_DONE) return NULL;
+  unsigned char* rgba = j->rgba;
+  j->rgba = NULL;
+  if (rgba) {
+    if (w) *w = j->w;
+    if (h) *h = j->h;
+  }
+  return rgba;
+}
+
+/* Copy a finished IMAGE job out as packed 0xAARRGGBB Ints (the layout of
+ * image.loadPng) and release its RGBA bytes. Writes the size through the
+ * out-params; an empty buffer and width 0 when there is nothing to take. */
+void* rae_ext_rae_asset_take_pixels(int64_t loader, int64_t job, rae_Mod_Int64 w, rae_Mod_Int64 h) {
+  int64_t* w_out = w.ptr;
+  int64_t* h_out = h.ptr;
+  unsigned uw = 0, uh = 0;
+  unsigned char* rgba = rae_asset_take_rgba(loader, job, &uw, &uh);
+  if (w_out) *w_out = 0;
+  if (h_out) *h_out = 0;
+  if (!rgba) return NULL;
+  size_t count = (size_t)uw * (size_t)uh;
+  int64_t* pixels = (int64_t*)rae_ext_rae_buf_alloc((int64_t)count, (int64_t)sizeof(int64_t));
+  if (!pixels) { free(rgba); return NULL; }
+  for (size_t i = 0; i < count; i++) {
+    const unsigned char* p = rgba + i * 4;
+    pixels[i] = ((int64_t)p[3] << 24) | ((int64_t)p[0] << 16) | ((int64_t)p[1] << 8) | (int64_t)p[2];
+  }
+  free(rgba);
+  if (w_out) *w_out = (int64_t)uw;
+  if (h_out) *h_out = (int64_t)uh;
+  return pixels;
+}
+
+/* Free a job's result bytes early (the table entry stays, so the id keeps
+ * answering status queries). */
+void rae_ext_rae_asset_release(int64_t loader, int64_t job) {
+  unsigned w = 0, h = 0;
+  free(rae_asset_take_rgba(loader, job, &w, &h));
+}
+
+/* Stop the workers (queued jobs are abandoned, running ones finish), join
+ * them, and free every job. Owner thread only; EXTERNAL work must be joined
+ * by its owner first. */
+void rae_ext_rae_asset_loader_free(int64_t loader) {
+  RaeAssetLoader* L = (RaeAssetLoader*)(intptr_t)loader;
+  if (!L) return;
+#if RAE_ASSET_THREADS
+  pthread_mutex_lock(&L->mu);
+  L->shutdown = 1;
+  pthread_cond_broadcast(&L->cv);
+  pthread_mutex_unlock(&L->mu);
+  for (int i = 0; i < L->nthreads; i++) pthread_join(L->threads[i], NULL);
+  pthread_cond_destroy(&L->cv);
+  pthread_mutex_destroy(&L->mu);
+#endif
+  for (int64_t i = 0; i < L->njobs; i++) {
+    free(L->jobs[i]->rgba);
+    free(L->jobs[i]->path);
+    free(L->jobs[i]);
+  }
+  free(L->jobs);
+  free(L->queue);
+  free(L->threads);
+  free(L);
+}
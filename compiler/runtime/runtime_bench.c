@@ -0,0 +1,389 @@
+/* Benchmark harness behind `rae bench`.
+ *
+ * This module is included by rae_runtime.c into one translation unit.
+ */
+
+/* ----- Benchmark runner ------------------------------------------------- */
+/* `rae bench file.rae` builds the program in release mode with a generated
+ * main (c_backend.c) that hands every `bench` function to rae_bench_main:
+ *
+ *   func sumInts(n: view Int) bench ret Int { ... }
+ *
+ * A bench function runs its workload n times and returns a checksum; the
+ * harness keeps the checksums so the optimizer can't drop the work.
+ *
+ * Per benchmark:
+ *   calibrate  double n until one call takes a millisecond, then scale it
+ *              so one sample (one call) takes --sample-ms.
+ *   warm up    call it for --warmup-ms first (caches, allocator, branch
+ *              predictors, CPU frequency).
+ *   sample     --samples timed calls, each giving ns per iteration.
+ *   outliers   samples outside the Tukey fences (1.5 IQR past the
+ *              quartiles) are dropped: preemption, page faults, migration.
+ *   report     median, mean and the 95% confidence interval of the mean
+ *              (Student t) of the samples kept.
+ *   counters   the perf counters (runtime_perf_counters.c) are read around
+ *              each sample; the kept samples give IPC and cache misses,
+ *              branch misses and page faults per iteration. Counters the
+ *              machine lacks are left out; --no-counters skips them all.
+ *
+ * --save writes the results as a JSON baseline. --baseline compares against
+ * one: a benchmark is a regression when every kept sample is slower than the
+ * baseline mean by more than --threshold percent, or when Welch's t-test says
+ * its mean moved (95%) and the slowdown is above the threshold. The first
+ * test holds however noisy the run is; when only Welch could decide and too
+ * few samples were kept, the verdict is "inconclusive". Any regression makes
+ * the exit status 1, so a CI job can gate on it; 2 is a usage error. */
+#define RAE_BENCH_MAX_SAMPLES 1000
+/* Fewer kept samples than this and Welch's test can't settle a change. */
+#define RAE_BENCH_MIN_WELCH_SAMPLES 10
+
+typedef struct {
+  const char* filter;
+  int samples;
+  int64_t sample_ns;
+  int64_t warmup_ns;
+  const char* save_path;
+  const char* baseline_path;
+  double threshold;
+  int counters;
+} RaeBenchOptions;
+
+typedef struct {
+  const char* name;
+  int64_t iterations;
+  int samples, outliers;
+  double median, mean, stddev, ci, min, max;  /* max: not saved */
+  double per_iter[RAE_PERF_COUNT];  /* counter per iteration; NAN if missing */
+} RaeBenchResult;
+
+typedef struct {
+  double ns;                        /* per iteration */
+  RaePerfValues counted;
+} RaeBenchSample;
+
+/* Keys of the per-iteration counters in a saved baseline. */
+static const char* const g_rae_bench_counter_keys[RAE_PERF_COUNT] = {
+  "cycles", "instructions", "cache_misses", "branch_misses", "page_faults"
+};
+
+static volatile int64_t g_rae_bench_sink;
+
+/* Times one call; with `counted`, also counts it. */
+static int64_t rae_bench_time(RaeBenchFn fn, int64_t n, RaePerfValues* counted) {
+  RaePerfValues before, after;
+  if (counted) rae_perf_read(&before);
+  int64_t t0 = rae_ext_nowNs();
+  g_rae_bench_sink += fn(n);
+  int64_t t = rae_ext_nowNs() - t0;
+  if (counted) {
+    rae_perf_read(&after);
+    rae_perf_delta(&before, &after, counted);
+  }
+  return t;
+}
+
+static int rae_bench_cmp(const void* a, const void* b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+static int rae_bench_sample_cmp(const void* a, const void* b) {
+  return rae_bench_cmp(&((const RaeBenchSample*)a)->ns, &((const RaeBenchSample*)b)->ns);
+}
+
+static double rae_bench_ipc(const RaeBenchResult* r) {
+  double cycles = r->per_iter[RAE_PERF_CYCLES], instructions = r->per_iter[RAE_PERF_INSTRUCTIONS];
+  return cycles > 0 ? instructions / cycles : NAN;
+}
+
+/* Linear interpolation between the order statistics of sorted v. */
+static double rae_bench_quantile(const double* v, int n, double q) {
+  double at = q * (n - 1);
+  int lo = (int)at;
+  if (lo + 1 >= n) return v[n - 1];
+  return v[lo] + (v[lo + 1] - v[lo]) * (at - lo);
+}
+
+/* Two-sided 95% Student t critical value for `df` degrees of freedom. */
+static double rae_bench_t95(double df) {
+  static const double table[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+  if (df < 1) return table[0];
+  if (df <= 30) return table[(int)df - 1];
+  return 1.960 + 2.4 / df;  /* within 0.003 of the exact value past 30 */
+}
+
+static void rae_bench_fmt_ns(char* out, size_t cap, double ns) {
+  if (ns < 1e3) snprintf(out, cap, "%.2f ns", ns);
+  else if (ns < 1e6) snprintf(out, cap, "%.2f us", ns / 1e3);
+  else if (ns < 1e9) snprintf(out, cap, "%.2f ms", ns / 1e6);
+  else snprintf(out, cap, "%.2f s", ns / 1e9);
+}
+
+static void rae_bench_measure(const RaeBenchCase* c, const RaeBenchOptions* o, RaeBenchResult* r) {
+  /* Calibrate: grow n until a call is long enough to time well, then aim
+   * one call at the sample length. */
+  int64_t n = 1, t = rae_bench_time(c->fn, n, NULL);
+  while (t < 1000000 && n < ((int64_t)1 << 40)) {
+    n *= 2;
+    t = rae_bench_time(c->fn, n, NULL);
+  }
+  if (t < o->sample_ns) {
+    double scaled = (double)n * (double)o->sample_ns / (double)(t > 0 ? t : 1);
+    n = scaled > (double)((int64_t)1 << 50) ? ((int64_t)1 << 50) : (int64_t)scaled;
+    if (n < 1) n = 1;
+  }
+  for (int64_t start = rae_ext_nowNs(); rae_ext_nowNs() - start < o->warmup_ns;) {
+    rae_bench_time(c->fn, n, NULL);
+  }
+
+  static RaeBenchSample samples[RAE_BENCH_MAX_SAMPLES];
+  static double ns[RAE_BENCH_MAX_SAMPLES], kept[RAE_BENCH_MAX_SAMPLES];
+  for (int i = 0; i < o->samples; i++) {
+    RaeBenchSample* s = &samples[i];
+    for (int j = 0; j < RAE_PERF_COUNT; j++) s->counted.v[j] = -1;
+    s->ns = (double)rae_bench_time(c->fn, n, o->counters ? &s->counted : NULL) / (double)n;
+  }
+  qsort(samples, (size_t)o->samples, sizeof(RaeBenchSample), rae_bench_sample_cmp);
+  for (int i = 0; i < o->samples; i++) ns[i] = samples[i].ns;
+  double q1 = rae_bench_quantile(ns, o->samples, 0.25);
+  double q3 = rae_bench_quantile(ns, o->samples, 0.75);
+  double lo = q1 - 1.5 * (q3 - q1), hi = q3 + 1.5 * (q3 - q1);
+  int k = 0;
+  double total[RAE_PERF_COUNT] = {0};
+  int missing[RAE_PERF_COUNT] = {0};
+  for (int i = 0; i < o->samples; i++) {
+    if (ns[i] < lo || ns[i] > hi) continue;
+    kept[k++] = ns[i];
+    for (int j = 0; j < RAE_PERF_COUNT; j++) {
+      if (samples[i].counted.v[j] < 0) missing[j] = 1;
+      else total[j] += (double)samples[i].counted.v[j];
+    }
+  }
+  for (int j = 0; j < RAE_PERF_COUNT; j++) {
+    r->per_iter[j] = missing[j] ? NAN : total[j] / ((double)k * (double)n);
+  }
+
+  double sum = 0, sq = 0;
+  for (int i = 0; i < k; i++) sum += kept[i];
+  double mean = sum / k;
+  for (int i = 0; i < k; i++) sq += (kept[i] - mean) * (kept[i] - mean);
+  double stddev = k > 1 ? sqrt(sq / (k - 1)) : 0;
+
+  r->name = c->name;
+  r->iterations = n;
+  r->samples = k;
+  r->outliers = o->samples - k;
+  r->median = rae_bench_quantile(kept, k, 0.5);
+  r->mean = mean;
+  r->stddev = stddev;
+  r->ci = k > 1 ? rae_bench_t95(k - 1) * stddev / sqrt((double)k) : 0;
+  r->min = kept[0];
+  r->max = kept[k - 1];
+}
+
+/* The counters line under a benchmark: IPC, then events per iteration. */
+static void rae_bench_print_counters(const RaeBenchResult* r) {
+  int shown = 0;
+  double ipc = rae_bench_ipc(r);
+  if (!isnan(ipc)) {
+    printf("    ipc %.2f", ipc);
+    shown = 1;
+  }
+  for (int j = RAE_PERF_CACHE_MISSES; j < RAE_PERF_COUNT; j++) {
+    if (isnan(r->per_iter[j])) continue;
+    printf("%s%s %.4g/iter", shown ? "  " : "    ", g_rae_perf_names[j], r->per_iter[j]);
+    shown = 1;
+  }
+  if (shown) printf("\n");
+}
+
+static int rae_bench_save(const char* path, const RaeBenchResult* rs, int count) {
+  FILE* f = fopen(path, "w");
+  if (!f) return 0;
+  fprintf(f, "{\n  \"unit\": \"ns/iter\",\n  \"benchmarks\": [");
+  for (int i = 0; i < count; i++) {
+    const RaeBenchResult* r = &rs[i];
+    fprintf(f, "%s\n    {\"name\": \"%s\", \"iterations\": %lld, \"samples\": %d, \"outliers\": %d, "
+               "\"median\": %.17g, \"mean\": %.17g, \"stddev\": %.17g, \"ci95\": %.17g, \"min\": %.17g",
+            i ? "," : "", r->name, (long long)r->iterations, r->samples, r->outliers,
+            r->median, r->mean, r->stddev, r->ci, r->min);
+    /* Counters per iteration, where the machine had them. */
+    for (int j = 0; j < RAE_PERF_COUNT; j++) {
+      if (!isnan(r->per_iter[j])) fprintf(f, ", \"%s\": %.17g", g_rae_bench_counter_keys[j], r->per_iter[j]);
+    }
+    fprintf(f, "}");
+  }
+  fprintf(f, "\n  ]\n}\n");
+  return fclose(f) == 0;
+}
+
+/* The number after `"key":` inside [from, to), or NAN. */
+static double rae_bench_json_num(const char* from, const char* to, const char* key) {
+  char pat[32];
+  snprintf(pat, sizeof(pat), "\"%s\":", key);
+  const char* p = strstr(from, pat);
+  if (!p || p >= to) return NAN;
+  return strtod(p + strlen(pat), NULL);
+}
+
+/* Find `name` in a baseline written by rae_bench_save. */
+static int rae_bench_baseline_find(const char* json, const char* name, RaeBenchResult* out) {
+  char pat[256];
+  snprintf(pat, sizeof(pat), "\"name\": \"%s\"", name);
+  const char* p = strstr(json, pat);
+  if (!p) return 0;
+  const char* end = strchr(p, '}');
+  if (!end) return 0;
+  out->mean = rae_bench_json_num(p, end, "mean");
+  out->stddev = rae_bench_json_num(p, end, "stddev");
+  out->samples = (int)rae_bench_json_num(p, end, "samples");
+  for (int j = 0; j < RAE_PERF_COUNT; j++) {
+    out->per_iter[j] = rae_bench_json_num(p, end, g_rae_bench_counter_keys[j]);
+  }
+  return !isnan(out->mean) && !isnan(out->stddev) && out->samples > 0;
+}
+
+static char* rae_bench_read_file(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char* text = size >= 0 ? (char*)malloc((size_t)size + 1) : NULL;
+  if (text) {
+    size_t got = fread(text, 1, (size_t)size, f);
+    text[got] = '\0';
+  }
+  fclose(f);
+  return text;
+}
+
+/* Compare against the baseline entry: 1 regression, -1 improvement, 0 no
+ * significant change or too few samples to tell. Prints the verdict. */
+static int rae_bench_compare(const RaeBenchResult* r, const RaeBenchResult* b, double threshold) {
+  double change = (r->mean / b->mean - 1.0) * 100.0;
+  /* Every kept sample past the threshold: a change no variance explains. */
+  int all_slower = r->min > b->mean * (1.0 + threshold / 100.0);
+  int all_faster = r->max < b->mean * (1.0 - threshold / 100.0);
+  double va = r->stddev * r->stddev / r->samples, vb = b->stddev * b->stddev / b->samples;
+  double se = sqrt(va + vb);
+  int significant;
+  double df = 1;
+  if (se > 0) {
+    double denom = (r->samples > 1 ? va * va / (r->samples - 1) : 0) +
+                   (b->samples > 1 ? vb * vb / (b->samples - 1) : 0);
+    df = denom > 0 ? (va + vb) * (va + vb) / denom : 1;
+    significant = fabs(r->mean - b->mean) / se > rae_bench_t95(df);
+  } else {
+    significant = r->mean != b->mean;
+  }
+  int verdict = 0;
+  if (all_slower || (significant && change > threshold)) verdict = 1;
+  else if (all_faster || (significant && change < -threshold)) verdict = -1;
+  if (verdict == 0 && !significant &&
+      (r->samples < RAE_BENCH_MIN_WELCH_SAMPLES || b->samples < RAE_BENCH_MIN_WELCH_SAMPLES)) {
+    printf("    vs baseline %+.1f%% (inconclusive: %d and %d samples kept, need %d; raise --samples)\n",
+           change, r->samples, b->samples, RAE_BENCH_MIN_WELCH_SAMPLES);
+  } else {
+    printf("    vs baseline %+.1f%% %s\n", change,
+           verdict > 0 ? "REGRESSION" : verdict < 0 ? "improved" : significant ? "(within threshold)" : "(no significant change)");
+  }
+  /* The counters say why: fewer instructions per cycle, or more misses. */
+  double ipc = rae_bench_ipc(r), base_ipc = rae_bench_ipc(b);
+  int shown = 0;
+  if (!isnan(ipc) && !isnan(base_ipc)) {
+    printf("    was ipc %.2f", base_ipc);
+    shown = 1;
+  }
+  for (int j = RAE_PERF_CACHE_MISSES; j < RAE_PERF_COUNT; j++) {
+    if (isnan(r->per_iter[j]) || isnan(b->per_iter[j])) continue;
+    printf("%s%s %.4g/iter", shown ? "  " : "    was ", g_rae_perf_names[j], b->per_iter[j]);
+    shown = 1;
+  }
+  if (shown) printf("\n");
+  return verdict;
+}
+
+static int rae_bench_usage(void) {
+  fprintf(stderr,
+          "bench options: --filter <text>  --samples <n> (default 30)\n"
+          "               --sample-ms <ms> (default 50)  --warmup-ms <ms> (default 200)\n"
+          "               --save <file.json>  --baseline <file.json>\n"
+          "               --threshold <percent> (default 5)  --no-counters\n");
+  return 2;
+}
+
+int rae_bench_main(int argc, char** argv, const RaeBenchCase* cases, int count) {
+  RaeBenchOptions o = {NULL, 30, 50 * 1000000LL, 200 * 1000000LL, NULL, NULL, 5.0, 1};
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    if (strcmp(a, "--no-counters") == 0) {
+      o.counters = 0;
+      continue;
+    }
+    const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!v) return rae_bench_usage();
+    if (strcmp(a, "--filter") == 0) o.filter = v;
+    else if (strcmp(a, "--samples") == 0) o.samples = atoi(v);
+    else if (strcmp(a, "--sample-ms") == 0) o.sample_ns = (int64_t)(atof(v) * 1e6);
+    else if (strcmp(a, "--warmup-ms") == 0) o.warmup_ns = (int64_t)(atof(v) * 1e6);
+    else if (strcmp(a, "--save") == 0) o.save_path = v;
+    else if (strcmp(a, "--baseline") == 0) o.baseline_path = v;
+    else if (strcmp(a, "--threshold") == 0) o.threshold = atof(v);
+    else return rae_bench_usage();
+    i++;
+  }
+  if (o.samples < 3 || o.samples > RAE_BENCH_MAX_SAMPLES) {
+    fprintf(stderr, "error: --samples must be 3..%d\n", RAE_BENCH_MAX_SAMPLES);
+    return 2;
+  }
+  char* baseline = NULL;
+  if (o.baseline_path && !(baseline = rae_bench_read_file(o.baseline_path))) {
+    fprintf(stderr, "error: cannot read baseline '%s'\n", o.baseline_path);
+    return 2;
+  }
+
+  if (o.counters && !rae_ext_rae_sys_perf_available(RAE_PERF_CYCLES)) {
+    printf("note: no hardware counters here (no PMU, or perf_event_paranoid); no IPC or misses\n");
+  }
+
+  RaeBenchResult* results = (RaeBenchResult*)calloc((size_t)(count > 0 ? count : 1), sizeof(RaeBenchResult));
+  int ran = 0, regressions = 0;
+  for (int i = 0; i < count; i++) {
+    if (o.filter && !strstr(cases[i].name, o.filter)) continue;
+    RaeBenchResult* r = &results[ran++];
+    rae_bench_measure(&cases[i], &o, r);
+    char med[32], mean[32], ci[32];
+    rae_bench_fmt_ns(med, sizeof(med), r->median);
+    rae_bench_fmt_ns(mean, sizeof(mean), r->mean);
+    rae_bench_fmt_ns(ci, sizeof(ci), r->ci);
+    printf("%-24s median %10s  mean %10s +- %s (%.1f%%)  %lld iters x %d, %d outliers\n",
+           r->name, med, mean, ci, r->mean > 0 ? 100.0 * r->ci / r->mean : 0.0,
+           (long long)r->iterations, r->samples, r->outliers);
+    rae_bench_print_counters(r);
+    if (baseline) {
+      RaeBenchResult b;
+      if (rae_bench_baseline_find(baseline, r->name, &b)) {
+        if (rae_bench_compare(r, &b, o.threshold) > 0) regressions++;
+      } else {
+        printf("    not in baseline\n");
+      }
+    }
+    fflush(stdout);
+  }
+  if (ran == 0) fprintf(stderr, "warning: no bench functions%s\n", o.filter ? " match the filter" : "");
+  int status = regressions ? 1 : 0;
+  if (o.save_path && !rae_bench_save(o.save_path, results, ran)) {
+    fprintf(stderr, "error: cannot write '%s'\n", o.save_path);
+    status = 2;
+  }
+  if (baseline) printf("%d regression%s against %s\n", regressions, regressions == 1 ? "" : "s", o.baseline_path);
+  free(baseline);
+  free(results);
+  return status;
+}
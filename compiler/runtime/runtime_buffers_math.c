@@ -154,26 +154,32 @@ static void rae_buf_check(const char* fn, void* buf, int64_t index, int64_t elem
 
 void* rae_ext_rae_buf_alloc(int64_t count, int64_t elem_size) {
   if (count <= 0) return NULL;
-  void* p = calloc((size_t)count, (size_t)elem_size);
+  /* Zeroed, but only recycled blocks pay a memset (runtime_alloc.c). */
+  void* p = rae_alloc_zeroed((size_t)count * (size_t)elem_size);
   if (p) { g_mem_buf_alloc_n++; g_mem_buf_alloc_b += count * elem_size; }
+  rae_heap_note_alloc(p, count * elem_size, RAE_HEAP_SITE_BUF);
   RAE_BR_REGISTER(p, count, elem_size);
   return p;
 }
 
 void rae_ext_rae_buf_free(void* buf) {
   if (buf) {
-    g_mem_buf_free_n++; g_mem_buf_free_b += rae_malloc_size_safe(buf);
+    g_mem_buf_free_n++;
+    if (g_mem_stats_enabled) g_mem_buf_free_b += rae_alloc_size(buf);
+    rae_heap_note_free(buf);
     RAE_BR_UNREGISTER(buf);
-    free(buf);
+    rae_free(buf);
   }
 }
 
 void* rae_ext_rae_buf_resize(void* buf, int64_t new_count, int64_t elem_size) {
   if (new_count <= 0) {
     if (buf) {
-      g_mem_buf_free_n++; g_mem_buf_free_b += rae_malloc_size_safe(buf);
+      g_mem_buf_free_n++;
+      if (g_mem_stats_enabled) g_mem_buf_free_b += rae_alloc_size(buf);
+      rae_heap_note_free(buf);
       RAE_BR_UNREGISTER(buf);
-      free(buf);
+      rae_free(buf);
     }
     return NULL;
   }
@@ -181,12 +187,14 @@ void* rae_ext_rae_buf_resize(void* buf, int64_t new_count, int64_t elem_size) {
    * outstanding count stays balanced (one free, one alloc per call),
    * which lets a leak-class hunt distinguish "buffers we forgot to
    * free" from "buffers we keep resizing". */
-  int64_t old_bytes = buf ? rae_malloc_size_safe(buf) : 0;
+  int64_t old_bytes = buf && g_mem_stats_enabled ? rae_alloc_size(buf) : 0;
+  rae_heap_note_free(buf);
   RAE_BR_UNREGISTER(buf);
-  void* p = realloc(buf, (size_t)new_count * (size_t)elem_size);
+  void* p = rae_realloc(buf, (size_t)new_count * (size_t)elem_size);
   if (buf) { g_mem_buf_free_n++; g_mem_buf_free_b += old_bytes; }
   if (p)   { g_mem_buf_alloc_n++; g_mem_buf_alloc_b += new_count * elem_size; }
   g_mem_buf_resize_n++;
+  rae_heap_note_alloc(p, new_count * elem_size, RAE_HEAP_SITE_BUF);
   RAE_BR_REGISTER(p, new_count, elem_size);
   return p;
 }
@@ -279,7 +287,7 @@ rae_String rae_json_extract_string(rae_String json, const char* key) {
     const char* end = strchr(v, '"');
     if (!end) return (rae_String){NULL, 0, 0, 0};
     int64_t len = (int64_t)(end - v);
-    uint8_t* copy = (uint8_t*)malloc((size_t)len + 1);
+    uint8_t* copy = (uint8_t*)rae_alloc((size_t)len + 1);
     if (copy) {
       memcpy(copy, v, (size_t)len); copy[len] = 0;
       rae_mem_str_tag(copy, len + 1, RAE_SITE_JSON_EXTRACT);
@@ -10,15 +10,12 @@
 #include <mach/mach.h>
 #include <mach/task.h>
 #include <mach/task_info.h>
-#include <malloc/malloc.h>
 #include <CoreFoundation/CoreFoundation.h>
 #endif
 
-#if defined(__linux__) || defined(__GLIBC__)
-#include <malloc.h>
-#endif
-
+/* Buffered log lines first (runtime_log_sink.c), then stdio. */
 void rae_flush_stdout(void) {
+  rae_ext_rae_log_flush();
   fflush(stdout);
 }
 
@@ -55,6 +52,11 @@ static void rae_crash_handler(int sig) {
   const char* msg = "[rae crash] (backtrace() not available on this platform)\n";
   write(STDERR_FILENO, msg, strlen(msg));
 #endif
+  /* After the backtrace, which must not depend on them: buffered log lines
+   * reach stdout (runtime_log_sink.c) and a profiler capture keeps
+   * everything up to the fault (runtime_profile.c). */
+  rae_log_crash_flush();
+  rae_prof_crash_flush();
   /* Exit with the conventional signal exit code so a parent process /
    * supervisor sees a non-zero status and can restart. On macOS,
    * `raise(sig)` after restoring SIG_DFL doesn't reliably terminate for
@@ -85,11 +87,13 @@ static void rae_install_crash_handler(void) {
  * Tracks String body and List/Map buf allocations *per call site* so
  * a stress run can pinpoint which helper produces the strings that
  * never get freed. Per-site counters are gated on g_mem_stats_enabled
- * so disabled runs pay zero overhead. When enabled, a side hash
- * table maps ptr → site so the three free paths (str_free, str_interp
+ * so disabled runs pay zero overhead. When enabled, the allocator's
+ * per-chunk site bytes (slab blocks) or a side hash table (malloc
+ * blocks) map ptr → site so the three free paths (str_free, str_interp
  * owned-input cleanup, pool_flush) can attribute back to the alloc
  * site. Output goes to stderr at process exit (atexit) and on demand
- * via rae_ext_rae_mem_stats_dump().
+ * via rae_ext_rae_mem_stats_dump(), followed by the allocator's own
+ * per-class counters (runtime_alloc.c).
  */
 
 typedef enum {
@@ -157,7 +161,8 @@ static int g_mem_stats_enabled = 0;
  */
 static int64_t g_mem_alloc_total_n;
 
-/* Side hash table: ptr → site. Allocated only when mem-stats is on.
+/* Side hash table: ptr → site for blocks outside the slabs (large
+ * buffers, RAE_ALLOC=libc runs). Allocated only when mem-stats is on.
  * 4M slots sized for ~2M outstanding allocations (peak observed in
  * the 20K mobile-UI stress is ~1.2M). Two parallel arrays keep the
  * key array dense (better cache behaviour for the probe scan). */
@@ -170,17 +175,6 @@ static uint8_t* g_mem_hash_sites;  /* parallel array, valid when key != NULL */
 static int64_t  g_mem_hash_size;   /* current occupancy */
 static int64_t  g_mem_hash_full_drops; /* allocs we couldn't tag because table was full */
 
-static int64_t rae_malloc_size_safe(void* p) {
-  if (!p) return 0;
-#if defined(__APPLE__)
-  return (int64_t)malloc_size(p);
-#elif defined(__linux__) || defined(__GLIBC__)
-  return (int64_t)malloc_usable_size(p);
-#else
-  return 0;
-#endif
-}
-
 static inline uint32_t rae_mem_hash_ix(void* ptr) {
   uint64_t x = (uint64_t)(uintptr_t)ptr;
   /* Mix high and low bits — malloc returns 16-byte aligned blocks on
@@ -259,25 +253,70 @@ static uint8_t rae_mem_hash_remove(void* ptr) {
   return RAE_SITE_UNKNOWN;
 }
 
+/* ---- Sampling heap profiler hooks (runtime_heap_profile.c) ----
+ *
+ * Every tagged allocation and every untag also passes through the heap
+ * profiler, which unlike the counters above is cheap enough to leave on:
+ * an allocation subtracts its size from a per-thread byte countdown and
+ * only the one that crosses zero is sampled; a free is checked against a
+ * counting filter of sampled pointers and only a filter hit takes a lock.
+ * Both are a single relaxed flag load when the profiler is off. */
+#define RAE_HEAP_FILTER 65536
+#define RAE_HEAP_SITE_BUF RAE_SITE__COUNT   /* List/Buffer storage */
+static int g_rae_heap_on;                       /* atomic: sampling */
+static int64_t g_rae_heap_live_n;               /* atomic: sampled allocations outstanding */
+static uint8_t g_rae_heap_filter[RAE_HEAP_FILTER];  /* atomic counters, by rae_heap_filter_ix */
+static __thread int64_t g_rae_heap_until;       /* bytes before this thread's next sample */
+static void rae_heap_sample(void* ptr, int64_t bytes, uint8_t site);
+static void rae_heap_release(void* ptr);
+
+static inline uint32_t rae_heap_filter_ix(void* ptr) {
+  uint64_t x = (uint64_t)(uintptr_t)ptr >> 4;
+  return (uint32_t)((x * 0x9e3779b97f4a7c15ULL) >> 48);
+}
+
+static inline void rae_heap_note_alloc(void* ptr, int64_t bytes, uint8_t site) {
+  if (!__atomic_load_n(&g_rae_heap_on, __ATOMIC_RELAXED) || !ptr) return;
+  if ((g_rae_heap_until -= bytes) < 0) rae_heap_sample(ptr, bytes, site);
+}
+
+static inline void rae_heap_note_free(void* ptr) {
+  if (!__atomic_load_n(&g_rae_heap_live_n, __ATOMIC_RELAXED) || !ptr) return;
+  if (__atomic_load_n(&g_rae_heap_filter[rae_heap_filter_ix(ptr)], __ATOMIC_RELAXED)) rae_heap_release(ptr);
+}
+
 static inline void rae_mem_str_tag(void* ptr, int64_t bytes, uint8_t site) {
   /* Counted BEFORE the opt-in gate: see g_mem_alloc_total_n. Every String
    * body allocation in the runtime funnels through here, so this is a
    * complete count of Rae's string heap traffic. */
   g_mem_alloc_total_n++;
+  rae_heap_note_alloc(ptr, bytes, site);
   if (!g_mem_stats_enabled) return;
   g_mem_site_alloc_n[site]++;
   g_mem_site_alloc_b[site] += bytes;
-  rae_mem_hash_insert(ptr, site);
+  uint8_t* slot = ptr ? rae_alloc_site_slot(ptr) : NULL;
+  if (slot) *slot = (uint8_t)(site + 1);
+  else rae_mem_hash_insert(ptr, site);
 }
 
 static inline void rae_mem_str_untag(void* ptr, int64_t bytes_hint) {
+  rae_heap_note_free(ptr);
   if (!g_mem_stats_enabled) return;
-  uint8_t site = rae_mem_hash_remove(ptr);
+  /* Slab blocks carry their site in the allocator (rae_alloc_site_slot);
+   * only malloc blocks go through the side hash. */
+  uint8_t* slot = ptr ? rae_alloc_site_slot(ptr) : NULL;
+  uint8_t site = RAE_SITE_UNKNOWN;
+  if (slot) {
+    if (*slot) site = (uint8_t)(*slot - 1);
+    *slot = 0;
+  } else {
+    site = rae_mem_hash_remove(ptr);
+  }
   g_mem_site_free_n[site]++;
   /* Prefer the explicit byte count (capacity from the rae_String);
-   * fall back to malloc_size for the pool_flush path that only has
-   * a ptr. */
-  int64_t bytes = bytes_hint > 0 ? bytes_hint : rae_malloc_size_safe(ptr);
+   * fall back to the allocator's block size for the pool_flush path
+   * that only has a ptr. */
+  int64_t bytes = bytes_hint > 0 ? bytes_hint : rae_alloc_size(ptr);
   g_mem_site_free_b[site] += bytes;
 }
 
@@ -313,6 +352,7 @@ static void rae_mem_stats_print(void) {
   fprintf(stderr, "  [mem:pool              ] register=%lld remove=%lld flush_calls=%lld flush_freed=%lld\n",
     (long long)g_mem_pool_register_n, (long long)g_mem_pool_remove_n,
     (long long)g_mem_pool_flush_calls, (long long)g_mem_pool_flush_freed);
+  rae_alloc_stats_print();
   if (g_mem_hash_full_drops) {
     fprintf(stderr, "  [mem:hash              ] WARNING: %lld allocations dropped (table full) — per-site free counts under-report by this much\n",
       (long long)g_mem_hash_full_drops);
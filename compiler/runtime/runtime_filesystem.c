@@ -6,6 +6,8 @@
  */
 
 rae_String rae_ext_rae_io_read_line(void) {
+  /* A prompt logged with logS must show before the read blocks. */
+  rae_ext_rae_log_flush();
   char* buffer = NULL;
   size_t len = 0;
   if (getline(&buffer, &len, stdin) == -1) {
@@ -22,12 +24,18 @@ rae_String rae_ext_rae_io_read_line(void) {
       buffer[blen-1] = '\0';
       blen--;
   }
-  rae_mem_str_tag(buffer, (int64_t)len, RAE_SITE_READ_LINE);
-  return (rae_String){(uint8_t*)buffer, (int64_t)blen, (int64_t)len, 1};
+  /* getline's buffer is libc's; the String body comes from rae_alloc. */
+  uint8_t* data = rae_alloc(blen + 1);
+  if (!data) { free(buffer); return (rae_String){NULL, 0, 0, 0}; }
+  memcpy(data, buffer, blen + 1);
+  free(buffer);
+  rae_mem_str_tag(data, (int64_t)blen + 1, RAE_SITE_READ_LINE);
+  return (rae_String){data, (int64_t)blen, (int64_t)blen + 1, 1};
 }
 
 rae_Char rae_ext_rae_io_read_char(void) {
   // TODO: Proper UTF-8 read from stdin
+  rae_ext_rae_log_flush();
   return (uint32_t)getchar();
 }
 
@@ -48,7 +56,7 @@ rae_String rae_ext_rae_sys_read_file(rae_String path) {
   fseek(f, 0, SEEK_END);
   long len = ftell(f);
   fseek(f, 0, SEEK_SET);
-  uint8_t* buffer = malloc((size_t)len + 1);
+  uint8_t* buffer = rae_alloc((size_t)len + 1);
   if (buffer) {
     fread(buffer, 1, (size_t)len, f);
     buffer[len] = '\0';
@@ -103,6 +111,22 @@ void* rae_ext_rae_sys_read_file_bytes(rae_String path, rae_Mod_Int64 out) {
   return buf;
 }
 
+/* Write `len` byte values (the low 8 bits of each Int) to `path`, replacing
+ * it: the binary counterpart of rae_sys_write_file, for PNG or .glb bytes
+ * built in Rae. */
+rae_Bool rae_ext_rae_sys_write_file_bytes(rae_String path, const int64_t* data, int64_t len) {
+  if (!path.data || len < 0 || (len > 0 && !data)) return false;
+  uint8_t* raw = (uint8_t*)malloc(len > 0 ? (size_t)len : 1);
+  if (!raw) return false;
+  for (int64_t i = 0; i < len; i++) raw[i] = (uint8_t)data[i];
+  FILE* f = fopen((const char*)path.data, "wb");
+  if (!f) { free(raw); return false; }
+  size_t written = fwrite(raw, 1, (size_t)len, f);
+  int closed = fclose(f);
+  free(raw);
+  return written == (size_t)len && closed == 0;
+}
+
 /* Read a byte RANGE of a file as text.
  *
  * Binary containers embed text chunks — a .glb's JSON, an ID3 tag, an EXIF
@@ -127,6 +151,70 @@ rae_String rae_ext_rae_sys_read_file_text(rae_String path, int64_t offset, int64
   return out;
 }
 
+/* Map a whole file read-only.
+ *
+ * Precompiled assets (the packed .raescene.bin format, see
+ * lib/ui/scene_bin.rae) are flat little-endian columns that the loader
+ * bulk-copies straight into List storage, so there is nothing to gain
+ * from a read() into a scratch buffer first. The mapping is NOT a
+ * rae_buf_alloc block: release it with rae_ext_rae_sys_unmap_file, never
+ * rae_ext_rae_buf_free. WASM and Windows fall back to a malloc'd copy
+ * behind the same pair of calls. Returns NULL with *outLen = 0 on failure
+ * or for an empty file.
+ */
+void* rae_ext_rae_sys_map_file(rae_String path, rae_Mod_Int64 out) {
+  int64_t* outLen = out.ptr;
+  if (outLen) *outLen = 0;
+  if (!path.data) return NULL;
+#if defined(__wasm__) || defined(_WIN32)
+  FILE* f = fopen((const char*)path.data, "rb");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (len <= 0) { fclose(f); return NULL; }
+  void* data = malloc((size_t)len);
+  if (!data) { fclose(f); return NULL; }
+  size_t got = fread(data, 1, (size_t)len, f);
+  fclose(f);
+  if (got != (size_t)len) { free(data); return NULL; }
+  if (outLen) *outLen = (int64_t)len;
+  return data;
+#else
+  int fd = open((const char*)path.data, O_RDONLY);
+  if (fd < 0) return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(fd); return NULL; }
+  void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return NULL;
+  if (outLen) *outLen = (int64_t)st.st_size;
+  return data;
+#endif
+}
+
+void rae_ext_rae_sys_unmap_file(void* data, int64_t len) {
+  if (!data || len <= 0) return;
+#if defined(__wasm__) || defined(_WIN32)
+  free(data);
+#else
+  munmap(data, (size_t)len);
+#endif
+}
+
+/* A view `byteOffset` bytes into a mapped file, for reinterpreting one of
+ * its columns as a typed Buffer. No allocation, no ownership. */
+void* rae_ext_rae_sys_mapped_at(void* data, int64_t byteOffset) {
+  if (!data) return NULL;
+  return (uint8_t*)data + byteOffset;
+}
+
+/* Copy `len` bytes of a mapped file into a new String. */
+rae_String rae_ext_rae_sys_mapped_string(void* data, int64_t byteOffset, int64_t len) {
+  if (!data || len <= 0) return (rae_String){NULL, 0, 0, 0};
+  return rae_ext_rae_str_from_buf((const uint8_t*)data + byteOffset, len);
+}
+
 rae_Bool rae_ext_rae_sys_write_file(rae_String path, rae_String content) {
   if (!path.data || !content.data) return false;
   FILE* f = fopen((const char*)path.data, "wb");
@@ -222,6 +310,22 @@ int64_t rae_ext_rae_sys_rss_kb(void) {
 #endif
 }
 
+/* Online logical CPUs — how many worker tasks a data-parallel job (banded PNG
+ * encode, and friends) should split into. Never less than 1, so callers can
+ * divide by it; single-threaded wasm reports 1. */
+int64_t rae_ext_rae_sys_cpu_count(void) {
+#if defined(__wasm__) && !defined(RAE_WASM_THREADS)
+    return 1;
+#elif defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int64_t)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int64_t)n : 1;
+#endif
+}
+
 /* Non-recursive directory scan. Returns a newline-separated list of
  * entry names (excluding "." and ".."), or the empty string when the
  * directory can't be opened. Caller-side `lib/fs.rae::listDir` splits
@@ -237,7 +341,7 @@ rae_String rae_ext_rae_sys_list_dir(rae_String folder) {
    * Keeps the function single-pass (no readdir count then re-read). */
   size_t cap = 256;
   size_t len = 0;
-  uint8_t* buf = malloc(cap);
+  uint8_t* buf = rae_alloc(cap);
   if (!buf) { closedir(dir); return (rae_String){NULL, 0, 0, 0}; }
 
   struct dirent* entry;
@@ -250,8 +354,8 @@ rae_String rae_ext_rae_sys_list_dir(rae_String folder) {
     size_t need = len + nameLen + 1; /* +1 for separator newline */
     if (need > cap) {
       while (need > cap) cap *= 2;
-      uint8_t* grown = realloc(buf, cap);
-      if (!grown) { free(buf); closedir(dir); return (rae_String){NULL, 0, 0, 0}; }
+      uint8_t* grown = rae_realloc(buf, cap);
+      if (!grown) { rae_free(buf); closedir(dir); return (rae_String){NULL, 0, 0, 0}; }
       buf = grown;
     }
     if (len > 0) {
@@ -262,12 +366,12 @@ rae_String rae_ext_rae_sys_list_dir(rae_String folder) {
   }
   closedir(dir);
 
-  if (len == 0) { free(buf); return (rae_String){NULL, 0, 0, 0}; }
+  if (len == 0) { rae_free(buf); return (rae_String){NULL, 0, 0, 0}; }
 
   /* Null-terminate and register with the string pool so the caller's
    * Rae-side `let raw: String = ...` gets the same lifetime semantics
    * as any other owning String. */
-  uint8_t* finalBuf = realloc(buf, len + 1);
+  uint8_t* finalBuf = rae_realloc(buf, len + 1);
   if (!finalBuf) finalBuf = buf;
   finalBuf[len] = '\0';
   rae_mem_str_tag(finalBuf, len + 1, RAE_SITE_CONCAT);
@@ -290,7 +394,7 @@ double rae_ext_rae_sys_file_mtime(rae_String path){
 
 rae_String rae_ext_rae_str_i64(int64_t v) {
   char buffer[32];
-  int len = snprintf(buffer, 32, "%lld", (long long)v);
+  int len = rae_format_i64(buffer, v);
   return rae_str_from_buf_impl((uint8_t*)buffer, len, RAE_SITE_INT_TO_STR);
 }
 
@@ -299,8 +403,8 @@ rae_String rae_ext_rae_str_i64_ptr(const int64_t* v) {
 }
 
 rae_String rae_ext_rae_str_f64(double v) {
-  char buffer[32];
-  int len = snprintf(buffer, 32, "%g", v);
+  char buffer[RAE_FLOAT_TEXT_MAX];
+  int len = rae_format_f64(buffer, v);
   return rae_str_from_buf_impl((uint8_t*)buffer, len, RAE_SITE_FLOAT_TO_STR);
 }
 
@@ -308,10 +412,37 @@ rae_String rae_ext_rae_str_f64_ptr(const double* v) {
   return rae_ext_rae_str_f64(*v);
 }
 
-/* Float (f32) views. Formatting promotes to double, so the shared f64
- * formatter produces the same text a plain Float would. */
+/* Float32 prints the shortest text for its own precision, so 0.1 stays
+ * "0.1" rather than the promoted double's 0.10000000149011612. */
+rae_String rae_ext_rae_str_f32(float v) {
+  char buffer[RAE_FLOAT_TEXT_MAX];
+  int len = rae_format_f32(buffer, v);
+  return rae_str_from_buf_impl((uint8_t*)buffer, len, RAE_SITE_FLOAT_TO_STR);
+}
+
 rae_String rae_ext_rae_str_f32_ptr(const float* v) {
-  return rae_ext_rae_str_f64((double)*v);
+  return rae_ext_rae_str_f32(*v);
+}
+
+rae_String rae_ext_rae_str_f64_fixed(double v, int64_t digits) {
+  char buffer[RAE_FLOAT_FIXED_MAX];
+  int len = rae_format_f64_fixed(buffer, v, digits < 0 ? 0 : digits > 100 ? 100 : (int)digits);
+  return rae_str_from_buf_impl((uint8_t*)buffer, len, RAE_SITE_FLOAT_TO_STR);
+}
+
+rae_String rae_ext_rae_str_f64_exp(double v, int64_t digits) {
+  char buffer[RAE_FLOAT_FIXED_MAX];
+  int len = rae_format_f64_exp(buffer, v, digits < 0 ? 0 : digits > 100 ? 100 : (int)digits);
+  return rae_str_from_buf_impl((uint8_t*)buffer, len, RAE_SITE_FLOAT_TO_STR);
+}
+
+/* Float32 widens exactly, so its fixed/exponential text is the double's. */
+rae_String rae_ext_rae_str_f32_fixed(float v, int64_t digits) {
+  return rae_ext_rae_str_f64_fixed((double)v, digits);
+}
+
+rae_String rae_ext_rae_str_f32_exp(float v, int64_t digits) {
+  return rae_ext_rae_str_f64_exp((double)v, digits);
 }
 
 rae_String rae_ext_rae_str_bool(rae_Bool v) {
@@ -323,28 +454,8 @@ rae_String rae_ext_rae_str_bool_ptr(const rae_Bool* v) {
 }
 
 rae_String rae_ext_rae_str_char(uint32_t v) {
-  uint8_t buffer[5];
-  int len = 0;
-  if (v < 0x80) {
-    buffer[0] = (uint8_t)v;
-    len = 1;
-  } else if (v < 0x800) {
-    buffer[0] = (uint8_t)(0xC0 | (v >> 6));
-    buffer[1] = (uint8_t)(0x80 | (v & 0x3F));
-    len = 2;
-  } else if (v < 0x10000) {
-    buffer[0] = (uint8_t)(0xE0 | (v >> 12));
-    buffer[1] = (uint8_t)(0x80 | ((v >> 6) & 0x3F));
-    buffer[2] = (uint8_t)(0x80 | (v & 0x3F));
-    len = 3;
-  } else {
-    buffer[0] = (uint8_t)(0xF0 | (v >> 18));
-    buffer[1] = (uint8_t)(0x80 | ((v >> 12) & 0x3F));
-    buffer[2] = (uint8_t)(0x80 | ((v >> 6) & 0x3F));
-    buffer[3] = (uint8_t)(0x80 | (v & 0x3F));
-    len = 4;
-  }
-  buffer[len] = '\0';
+  uint8_t buffer[4];
+  int len = rae_format_char(buffer, v);
   return rae_str_from_buf_impl(buffer, len, RAE_SITE_CHAR_TO_STR);
 }
 
@@ -365,7 +476,7 @@ rae_String rae_ext_rae_str_any(RaeAny v) {
         case RAE_TYPE_INT32:   return rae_ext_rae_str_i64(v.as.i);
         case RAE_TYPE_UINT64:  return rae_ext_rae_str_i64(v.as.i);
         case RAE_TYPE_FLOAT64: return rae_ext_rae_str_f64(v.as.f);
-        case RAE_TYPE_FLOAT32: return rae_ext_rae_str_f64(v.as.f);
+        case RAE_TYPE_FLOAT32: return rae_ext_rae_str_f32((float)v.as.f);
         case RAE_TYPE_BOOL:    return rae_ext_rae_str_bool(v.as.b);
         // Extracting a String from a RaeAny is a read, not an
         // ownership transfer — the RaeAny boxed a copy of someone
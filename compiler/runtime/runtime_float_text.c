@@ -0,0 +1,859 @@
+/* Float <-> text conversion.
+ *
+ * Formatting prints the shortest decimal that reads back to the same
+ * value (Ryu, Adams 2018), laid out like JavaScript's Number toString:
+ * positional up to 21 integer digits and down to 1e-6, scientific
+ * outside that. Fixed and exponential variants take a digit count.
+ *
+ * Parsing is correctly rounded (Clinger's fast path, then Eisel-Lemire,
+ * then strtod on a bounded copy for the rare inputs neither decides) and
+ * reads a byte range, so Rae Strings need no NUL terminator. Both parsers
+ * return the index where the number ended; the strict string externs
+ * turn that into an error position.
+ *
+ * Tables: runtime_float_tables.h, generated by tools/gen_float_tables.py.
+ * This module is included by rae_runtime.c into one translation unit.
+ */
+
+#include <math.h>
+#include "runtime_float_tables.h"
+
+/* ----- Shortest digits (Ryu) ----- */
+
+#define RAE_F2T_BITCOUNT 125 /* both Ryu tables, double precision */
+#define RAE_F2T_BITCOUNT32 (RAE_F2T_BITCOUNT - 64)
+
+/* Decimal significand and exponent: value = digits * 10^exp. */
+typedef struct {
+  uint64_t digits;
+  int32_t exp;
+} RaeDecimal;
+
+/* ceil(log2(5^e)) for e > 0; 1 for e == 0. */
+static inline int32_t rae_f2t_pow5bits(int32_t e) {
+  return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+/* floor(log10(2^e)) and floor(log10(5^e)). */
+static inline uint32_t rae_f2t_log10_pow2(int32_t e) {
+  return ((uint32_t)e * 78913) >> 18;
+}
+
+static inline uint32_t rae_f2t_log10_pow5(int32_t e) {
+  return ((uint32_t)e * 732923) >> 20;
+}
+
+static inline uint32_t rae_f2t_pow5_factor(uint64_t v) {
+  uint32_t count = 0;
+  while (v % 5 == 0) {
+    v /= 5;
+    count++;
+  }
+  return count;
+}
+
+static inline int rae_f2t_multiple_of_pow5(uint64_t v, uint32_t p) {
+  return rae_f2t_pow5_factor(v) >= p;
+}
+
+static inline int rae_f2t_multiple_of_pow2(uint64_t v, uint32_t p) {
+  return (v & ((1ull << p) - 1)) == 0;
+}
+
+#ifdef __SIZEOF_INT128__
+
+__extension__ typedef unsigned __int128 rae_u128;
+
+/* (m * mul) >> j for a 128-bit table entry, j >= 64. */
+static inline uint64_t rae_f2t_mul_shift64(uint64_t m, const uint64_t* mul, int32_t j) {
+  rae_u128 b0 = (rae_u128)m * mul[0];
+  rae_u128 b2 = (rae_u128)m * mul[1];
+  return (uint64_t)(((b0 >> 64) + b2) >> (j - 64));
+}
+
+static RaeDecimal rae_f2t_d2d(uint64_t ieee_mantissa, uint32_t ieee_exponent) {
+  int32_t e2;
+  uint64_t m2;
+  if (ieee_exponent == 0) {
+    e2 = 1 - 1023 - 52 - 2;
+    m2 = ieee_mantissa;
+  } else {
+    e2 = (int32_t)ieee_exponent - 1023 - 52 - 2;
+    m2 = (1ull << 52) | ieee_mantissa;
+  }
+  const int accept_bounds = (m2 & 1) == 0;
+
+  /* Step 2: the interval of values that read back as this double,
+   * [mv - mm_shift - 1, mv + 2] in units of 2^e2. */
+  const uint64_t mv = 4 * m2;
+  const uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+  /* Step 3: the interval in decimal, vr/vp/vm * 10^e10. */
+  uint64_t vr, vp, vm;
+  int32_t e10;
+  int vm_trailing_zeros = 0;
+  int vr_trailing_zeros = 0;
+  if (e2 >= 0) {
+    const uint32_t q = rae_f2t_log10_pow2(e2) - (e2 > 3);
+    e10 = (int32_t)q;
+    const int32_t k = RAE_F2T_BITCOUNT + rae_f2t_pow5bits((int32_t)q) - 1;
+    const int32_t i = -e2 + (int32_t)q + k;
+    vr = rae_f2t_mul_shift64(4 * m2, rae_f2t_pow5_inv[q], i);
+    vp = rae_f2t_mul_shift64(4 * m2 + 2, rae_f2t_pow5_inv[q], i);
+    vm = rae_f2t_mul_shift64(4 * m2 - 1 - mm_shift, rae_f2t_pow5_inv[q], i);
+    if (q <= 21) {
+      /* Only one of mp, mv and mm can be a multiple of 5, if any. */
+      if (mv % 5 == 0) {
+        vr_trailing_zeros = rae_f2t_multiple_of_pow5(mv, q);
+      } else if (accept_bounds) {
+        vm_trailing_zeros = rae_f2t_multiple_of_pow5(mv - 1 - mm_shift, q);
+      } else {
+        vp -= rae_f2t_multiple_of_pow5(mv + 2, q);
+      }
+    }
+  } else {
+    const uint32_t q = rae_f2t_log10_pow5(-e2) - (-e2 > 1);
+    e10 = (int32_t)q + e2;
+    const int32_t i = -e2 - (int32_t)q;
+    const int32_t k = rae_f2t_pow5bits(i) - RAE_F2T_BITCOUNT;
+    const int32_t j = (int32_t)q - k;
+    vr = rae_f2t_mul_shift64(4 * m2, rae_f2t_pow5[i], j);
+    vp = rae_f2t_mul_shift64(4 * m2 + 2, rae_f2t_pow5[i], j);
+    vm = rae_f2t_mul_shift64(4 * m2 - 1 - mm_shift, rae_f2t_pow5[i], j);
+    if (q <= 1) {
+      /* mv has at least q trailing zero bits; mm has one if mm_shift. */
+      vr_trailing_zeros = 1;
+      if (accept_bounds) {
+        vm_trailing_zeros = mm_shift == 1;
+      } else {
+        --vp;
+      }
+    } else if (q < 63) {
+      vr_trailing_zeros = rae_f2t_multiple_of_pow2(mv, q);
+    }
+  }
+
+  /* Step 4: drop digits while the interval still holds a shorter number. */
+  int32_t removed = 0;
+  uint8_t last_removed = 0;
+  uint64_t output;
+  if (vm_trailing_zeros || vr_trailing_zeros) {
+    /* Rare: exact-bound or exact-tie cases. */
+    for (;;) {
+      const uint64_t vp10 = vp / 10;
+      const uint64_t vm10 = vm / 10;
+      if (vp10 <= vm10) break;
+      const uint64_t vr10 = vr / 10;
+      vm_trailing_zeros &= vm - 10 * vm10 == 0;
+      vr_trailing_zeros &= last_removed == 0;
+      last_removed = (uint8_t)(vr - 10 * vr10);
+      vr = vr10;
+      vp = vp10;
+      vm = vm10;
+      ++removed;
+    }
+    if (vm_trailing_zeros) {
+      for (;;) {
+        const uint64_t vm10 = vm / 10;
+        if (vm - 10 * vm10 != 0) break;
+        const uint64_t vr10 = vr / 10;
+        vr_trailing_zeros &= last_removed == 0;
+        last_removed = (uint8_t)(vr - 10 * vr10);
+        vr = vr10;
+        vp /= 10;
+        vm = vm10;
+        ++removed;
+      }
+    }
+    if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+      last_removed = 4; /* exact tie: round to even */
+    }
+    output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+  } else {
+    /* Common case: two digits at a time first, then one. */
+    int round_up = 0;
+    const uint64_t vp100 = vp / 100;
+    const uint64_t vm100 = vm / 100;
+    if (vp100 > vm100) {
+      const uint64_t vr100 = vr / 100;
+      round_up = vr - 100 * vr100 >= 50;
+      vr = vr100;
+      vp = vp100;
+      vm = vm100;
+      removed += 2;
+    }
+    for (;;) {
+      const uint64_t vp10 = vp / 10;
+      const uint64_t vm10 = vm / 10;
+      if (vp10 <= vm10) break;
+      const uint64_t vr10 = vr / 10;
+      round_up = vr - 10 * vr10 >= 5;
+      vr = vr10;
+      vp = vp10;
+      vm = vm10;
+      ++removed;
+    }
+    output = vr + (vr == vm || round_up);
+  }
+  return (RaeDecimal){output, e10 + removed};
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+/* (m * factor) >> shift for the high word of a table entry, shift >= 32. */
+static inline uint32_t rae_f2t_mul_shift32(uint32_t m, uint64_t factor, int32_t shift) {
+  const uint64_t lo = (uint64_t)m * (uint32_t)factor;
+  const uint64_t hi = (uint64_t)m * (uint32_t)(factor >> 32);
+  return (uint32_t)(((lo >> 32) + hi) >> (shift - 32));
+}
+
+static inline uint32_t rae_f2t_mul_pow5_inv32(uint32_t m, uint32_t q, int32_t j) {
+  return rae_f2t_mul_shift32(m, rae_f2t_pow5_inv[q][1] + 1, j);
+}
+
+static inline uint32_t rae_f2t_mul_pow5_32(uint32_t m, uint32_t i, int32_t j) {
+  return rae_f2t_mul_shift32(m, rae_f2t_pow5[i][1], j);
+}
+
+/* Float32 version of rae_f2t_d2d, on the high words of the same tables. */
+static RaeDecimal rae_f2t_f2d(uint32_t ieee_mantissa, uint32_t ieee_exponent) {
+  int32_t e2;
+  uint32_t m2;
+  if (ieee_exponent == 0) {
+    e2 = 1 - 127 - 23 - 2;
+    m2 = ieee_mantissa;
+  } else {
+    e2 = (int32_t)ieee_exponent - 127 - 23 - 2;
+    m2 = (1u << 23) | ieee_mantissa;
+  }
+  const int accept_bounds = (m2 & 1) == 0;
+  const uint32_t mv = 4 * m2;
+  const uint32_t mp = 4 * m2 + 2;
+  const uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+  const uint32_t mm = 4 * m2 - 1 - mm_shift;
+
+  uint32_t vr, vp, vm;
+  int32_t e10;
+  int vm_trailing_zeros = 0;
+  int vr_trailing_zeros = 0;
+  uint8_t last_removed = 0;
+  if (e2 >= 0) {
+    const uint32_t q = rae_f2t_log10_pow2(e2);
+    e10 = (int32_t)q;
+    const int32_t k = RAE_F2T_BITCOUNT32 + rae_f2t_pow5bits((int32_t)q) - 1;
+    const int32_t i = -e2 + (int32_t)q + k;
+    vr = rae_f2t_mul_pow5_inv32(mv, q, i);
+    vp = rae_f2t_mul_pow5_inv32(mp, q, i);
+    vm = rae_f2t_mul_pow5_inv32(mm, q, i);
+    if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+      /* The loop below removes no digit, so compute the one just past vr. */
+      const int32_t l = RAE_F2T_BITCOUNT32 + rae_f2t_pow5bits((int32_t)(q - 1)) - 1;
+      last_removed = (uint8_t)(rae_f2t_mul_pow5_inv32(mv, q - 1, -e2 + (int32_t)q - 1 + l) % 10);
+    }
+    if (q <= 9) {
+      if (mv % 5 == 0) {
+        vr_trailing_zeros = rae_f2t_multiple_of_pow5(mv, q);
+      } else if (accept_bounds) {
+        vm_trailing_zeros = rae_f2t_multiple_of_pow5(mm, q);
+      } else {
+        vp -= rae_f2t_multiple_of_pow5(mp, q);
+      }
+    }
+  } else {
+    const uint32_t q = rae_f2t_log10_pow5(-e2);
+    e10 = (int32_t)q + e2;
+    const int32_t i = -e2 - (int32_t)q;
+    const int32_t k = rae_f2t_pow5bits(i) - RAE_F2T_BITCOUNT32;
+    int32_t j = (int32_t)q - k;
+    vr = rae_f2t_mul_pow5_32(mv, (uint32_t)i, j);
+    vp = rae_f2t_mul_pow5_32(mp, (uint32_t)i, j);
+    vm = rae_f2t_mul_pow5_32(mm, (uint32_t)i, j);
+    if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+      j = (int32_t)q - 1 - (rae_f2t_pow5bits(i + 1) - RAE_F2T_BITCOUNT32);
+      last_removed = (uint8_t)(rae_f2t_mul_pow5_32(mv, (uint32_t)(i + 1), j) % 10);
+    }
+    if (q <= 1) {
+      vr_trailing_zeros = 1;
+      if (accept_bounds) {
+        vm_trailing_zeros = mm_shift == 1;
+      } else {
+        --vp;
+      }
+    } else if (q < 31) {
+      vr_trailing_zeros = rae_f2t_multiple_of_pow2(mv, q - 1);
+    }
+  }
+
+  int32_t removed = 0;
+  uint32_t output;
+  if (vm_trailing_zeros || vr_trailing_zeros) {
+    while (vp / 10 > vm / 10) {
+      vm_trailing_zeros &= vm % 10 == 0;
+      vr_trailing_zeros &= last_removed == 0;
+      last_removed = (uint8_t)(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+    if (vm_trailing_zeros) {
+      while (vm % 10 == 0) {
+        vr_trailing_zeros &= last_removed == 0;
+        last_removed = (uint8_t)(vr % 10);
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+        ++removed;
+      }
+    }
+    if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+      last_removed = 4;
+    }
+    output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+  } else {
+    while (vp / 10 > vm / 10) {
+      last_removed = (uint8_t)(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+    output = vr + (vr == vm || last_removed >= 5);
+  }
+  return (RaeDecimal){output, e10 + removed};
+}
+
+/* ----- Layout ----- */
+
+static int rae_f2t_special(char* out, int negative, int is_nan) {
+  if (is_nan) {
+    memcpy(out, "nan", 3);
+    return 3;
+  }
+  if (negative) {
+    memcpy(out, "-inf", 4);
+    return 4;
+  }
+  memcpy(out, "inf", 3);
+  return 3;
+}
+
+static const char rae_f2t_pairs[201] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+static inline int rae_f2t_decimal_length(uint64_t v) {
+  static const uint64_t pow10[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+  };
+  if (v < 10) return 1;
+  const int t = ((64 - __builtin_clzll(v)) * 1233) >> 12; /* floor(log10(2^bits)) */
+  return t + (v >= pow10[t]);
+}
+
+/* Writes the digits of d backwards, ending just before `end`. Eight at a
+ * time in 32-bit arithmetic, two per table load. */
+static void rae_f2t_write_digits(char* end, uint64_t d) {
+  char* p = end;
+  while (d >> 32) {
+    const uint64_t q = d / 100000000;
+    uint32_t r = (uint32_t)(d - 100000000 * q);
+    d = q;
+    for (int k = 0; k < 4; k++) {
+      p -= 2;
+      memcpy(p, rae_f2t_pairs + (r % 100) * 2, 2);
+      r /= 100;
+    }
+  }
+  uint32_t r = (uint32_t)d;
+  while (r >= 100) {
+    p -= 2;
+    memcpy(p, rae_f2t_pairs + (r % 100) * 2, 2);
+    r /= 100;
+  }
+  if (r >= 10) {
+    memcpy(p - 2, rae_f2t_pairs + r * 2, 2);
+  } else {
+    p[-1] = (char)('0' + r);
+  }
+}
+
+/* Digits of d at out, most significant first; returns the count. */
+static int rae_f2t_digits(char* out, uint64_t d) {
+  const int n = rae_f2t_decimal_length(d);
+  rae_f2t_write_digits(out + n, d);
+  return n;
+}
+
+/* Writes "e+X" / "e-X"; returns the length. */
+static int rae_f2t_exponent(char* out, int32_t e) {
+  int len = 0;
+  out[len++] = 'e';
+  out[len++] = e < 0 ? '-' : '+';
+  return len + rae_f2t_digits(out + len, (uint64_t)(e < 0 ? -e : e));
+}
+
+/* digits * 10^exp as Rae prints it; out holds 32 bytes. Digits are
+ * written straight into place. */
+static int rae_f2t_layout(char* out, int negative, RaeDecimal dec) {
+  char* o = out;
+  if (negative) *o++ = '-';
+  const int n = rae_f2t_decimal_length(dec.digits);
+  const int32_t pt = n + dec.exp; /* decimal point sits after digit pt */
+  if (n <= pt && pt <= 21) {
+    rae_f2t_write_digits(o + n, dec.digits);
+    memset(o + n, '0', (size_t)(pt - n));
+    return negative + pt;
+  }
+  if (0 < pt && pt <= 21) {
+    /* Write one place to the right, then pull the integer digits back
+     * over the gap the point goes into. */
+    rae_f2t_write_digits(o + n + 1, dec.digits);
+    memmove(o, o + 1, (size_t)pt);
+    o[pt] = '.';
+    return negative + n + 1;
+  }
+  if (-6 < pt && pt <= 0) {
+    o[0] = '0';
+    o[1] = '.';
+    memset(o + 2, '0', (size_t)-pt);
+    rae_f2t_write_digits(o + 2 - pt + n, dec.digits);
+    return negative + 2 - pt + n;
+  }
+  rae_f2t_write_digits(o + n + 1, dec.digits);
+  o[0] = o[1];
+  int len = 1;
+  if (n > 1) {
+    o[1] = '.';
+    len = n + 1;
+  }
+  return negative + len + rae_f2t_exponent(o + len, pt - 1);
+}
+
+/* Shortest text that reads back as v; out holds 32 bytes. */
+int rae_format_f64(char* out, double v) {
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof bits);
+  const int negative = (int)(bits >> 63);
+  const uint64_t mantissa = bits & ((1ull << 52) - 1);
+  const uint32_t exponent = (uint32_t)((bits >> 52) & 0x7FF);
+  if (exponent == 0x7FF) return rae_f2t_special(out, negative, mantissa != 0);
+  if (exponent == 0 && mantissa == 0) {
+    if (negative) {
+      memcpy(out, "-0", 2);
+      return 2;
+    }
+    out[0] = '0';
+    return 1;
+  }
+#ifdef __SIZEOF_INT128__
+  /* Integers below 2^53 need no search: strip the trailing zeros. */
+  const int32_t e2 = (int32_t)exponent - 1023 - 52;
+  if (exponent != 0 && e2 <= 0 && e2 >= -52) {
+    const uint64_t m2 = (1ull << 52) | mantissa;
+    if ((m2 & ((1ull << -e2) - 1)) == 0) {
+      RaeDecimal dec = {m2 >> -e2, 0};
+      while (dec.digits % 10 == 0) {
+        dec.digits /= 10;
+        dec.exp++;
+      }
+      return rae_f2t_layout(out, negative, dec);
+    }
+  }
+  return rae_f2t_layout(out, negative, rae_f2t_d2d(mantissa, exponent));
+#else
+  /* No 128-bit multiply: probe precisions until one reads back. */
+  for (int p = 1; p <= 17; p++) {
+    char tmp[40];
+    snprintf(tmp, sizeof tmp, "%.*e", p - 1, v);
+    if (p == 17 || strtod(tmp, NULL) == v) {
+      char* e = strchr(tmp, 'e');
+      RaeDecimal dec = {0, atoi(e + 1) - (p - 1)};
+      for (char* c = tmp; c < e; c++) {
+        if (*c >= '0' && *c <= '9') dec.digits = dec.digits * 10 + (uint64_t)(*c - '0');
+      }
+      while (dec.digits % 10 == 0) {
+        dec.digits /= 10;
+        dec.exp++;
+      }
+      return rae_f2t_layout(out, negative, dec);
+    }
+  }
+  return 0;
+#endif
+}
+
+/* Shortest text that reads back as the Float32 v (so 0.1f prints "0.1",
+ * not the double 0.10000000149011612); out holds 32 bytes. */
+int rae_format_f32(char* out, float v) {
+  uint32_t bits;
+  memcpy(&bits, &v, sizeof bits);
+  const int negative = (int)(bits >> 31);
+  const uint32_t mantissa = bits & ((1u << 23) - 1);
+  const uint32_t exponent = (bits >> 23) & 0xFF;
+  if (exponent == 0xFF) return rae_f2t_special(out, negative, mantissa != 0);
+  if (exponent == 0 && mantissa == 0) return rae_format_f64(out, (double)v);
+  return rae_f2t_layout(out, negative, rae_f2t_f2d(mantissa, exponent));
+}
+
+static const double rae_f2t_exact_pow10[23] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/* v with exactly `digits` (0..100) digits after the point, rounded half to
+ * even on v's exact binary value like printf("%.*f"). out holds
+ * RAE_FLOAT_FIXED_MAX bytes; values of 1e21 and up print as rae_format_f64. */
+int rae_format_f64_fixed(char* out, double v, int digits) {
+  if (digits < 0) digits = 0;
+  if (digits > 100) digits = 100;
+  if (isnan(v) || isinf(v) || fabs(v) >= 1e21) return rae_format_f64(out, v);
+  if (digits <= 22) {
+    /* v * 10^digits = p + err exactly (the power is exact, fma recovers
+     * the product's rounding error). Below 2^51 every half-integer is a
+     * double, so rint(p) is only off on an exact .5 that err breaks. */
+    const double scale = rae_f2t_exact_pow10[digits];
+    const double p = v * scale;
+    if (fabs(p) < 2251799813685248.0) {
+      const double err = fma(v, scale, -p);
+      double r = rint(p);
+      const double d0 = p - r;
+      if (d0 == 0.5 && err > 0) r += 1.0;
+      if (d0 == -0.5 && err < 0) r -= 1.0;
+      char tmp[32];
+      int n = rae_f2t_digits(tmp, (uint64_t)fabs(r));
+      int len = 0;
+      if (signbit(v)) out[len++] = '-';
+      if (n <= digits) {
+        /* 0.00ddd: pad the integer with leading zeros. */
+        memmove(tmp + (digits + 1 - n), tmp, (size_t)n);
+        memset(tmp, '0', (size_t)(digits + 1 - n));
+        n = digits + 1;
+      }
+      memcpy(out + len, tmp, (size_t)(n - digits));
+      len += n - digits;
+      if (digits > 0) {
+        out[len++] = '.';
+        memcpy(out + len, tmp + n - digits, (size_t)digits);
+        len += digits;
+      }
+      return len;
+    }
+  }
+  return snprintf(out, RAE_FLOAT_FIXED_MAX, "%.*f", digits, v);
+}
+
+/* v as d.ddd...e+X with `digits` (0..100) digits after the point, correctly
+ * rounded; out holds RAE_FLOAT_FIXED_MAX bytes. */
+int rae_format_f64_exp(char* out, double v, int digits) {
+  if (digits < 0) digits = 0;
+  if (digits > 100) digits = 100;
+  if (isnan(v) || isinf(v)) return rae_format_f64(out, v);
+  char mant[RAE_FLOAT_FIXED_MAX];
+  int n;
+  int32_t e;
+  const int negative = signbit(v) != 0;
+  if (v == 0) {
+    memset(mant, '0', (size_t)digits + 1);
+    n = digits + 1;
+    e = 0;
+  } else {
+    char sd[20];
+    RaeDecimal dec = {0, 0};
+    int shortest = 0;
+#ifdef __SIZEOF_INT128__
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    dec = rae_f2t_d2d(bits & ((1ull << 52) - 1), (uint32_t)((bits >> 52) & 0x7FF));
+    shortest = rae_f2t_digits(sd, dec.digits);
+#endif
+    if (shortest > 0 && shortest <= digits + 1 && digits + 1 <= 15) {
+      /* Up to 15 significant digits, the shortest digits padded with
+       * zeros are the correctly rounded answer. */
+      memcpy(mant, sd, (size_t)shortest);
+      memset(mant + shortest, '0', (size_t)(digits + 1 - shortest));
+      n = digits + 1;
+      e = shortest + dec.exp - 1;
+    } else {
+      char tmp[RAE_FLOAT_FIXED_MAX + 16];
+      snprintf(tmp, sizeof tmp, "%.*e", digits, fabs(v));
+      const char* x = strchr(tmp, 'e');
+      n = 0;
+      for (const char* c = tmp; c < x; c++) {
+        if (*c != '.') mant[n++] = *c;
+      }
+      e = (int32_t)atoi(x + 1);
+    }
+  }
+  int len = 0;
+  if (negative) out[len++] = '-';
+  out[len++] = mant[0];
+  if (n > 1) {
+    out[len++] = '.';
+    memcpy(out + len, mant + 1, (size_t)(n - 1));
+    len += n - 1;
+  }
+  return len + rae_f2t_exponent(out + len, e);
+}
+
+/* ----- Parsing ----- */
+
+static inline int rae_t2f_is_digit(uint8_t c) {
+  return (unsigned)(c - '0') < 10;
+}
+
+/* A decimal number as scanned: w * 10^q, or inf/nan. */
+typedef struct {
+  uint64_t w;
+  int64_t q;
+  int negative;
+  int truncated; /* nonzero digits past the 19 kept in w */
+  int special;   /* 0 number, 1 inf, 2 nan */
+} RaeDecimalText;
+
+/* Scans the number at the start of s[0, len): an optional sign, digits
+ * with an optional fraction (".5" and "5." included) and exponent, or
+ * inf, infinity and nan in any case. Returns the index just past it, or 0
+ * when there is none. No terminator is read. */
+static int64_t rae_t2f_scan(const uint8_t* s, int64_t len, RaeDecimalText* d) {
+  memset(d, 0, sizeof *d);
+  if (!s || len <= 0) return 0;
+  int64_t i = 0;
+  d->negative = s[0] == '-';
+  if (s[0] == '-' || s[0] == '+') i++;
+
+  if (i < len && ((s[i] | 0x20) == 'i' || (s[i] | 0x20) == 'n')) {
+    static const char* const words[3] = {"infinity", "inf", "nan"};
+    for (int k = 0; k < 3; k++) {
+      const int64_t wl = (int64_t)strlen(words[k]);
+      if (len - i < wl) continue;
+      int64_t m = 0;
+      while (m < wl && (s[i + m] | 0x20) == words[k][m]) m++;
+      if (m < wl) continue;
+      d->special = k == 2 ? 2 : 1;
+      return i + wl;
+    }
+    return 0;
+  }
+
+  /* Up to 19 significant digits go into w; the rest only move q. Locals
+   * rather than d's fields, which byte reads of s would alias. */
+  uint64_t w = 0;
+  int64_t q = 0;
+  int truncated = 0;
+  int taken = 0;
+  int any_digit = 0;
+  for (; i < len && rae_t2f_is_digit(s[i]); i++) {
+    const uint8_t c = (uint8_t)(s[i] - '0');
+    any_digit = 1;
+    if (w == 0 && c == 0) continue;
+    if (taken < 19) {
+      w = w * 10 + c;
+      taken++;
+    } else {
+      q++;
+      truncated |= c != 0;
+    }
+  }
+  if (i < len && s[i] == '.') {
+    const int64_t dot = i++;
+    for (; i < len && rae_t2f_is_digit(s[i]); i++) {
+      const uint8_t c = (uint8_t)(s[i] - '0');
+      any_digit = 1;
+      if (w == 0 && c == 0) {
+        q--;
+        continue;
+      }
+      if (taken < 19) {
+        w = w * 10 + c;
+        taken++;
+        q--;
+      } else {
+        truncated |= c != 0;
+      }
+    }
+    if (!any_digit) i = dot;
+  }
+  if (!any_digit) return 0;
+
+  if (i < len && (s[i] | 0x20) == 'e') {
+    int64_t j = i + 1;
+    const int exp_negative = j < len && s[j] == '-';
+    if (j < len && (s[j] == '-' || s[j] == '+')) j++;
+    if (j < len && rae_t2f_is_digit(s[j])) {
+      int64_t e = 0;
+      for (; j < len && rae_t2f_is_digit(s[j]); j++) {
+        if (e < 100000) e = e * 10 + (s[j] - '0');
+      }
+      q += exp_negative ? -e : e;
+      i = j;
+    }
+  }
+  d->w = w;
+  d->q = q;
+  d->truncated = truncated;
+  return i;
+}
+
+/* The bits of w * 10^q rounded to a float with `mbits` explicit mantissa
+ * bits, when the 128-bit product settles the rounding (Lemire, "Number
+ * Parsing at a Gigabyte per Second", 2021). Returns 0 when it can't
+ * decide: halfway cases, subnormals, overflow. */
+static int rae_t2f_eisel_lemire(uint64_t w, int64_t q, int mbits, uint64_t* bits) {
+#ifdef __SIZEOF_INT128__
+  if (q < -348 || q > 347) return 0;
+  const uint64_t* pow10 = rae_t2f_pow5[q + 348];
+  const int ebits = mbits == 52 ? 11 : 8;
+  const uint64_t bias = ((uint64_t)1 << (ebits - 1)) - 1;
+  const uint64_t max_exp = ((uint64_t)1 << ebits) - 1;
+  const int low_bits = 64 - (mbits + 1) - 2; /* below the mantissa and round bit */
+  const uint64_t low_mask = ((uint64_t)1 << low_bits) - 1;
+
+  const int clz = __builtin_clzll(w);
+  w <<= clz;
+  uint64_t exp2 = (uint64_t)((((int64_t)217706 * q) >> 16) + 64 + (int64_t)bias) - (uint64_t)clz;
+
+  rae_u128 x = (rae_u128)w * pow10[1];
+  uint64_t x_hi = (uint64_t)(x >> 64);
+  uint64_t x_lo = (uint64_t)x;
+  if ((x_hi & low_mask) == low_mask && x_lo + w < w) {
+    /* The truncated table entry may have cost a carry: widen. */
+    rae_u128 y = (rae_u128)w * pow10[0];
+    const uint64_t y_hi = (uint64_t)(y >> 64);
+    const uint64_t y_lo = (uint64_t)y;
+    uint64_t merged_hi = x_hi;
+    const uint64_t merged_lo = x_lo + y_hi;
+    if (merged_lo < x_lo) merged_hi++;
+    if ((merged_hi & low_mask) == low_mask && merged_lo + 1 == 0 && y_lo + w < w) return 0;
+    x_hi = merged_hi;
+    x_lo = merged_lo;
+  }
+
+  const uint64_t msb = x_hi >> 63;
+  uint64_t mantissa = x_hi >> (msb + (uint64_t)low_bits);
+  exp2 -= 1 ^ msb;
+  if (x_lo == 0 && (x_hi & low_mask) == 0 && (mantissa & 3) == 1) return 0;
+
+  mantissa += mantissa & 1;
+  mantissa >>= 1;
+  if (mantissa >> (mbits + 1)) {
+    mantissa >>= 1;
+    exp2++;
+  }
+  if (exp2 - 1 >= max_exp - 1) return 0;
+  *bits = exp2 << mbits | (mantissa & (((uint64_t)1 << mbits) - 1));
+  return 1;
+#else
+  (void)w; (void)q; (void)mbits; (void)bits;
+  return 0;
+#endif
+}
+
+/* Decides w * 10^q (or its truncated range [w, w + 1] * 10^q) for a
+ * float with `mbits` mantissa bits; 0 leaves it to strtod/strtof. */
+static int rae_t2f_decide(const RaeDecimalText* d, int mbits, uint64_t* bits) {
+  if (!d->truncated) return rae_t2f_eisel_lemire(d->w, d->q, mbits, bits);
+  uint64_t hi;
+  return rae_t2f_eisel_lemire(d->w, d->q, mbits, bits) &&
+         rae_t2f_eisel_lemire(d->w + 1, d->q, mbits, &hi) && *bits == hi;
+}
+
+/* strtod/strtof on a terminated copy of exactly the scanned number. */
+static double rae_t2f_fallback(const uint8_t* s, int64_t end, int single) {
+  char stack[128];
+  char* copy = end < (int64_t)sizeof stack ? stack : malloc((size_t)end + 1);
+  if (!copy) return 0.0;
+  memcpy(copy, s, (size_t)end);
+  copy[end] = '\0';
+  const double v = single ? (double)strtof(copy, NULL) : strtod(copy, NULL);
+  if (copy != stack) free(copy);
+  return v;
+}
+
+/* The correctly rounded double nearest to the number at the start of
+ * s[0, len) (see rae_t2f_scan for the syntax), 0 when there is none.
+ * Returns the index just past the number. */
+int64_t rae_parse_f64(const uint8_t* s, int64_t len, double* out) {
+  RaeDecimalText d;
+  const int64_t end = rae_t2f_scan(s, len, &d);
+  *out = 0.0;
+  if (end == 0) return 0;
+  double v;
+  uint64_t bits;
+  if (d.special) {
+    v = d.special == 2 ? NAN : INFINITY;
+  } else if (d.w == 0 || d.q < -348 - 19) {
+    v = 0.0;
+  } else if (d.q > 347) {
+    v = INFINITY;
+  } else if (!d.truncated && d.q >= -22 && d.q <= 22 && d.w <= (1ull << 53)) {
+    /* Clinger: both operands exact, so a single rounding. */
+    v = d.q < 0 ? (double)d.w / rae_f2t_exact_pow10[-d.q] : (double)d.w * rae_f2t_exact_pow10[d.q];
+  } else if (rae_t2f_decide(&d, 52, &bits)) {
+    memcpy(&v, &bits, sizeof v);
+  } else {
+    *out = rae_t2f_fallback(s, end, 0);
+    return end;
+  }
+  *out = d.negative ? -v : v;
+  return end;
+}
+
+/* Float32 version of rae_parse_f64, rounded once from the decimal (going
+ * through double would round twice). */
+int64_t rae_parse_f32(const uint8_t* s, int64_t len, float* out) {
+  RaeDecimalText d;
+  const int64_t end = rae_t2f_scan(s, len, &d);
+  *out = 0.0f;
+  if (end == 0) return 0;
+  float v;
+  uint64_t bits;
+  if (d.special) {
+    v = d.special == 2 ? NAN : INFINITY;
+  } else if (d.w == 0 || d.q < -348 - 19) {
+    v = 0.0f;
+  } else if (d.q > 347) {
+    v = INFINITY;
+  } else if (!d.truncated && d.q >= -10 && d.q <= 10 && d.w <= (1ull << 24)) {
+    const float p = (float)rae_f2t_exact_pow10[d.q < 0 ? -d.q : d.q];
+    v = d.q < 0 ? (float)d.w / p : (float)d.w * p;
+  } else if (rae_t2f_decide(&d, 23, &bits)) {
+    const uint32_t b32 = (uint32_t)bits;
+    memcpy(&v, &b32, sizeof v);
+  } else {
+    *out = (float)rae_t2f_fallback(s, end, 1);
+    return end;
+  }
+  *out = d.negative ? -v : v;
+  return end;
+}
+
+/* The Int in s[0, len): an optional sign and decimal digits. Stops at the
+ * first byte that is not part of it, including a digit that would
+ * overflow (the value then saturates). Returns that index; 0 when s
+ * doesn't start with a number. */
+int64_t rae_parse_i64(const uint8_t* s, int64_t len, int64_t* out) {
+  *out = 0;
+  if (!s || len <= 0) return 0;
+  int64_t i = 0;
+  const int negative = s[0] == '-';
+  if (s[0] == '-' || s[0] == '+') i++;
+  const uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+  const int64_t first = i;
+  uint64_t v = 0;
+  for (; i < len && rae_t2f_is_digit(s[i]); i++) {
+    const uint64_t d = (uint64_t)(s[i] - '0');
+    if (v > (limit - d) / 10) {
+      v = limit;
+      break;
+    }
+    v = v * 10 + d;
+  }
+  if (i == first) return 0;
+  *out = negative ? (int64_t)(0 - v) : (int64_t)v;
+  return i;
+}
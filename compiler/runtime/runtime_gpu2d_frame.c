@@ -18,7 +18,7 @@ void rae_g2d_frame_reset(void) {
     for (int i = 0; i < RAE_SDF_MAX_ATLAS; i++) g_g2d_text_count[i] = 0;
     g_g2d_img_cmd_count = 0;
     rae_g2d_clip_reset();
-    g_g2d_img_frame_bind_n = 0;
+    g_g2d_img_frame_buf_n = 0;
     g_g2d_frame_buf_n = 0;
     g_g2d_frame_bind_n = 0;
     g_g2d_box_frame_buf_n = 0;
@@ -111,9 +111,11 @@ void rae_g2d_present_and_cleanup(void) {
     g_g2d_frame_bind_n = 0;
     for (int i = 0; i < g_g2d_frame_buf_n; i++) wgpuBufferRelease(g_g2d_frame_bufs[i]);
     g_g2d_frame_buf_n = 0;
-    /* Per-image bind groups are cached by draw slot + texture handle.
-     * They stay alive across frames and are released at gpu2d shutdown. */
-    g_g2d_img_frame_bind_n = 0;
+    /* This frame's submission counters become the last-frame totals. */
+    g_g2d_last_stat[0] = g_g2d_stat_draws;     g_g2d_stat_draws = 0;
+    g_g2d_last_stat[1] = g_g2d_stat_binds;     g_g2d_stat_binds = 0;
+    g_g2d_last_stat[2] = g_g2d_stat_pipelines; g_g2d_stat_pipelines = 0;
+    g_g2d_last_stat[3] = g_g2d_stat_images;    g_g2d_stat_images = 0;
     g_g2d_pass = NULL;
     g_g2d_enc = NULL;
 
@@ -208,6 +210,7 @@ void rae_ext_gpu2d_flush(void) {
                              (size_t)g_g2d_prim_count * G2D_PRIM_FLOATS * sizeof(float));
         WGPUBindGroupLayout bgl = wgpuRenderPipelineGetBindGroupLayout(g_g2d_pipeline, 0);
         wgpuRenderPassEncoderSetPipeline(g_g2d_pass, g_g2d_pipeline);
+        g_g2d_stat_pipelines++;
         /* Draw contiguous same-clip runs. Each run sets the scissor (#144, the
          * axis-aligned bbox cull) and binds a per-run clip uniform (#118, the
          * rounded-corner SDF applied in the fragment shader). instance_index in
@@ -240,6 +243,8 @@ void rae_ext_gpu2d_flush(void) {
             rae_g2d_set_scissor(clip);
             wgpuRenderPassEncoderSetBindGroup(g_g2d_pass, 0, bind, 0, NULL);
             wgpuRenderPassEncoderDraw(g_g2d_pass, 6, (uint32_t)(be - bs), 0, (uint32_t)bs);
+            g_g2d_stat_binds++;
+            g_g2d_stat_draws++;
             bs = be;
         }
         wgpuBindGroupLayoutRelease(bgl);
@@ -252,6 +257,7 @@ void rae_ext_gpu2d_flush(void) {
          * and the Material-icon atlas coexist). */
         rae_g2d_init_text_pipeline();
         wgpuRenderPassEncoderSetPipeline(g_g2d_pass, g_g2d_text_pipeline);
+        g_g2d_stat_pipelines++;
         for (int ai = 0; ai < RAE_SDF_MAX_ATLAS; ai++) {
             if (g_g2d_text_count[ai] <= 0) continue;
             if (!rae_g2d_atlas_texview(ai + 1)) continue;
@@ -272,6 +278,7 @@ void rae_ext_gpu2d_flush(void) {
             wgpuBindGroupLayoutRelease(bgl);
             rae_g2d_keep_frame_bind(bind);
             wgpuRenderPassEncoderSetBindGroup(g_g2d_pass, 0, bind, 0, NULL);
+            g_g2d_stat_binds++;
             int cnt = g_g2d_text_count[ai];
             int* tclip = g_g2d_text_clip[ai];
             int tcap = g_g2d_text_clip_cap[ai];
@@ -286,6 +293,7 @@ void rae_ext_gpu2d_flush(void) {
                 }
                 rae_g2d_set_scissor(clip);
                 wgpuRenderPassEncoderDraw(g_g2d_pass, 6, (uint32_t)(te - ts), 0, (uint32_t)ts);
+                g_g2d_stat_draws++;
                 ts = te;
             }
             g_g2d_text_count[ai] = 0;
@@ -293,6 +301,13 @@ void rae_ext_gpu2d_flush(void) {
     }
 }
 
+/* What the last presented frame submitted (#036): 0 draw calls, 1 bind
+ * group binds, 2 pipeline switches, 3 image instances. */
+int64_t rae_ext_gpu2d_frameStat(int64_t which) {
+    if (which < 0 || which > 3) return 0;
+    return g_g2d_last_stat[which];
+}
+
 void rae_ext_gpu2d_closeWindow(void) {
     if (g_g2d_off_view) { wgpuTextureViewRelease(g_g2d_off_view); g_g2d_off_view = NULL; }
     if (g_g2d_off_tex)  { wgpuTextureRelease(g_g2d_off_tex);  g_g2d_off_tex = NULL; }
@@ -336,18 +351,33 @@ void rae_ext_gpu2d_closeWindow(void) {
         g_g2d_text_frame_buf_n[ai] = 0; g_g2d_text_frame_buf_slots[ai] = 0;
     }
     /* Image pipeline + textures. */
-    for (int i = 0; i < g_g2d_img_frame_bind_cap; i++) {
-        if (g_g2d_img_frame_binds[i]) wgpuBindGroupRelease(g_g2d_img_frame_binds[i]);
+    for (int i = 0; i < g_g2d_img_frame_buf_slots; i++) {
+        if (g_g2d_img_frame_bufs[i]) wgpuBufferRelease(g_g2d_img_frame_bufs[i]);
     }
-    g_g2d_img_frame_bind_n = 0;
-    if (g_g2d_img_frame_binds) { free(g_g2d_img_frame_binds); g_g2d_img_frame_binds = NULL; g_g2d_img_frame_bind_cap = 0; }
-    if (g_g2d_img_frame_handles) { free(g_g2d_img_frame_handles); g_g2d_img_frame_handles = NULL; }
-    for (int i = 0; i < g_g2d_img_ubuf_n; i++) if (g_g2d_img_ubuf[i]) wgpuBufferRelease(g_g2d_img_ubuf[i]);
-    if (g_g2d_img_ubuf) { free(g_g2d_img_ubuf); g_g2d_img_ubuf = NULL; g_g2d_img_ubuf_n = 0; }
+    if (g_g2d_img_frame_bufs) { free(g_g2d_img_frame_bufs); g_g2d_img_frame_bufs = NULL; }
+    if (g_g2d_img_frame_buf_cap) { free(g_g2d_img_frame_buf_cap); g_g2d_img_frame_buf_cap = NULL; }
+    g_g2d_img_frame_buf_n = 0; g_g2d_img_frame_buf_slots = 0;
+    free(g_g2d_img_order); g_g2d_img_order = NULL;
+    free(g_g2d_img_next); g_g2d_img_next = NULL;
+    free(g_g2d_img_inst); g_g2d_img_inst = NULL;
+    free(g_g2d_img_inst_tex); g_g2d_img_inst_tex = NULL;
+    free(g_g2d_img_inst_clip); g_g2d_img_inst_clip = NULL;
+    g_g2d_img_scratch_cap = 0;
+    free(g_g2d_img_batch_key); g_g2d_img_batch_key = NULL;
+    free(g_g2d_img_batch_box); g_g2d_img_batch_box = NULL;
+    free(g_g2d_img_batch_head); g_g2d_img_batch_head = NULL;
+    free(g_g2d_img_batch_tail); g_g2d_img_batch_tail = NULL;
+    g_g2d_img_batch_cap = 0;
     for (int i = 0; i < g_g2d_img_n; i++) {
         if (g_g2d_img_view[i]) { wgpuTextureViewRelease(g_g2d_img_view[i]); g_g2d_img_view[i] = NULL; }
         if (g_g2d_img_tex[i]) { wgpuTextureRelease(g_g2d_img_tex[i]); g_g2d_img_tex[i] = NULL; }
     }
+    for (int p = 0; p < g_g2d_atlas_page_n; p++) {
+        if (g_g2d_atlas_page_view[p]) { wgpuTextureViewRelease(g_g2d_atlas_page_view[p]); g_g2d_atlas_page_view[p] = NULL; }
+        if (g_g2d_atlas_page_tex[p]) { wgpuTextureRelease(g_g2d_atlas_page_tex[p]); g_g2d_atlas_page_tex[p] = NULL; }
+    }
+    g_g2d_atlas_page_n = 0;
+    g_g2d_atlas_shelf_y = 0; g_g2d_atlas_shelf_h = 0; g_g2d_atlas_cursor_x = 0;
     g_g2d_img_n = 0;
     g_g2d_img_key_n = 0;
     if (g_g2d_img_cmds) { free(g_g2d_img_cmds); g_g2d_img_cmds = NULL; g_g2d_img_cmd_cap = 0; }
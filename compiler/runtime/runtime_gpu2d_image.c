@@ -6,38 +6,51 @@
  */
 
 /* --- Image pipeline (#143): textured rounded quads -------------------
- * A third pipeline that samples a per-image RGBA texture with a tint
- * multiply and the same rounded-rect SDF mask the box pipeline uses, so
- * album covers and (white-on-alpha) Material-style icons render on the
- * GPU. Unlike box/text (one instanced draw), each image samples its OWN
- * texture, so images draw one-per-call with a per-draw uniform + bind
- * group. The image count per frame is tiny (a cover + a few icons), so
- * the per-draw bind group is cheap. Drawn after boxes, before text. */
+ * A third pipeline that samples an RGBA texture with a tint multiply and
+ * the same rounded-rect SDF mask the box pipeline uses, so album covers
+ * and (white-on-alpha) Material-style icons render on the GPU. Drawn
+ * after boxes, before text.
+ *
+ * Instanced like box/text (#036): every queued image of a flush is one
+ * ImgInst record in a per-flush storage buffer, and a run of images that
+ * share a texture and a clip is one draw. Small images (icons) are packed
+ * into shared atlas pages at upload, so a screen of icons is one texture
+ * and typically one draw. rae_g2d_plan_images groups same-state images
+ * without reordering any overlapping pair (the rule lib/draw_sort.rae's
+ * drawQueueSortOrdered implements, pinned by test 661). */
 static const char* G2D_IMG_WGSL =
+"struct ImgInst {\n"
+"  rect: vec4<f32>,\n"
+"  tint: vec4<f32>,\n"
+"  params: vec4<f32>,\n"   /* x = corner radius */
+"  uv: vec4<f32>,\n"       /* origin + size in the bound texture */
+"};\n"
 "@group(0) @binding(0) var<uniform> uXform: array<vec4<f32>, 2>;\n"
-"@group(0) @binding(1) var<uniform> uImg: array<vec4<f32>, 4>;\n"  /* rect, tint, params(radius), uv */
+"@group(0) @binding(1) var<storage, read> imgs: array<ImgInst>;\n"
 "@group(0) @binding(2) var tex: texture_2d<f32>;\n"
 "@group(0) @binding(3) var samp: sampler;\n"
 "struct VsOut {\n"
 "  @builtin(position) pos: vec4<f32>,\n"
 "  @location(0) uv: vec2<f32>,\n"
 "  @location(1) local: vec2<f32>,\n"
+"  @location(2) @interpolate(flat) inst: u32,\n"
 "};\n"
 "@vertex\n"
-"fn vs(@builtin(vertex_index) vi: u32) -> VsOut {\n"
+"fn vs(@builtin(vertex_index) vi: u32, @builtin(instance_index) ii: u32) -> VsOut {\n"
 "  var corners = array<vec2<f32>, 6>(\n"
 "    vec2<f32>(0.0,0.0), vec2<f32>(1.0,0.0), vec2<f32>(0.0,1.0),\n"
 "    vec2<f32>(0.0,1.0), vec2<f32>(1.0,0.0), vec2<f32>(1.0,1.0));\n"
 "  let c = corners[vi];\n"
-"  let rect = uImg[0];\n"
+"  let im = imgs[ii];\n"
+"  let rect = im.rect;\n"
 "  let phys = uXform[0].xy;\n"
 "  let posPx = (rect.xy + c * rect.zw) * uXform[0].zw + uXform[1].xy;\n"
 "  let ndc = vec2<f32>(posPx.x / phys.x * 2.0 - 1.0, 1.0 - posPx.y / phys.y * 2.0);\n"
 "  var o: VsOut;\n"
 "  o.pos = vec4<f32>(ndc, 0.0, 1.0);\n"
-"  let uv = uImg[3];\n"
-"  o.uv = uv.xy + c * uv.zw;\n"
+"  o.uv = im.uv.xy + c * im.uv.zw;\n"
 "  o.local = c * rect.zw;\n"
+"  o.inst = ii;\n"
 "  return o;\n"
 "}\n"
 "fn sdRoundBox(p: vec2<f32>, b: vec2<f32>, r: f32) -> f32 {\n"
@@ -46,36 +59,76 @@ static const char* G2D_IMG_WGSL =
 "}\n"
 "@fragment\n"
 "fn fs(in: VsOut) -> @location(0) vec4<f32> {\n"
+"  let im = imgs[in.inst];\n"
 "  let texel = textureSample(tex, samp, in.uv);\n"
-"  let tint = uImg[1];\n"
-"  let half = uImg[0].zw * 0.5;\n"
-"  let rad = uImg[2].x;\n"
+"  let tint = im.tint;\n"
+"  let half = im.rect.zw * 0.5;\n"
+"  let rad = im.params.x;\n"
 "  let d = sdRoundBox(in.local - half, half, rad);\n"
 "  let aa = max(fwidth(d), 0.0001);\n"
 "  let cov = 1.0 - smoothstep(-aa, aa, d);\n"
 "  let a = texel.a * tint.a * cov;\n"
 "  return vec4<f32>(texel.rgb * tint.rgb * a, a);\n"  /* premultiplied */
 "}\n";
+#define G2D_IMG_FLOATS 16
 
 #define RAE_G2D_MAX_IMG 128
-static WGPUTexture     g_g2d_img_tex[RAE_G2D_MAX_IMG];
+static WGPUTexture     g_g2d_img_tex[RAE_G2D_MAX_IMG];   /* NULL for atlas-packed images */
 static WGPUTextureView g_g2d_img_view[RAE_G2D_MAX_IMG];
 static int g_g2d_img_w[RAE_G2D_MAX_IMG];
 static int g_g2d_img_h[RAE_G2D_MAX_IMG];
+static int g_g2d_img_page[RAE_G2D_MAX_IMG];     /* atlas page, -1 = own texture */
+static float g_g2d_img_uv[RAE_G2D_MAX_IMG][4];  /* u0, v0, du, dv in its texture */
 static int g_g2d_img_n = 0;
 
+/* Small-image atlas (#036). Images no larger than RAE_G2D_ATLAS_MAX_SIDE
+ * on either side are shelf-packed into RAE_G2D_ATLAS_SIZE pages with a
+ * one-texel border copied from their edge, so linear filtering at the
+ * sub-rect edge never reads a neighbour. Bigger images (covers) keep
+ * their own texture. */
+#define RAE_G2D_ATLAS_SIZE 1024
+#define RAE_G2D_ATLAS_MAX_SIDE 128
+#define RAE_G2D_ATLAS_PAGES 8
+static WGPUTexture     g_g2d_atlas_page_tex[RAE_G2D_ATLAS_PAGES];
+static WGPUTextureView g_g2d_atlas_page_view[RAE_G2D_ATLAS_PAGES];
+static int g_g2d_atlas_page_n = 0;
+static int g_g2d_atlas_shelf_y = 0;   /* current shelf of the last page */
+static int g_g2d_atlas_shelf_h = 0;
+static int g_g2d_atlas_cursor_x = 0;
+
 typedef struct { int handle; float rect[4]; float tint[4]; float radius; float uv[4]; int clip; } RaeG2dImgCmd;
 static RaeG2dImgCmd* g_g2d_img_cmds = NULL;
 static int g_g2d_img_cmd_count = 0;
 static int g_g2d_img_cmd_cap = 0;
 
 static WGPURenderPipeline g_g2d_img_pipeline = NULL;
-static WGPUBuffer* g_g2d_img_ubuf = NULL;   /* pool of 48-byte per-draw uniforms */
-static int g_g2d_img_ubuf_n = 0;
-static WGPUBindGroup* g_g2d_img_frame_binds = NULL;  /* cached per draw slot */
-static int* g_g2d_img_frame_handles = NULL;           /* texture handle bound in each slot */
-static int g_g2d_img_frame_bind_n = 0;
-static int g_g2d_img_frame_bind_cap = 0;
+/* Flush scratch: the planned order, the packed instance floats and, per
+ * packed instance, its texture id and clip. Grown, never shrunk. */
+static int* g_g2d_img_order = NULL;
+static int* g_g2d_img_next = NULL;
+static float* g_g2d_img_inst = NULL;
+static int* g_g2d_img_inst_tex = NULL;
+static int* g_g2d_img_inst_clip = NULL;
+static int g_g2d_img_scratch_cap = 0;
+/* rae_g2d_plan_images batches: state key, bounds, first and last cmd. */
+static int64_t* g_g2d_img_batch_key = NULL;
+static float* g_g2d_img_batch_box = NULL;
+static int* g_g2d_img_batch_head = NULL;
+static int* g_g2d_img_batch_tail = NULL;
+static int g_g2d_img_batch_cap = 0;
+#define RAE_G2D_IMG_PLAN_WINDOW 64
+static WGPUBuffer* g_g2d_img_frame_bufs = NULL;      /* persistent per-flush storage buffers */
+static int* g_g2d_img_frame_buf_cap = NULL;          /* capacity in instances */
+static int g_g2d_img_frame_buf_n = 0;
+static int g_g2d_img_frame_buf_slots = 0;
+
+/* Per-frame submission counters (#036): every flush adds what it issued,
+ * present folds them into the last-frame totals gpu2d.frameStat reads. */
+static int64_t g_g2d_stat_draws = 0;
+static int64_t g_g2d_stat_binds = 0;
+static int64_t g_g2d_stat_pipelines = 0;
+static int64_t g_g2d_stat_images = 0;
+static int64_t g_g2d_last_stat[4] = {0, 0, 0, 0};
 static WGPUBuffer* g_g2d_frame_bufs = NULL;          /* transient per-flush buffers */
 static int g_g2d_frame_buf_n = 0;
 static int g_g2d_frame_buf_cap = 0;
@@ -160,85 +213,28 @@ static WGPUBuffer rae_g2d_text_frame_buffer(int ai, int glyphs) {
     return g_g2d_text_frame_bufs[ai][slot];
 }
 
-/* Read a whole file into a malloc'd buffer. Returns NULL on failure. */
-static unsigned char* rae_g2d_read_whole_file(const char* path, size_t* out_len) {
-    if (!path || !out_len) return NULL;
-    FILE* f = fopen(path, "rb");
-    if (!f) return NULL;
-    if (fseek(f, 0, SEEK_END) != 0) { fclose(f); return NULL; }
-    long sz = ftell(f);
-    if (sz <= 0) { fclose(f); return NULL; }
-    if (fseek(f, 0, SEEK_SET) != 0) { fclose(f); return NULL; }
-    unsigned char* buf = (unsigned char*)malloc((size_t)sz);
-    if (!buf) { fclose(f); return NULL; }
-    size_t got = fread(buf, 1, (size_t)sz, f);
-    fclose(f);
-    if (got != (size_t)sz) { free(buf); return NULL; }
-    *out_len = (size_t)sz;
-    return buf;
-}
-
-/* Decode an image file to RGBA8 (#228; contract + rationale in
- * docs/image-decoding-design.md): strict magic-byte dispatch, ONE
- * decoder per format, no fallback cascade.
- *   FF D8 FF     -> vendored stb_image (JPEG, every platform)
- *   89 50 4E 47  -> lodepng (PNG)
- *   anything else -> unsupported
- * Output is straight-alpha RGBA8, no colour management.
- *
- * stb is the sole JPEG decoder. macOS previously used ImageIO, but
- * ImageIO silently rendered truncated downloads half-grey (no error);
- * stb correctly rejects them, and decodes every valid file (verified
- * ok=102/102 on the cached Spotify artwork set). The truncation guard
- * below turns a partial download into a loud failure the caller can
- * evict + re-fetch, rather than a decoder-dependent glitch.
- * Returns 1 with a malloc-compatible *out_rgba on success; on
- * failure returns 0 and points *out_err at a static reason string. */
-static int rae_g2d_decode_rgba(const char* path, unsigned char** out_rgba,
-                               unsigned* out_w, unsigned* out_h,
-                               const char** out_err) {
-    *out_rgba = NULL; *out_w = 0; *out_h = 0; *out_err = "unreadable file";
-    size_t len = 0;
-    unsigned char* bytes = rae_g2d_read_whole_file(path, &len);
-    if (!bytes) return 0;
-    if (len >= 3 && bytes[0] == 0xFF && bytes[1] == 0xD8 && bytes[2] == 0xFF) {
-        /* Truncation guard: a JPEG without its EOI marker (FF D9) in
-         * the last 64 bytes is an interrupted download. Fail loudly
-         * so callers can evict the bad cache entry and re-fetch. */
-        {
-            size_t scan = len < 64 ? len : 64;
-            int has_eoi = 0;
-            for (size_t i = len - scan; i + 1 < len; i++) {
-                if (bytes[i] == 0xFF && bytes[i + 1] == 0xD9) { has_eoi = 1; break; }
-            }
-            if (!has_eoi) {
-                free(bytes);
-                *out_err = "truncated JPEG (missing EOI marker)";
-                return 0;
-            }
-        }
-        int w = 0, h = 0, comp = 0;
-        unsigned char* px = stbi_load_from_memory(bytes, (int)len, &w, &h, &comp, 4);
-        free(bytes);
-        if (!px) {
-            *out_err = stbi_failure_reason();
-            return 0;
-        }
-        *out_rgba = px; *out_w = (unsigned)w; *out_h = (unsigned)h;
-        return 1;
+static WGPUBuffer rae_g2d_img_frame_buffer(int insts) {
+    int slot = g_g2d_img_frame_buf_n++;
+    if (slot >= g_g2d_img_frame_buf_slots) {
+        int old = g_g2d_img_frame_buf_slots;
+        int cap = old ? old * 2 : 16;
+        while (cap <= slot) cap *= 2;
+        g_g2d_img_frame_bufs = (WGPUBuffer*)realloc(g_g2d_img_frame_bufs, (size_t)cap * sizeof(WGPUBuffer));
+        g_g2d_img_frame_buf_cap = (int*)realloc(g_g2d_img_frame_buf_cap, (size_t)cap * sizeof(int));
+        for (int i = old; i < cap; i++) { g_g2d_img_frame_bufs[i] = NULL; g_g2d_img_frame_buf_cap[i] = 0; }
+        g_g2d_img_frame_buf_slots = cap;
     }
-    if (len >= 4 && bytes[0] == 0x89 && bytes[1] == 0x50 && bytes[2] == 0x4E && bytes[3] == 0x47) {
-        unsigned err = lodepng_decode32(out_rgba, out_w, out_h, bytes, len);
-        free(bytes);
-        if (err) {
-            *out_err = lodepng_error_text(err);
-            return 0;
-        }
-        return 1;
+    if (!g_g2d_img_frame_bufs[slot] || g_g2d_img_frame_buf_cap[slot] < insts) {
+        if (g_g2d_img_frame_bufs[slot]) wgpuBufferRelease(g_g2d_img_frame_bufs[slot]);
+        int cap = g_g2d_img_frame_buf_cap[slot] ? g_g2d_img_frame_buf_cap[slot] : 16;
+        while (cap < insts) cap *= 2;
+        WGPUBufferDescriptor bd; memset(&bd, 0, sizeof(bd));
+        bd.size = (uint64_t)cap * G2D_IMG_FLOATS * sizeof(float);
+        bd.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
+        g_g2d_img_frame_bufs[slot] = wgpuDeviceCreateBuffer(g_wgpu_dev, &bd);
+        g_g2d_img_frame_buf_cap[slot] = cap;
     }
-    free(bytes);
-    *out_err = "unsupported format (not JPEG/PNG)";
-    return 0;
+    return g_g2d_img_frame_bufs[slot];
 }
 
 /* Device-free decode probe (#228): run the exact decode + error
@@ -251,7 +247,7 @@ int64_t rae_ext_gpu2d_decodeImageProbe(rae_String path) {
     unsigned char* rgba = NULL; unsigned uw = 0, uh = 0;
     const char* why = "decode failed";
     const char* cpath = (const char*)path.data;
-    if (!rae_g2d_decode_rgba(cpath, &rgba, &uw, &uh, &why)) {
+    if (!rae_image_decode_rgba(cpath, &rgba, &uw, &uh, &why)) {
         fprintf(stderr, "[gpu2d] image decode failed (%s): %s\n", cpath, why);
         return 0;
     }
@@ -259,36 +255,129 @@ int64_t rae_ext_gpu2d_decodeImageProbe(rae_String path) {
     return 1;
 }
 
+/* Write w*h RGBA8 bytes into `tex` at (ox, oy). */
+static void rae_g2d_write_rgba(WGPUTexture tex, unsigned ox, unsigned oy,
+                               const unsigned char* rgba, unsigned uw, unsigned uh) {
+    WGPUTexelCopyTextureInfo dst; memset(&dst, 0, sizeof(dst));
+    dst.texture = tex; dst.aspect = WGPUTextureAspect_All;
+    dst.origin.x = ox; dst.origin.y = oy;
+    WGPUTexelCopyBufferLayout layout; memset(&layout, 0, sizeof(layout));
+    layout.bytesPerRow = uw * 4; layout.rowsPerImage = uh;
+    WGPUExtent3D ext; ext.width = uw; ext.height = uh; ext.depthOrArrayLayers = 1;
+    wgpuQueueWriteTexture(g_wgpu_queue, &dst, rgba, (size_t)uw * uh * 4, &layout, &ext);
+}
+
+static WGPUTexture rae_g2d_create_rgba_texture(unsigned uw, unsigned uh) {
+    WGPUTextureDescriptor td; memset(&td, 0, sizeof(td));
+    td.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst;
+    td.dimension = WGPUTextureDimension_2D;
+    td.size.width = uw; td.size.height = uh; td.size.depthOrArrayLayers = 1;
+    td.format = WGPUTextureFormat_RGBA8Unorm; td.mipLevelCount = 1; td.sampleCount = 1;
+    return wgpuDeviceCreateTexture(g_wgpu_dev, &td);
+}
+
+/* Shelf-pack a uw x uh image (plus its one-texel border) into the last
+ * atlas page, opening a new page when it is full. Returns the page and
+ * the image's top-left texel in *ox, *oy; -1 when every page is used. */
+static int rae_g2d_atlas_place(unsigned uw, unsigned uh, unsigned* ox, unsigned* oy) {
+    int pw = (int)uw + 2, ph = (int)uh + 2;
+    if (g_g2d_atlas_page_n > 0 && g_g2d_atlas_cursor_x + pw > RAE_G2D_ATLAS_SIZE) {
+        g_g2d_atlas_shelf_y += g_g2d_atlas_shelf_h;
+        g_g2d_atlas_shelf_h = 0;
+        g_g2d_atlas_cursor_x = 0;
+    }
+    if (g_g2d_atlas_page_n == 0 || g_g2d_atlas_shelf_y + ph > RAE_G2D_ATLAS_SIZE) {
+        if (g_g2d_atlas_page_n >= RAE_G2D_ATLAS_PAGES) return -1;
+        int p = g_g2d_atlas_page_n;
+        g_g2d_atlas_page_tex[p] = rae_g2d_create_rgba_texture(RAE_G2D_ATLAS_SIZE, RAE_G2D_ATLAS_SIZE);
+        g_g2d_atlas_page_view[p] = wgpuTextureCreateView(g_g2d_atlas_page_tex[p], NULL);
+        g_g2d_atlas_page_n = p + 1;
+        g_g2d_atlas_shelf_y = 0; g_g2d_atlas_shelf_h = 0; g_g2d_atlas_cursor_x = 0;
+    }
+    *ox = (unsigned)g_g2d_atlas_cursor_x + 1u;
+    *oy = (unsigned)g_g2d_atlas_shelf_y + 1u;
+    g_g2d_atlas_cursor_x += pw;
+    if (ph > g_g2d_atlas_shelf_h) g_g2d_atlas_shelf_h = ph;
+    return g_g2d_atlas_page_n - 1;
+}
+
+/* Copy `rgba` into `page` at (ox, oy) with its edge texels repeated one
+ * texel outward. */
+static void rae_g2d_atlas_write(int page, unsigned ox, unsigned oy,
+                                const unsigned char* rgba, unsigned uw, unsigned uh) {
+    unsigned pw = uw + 2, ph = uh + 2;
+    unsigned char* padded = (unsigned char*)malloc((size_t)pw * ph * 4);
+    if (!padded) return;
+    for (unsigned y = 0; y < ph; y++) {
+        unsigned sy = y == 0 ? 0 : (y > uh ? uh - 1 : y - 1);
+        for (unsigned x = 0; x < pw; x++) {
+            unsigned sx = x == 0 ? 0 : (x > uw ? uw - 1 : x - 1);
+            memcpy(padded + ((size_t)y * pw + x) * 4, rgba + ((size_t)sy * uw + sx) * 4, 4);
+        }
+    }
+    rae_g2d_write_rgba(g_g2d_atlas_page_tex[page], ox - 1, oy - 1, padded, pw, ph);
+    free(padded);
+}
+
+/* Upload w*h top-down RGBA8 bytes; returns the 1-based handle (0 when
+ * there is no device or the table is full). Small images land in an
+ * atlas page, the rest get their own texture. Does not free `rgba`. */
+static int64_t rae_g2d_upload_rgba(const unsigned char* rgba, unsigned uw, unsigned uh) {
+    if (!rgba || !g_wgpu_dev || g_g2d_img_n >= RAE_G2D_MAX_IMG || uw == 0 || uh == 0) return 0;
+    int i = g_g2d_img_n;
+    g_g2d_img_page[i] = -1;
+    g_g2d_img_tex[i] = NULL;
+    g_g2d_img_view[i] = NULL;
+    g_g2d_img_uv[i][0] = 0.0f; g_g2d_img_uv[i][1] = 0.0f;
+    g_g2d_img_uv[i][2] = 1.0f; g_g2d_img_uv[i][3] = 1.0f;
+    if (uw <= RAE_G2D_ATLAS_MAX_SIDE && uh <= RAE_G2D_ATLAS_MAX_SIDE) {
+        unsigned ox = 0, oy = 0;
+        int page = rae_g2d_atlas_place(uw, uh, &ox, &oy);
+        if (page >= 0) {
+            rae_g2d_atlas_write(page, ox, oy, rgba, uw, uh);
+            const float inv = 1.0f / (float)RAE_G2D_ATLAS_SIZE;
+            g_g2d_img_page[i] = page;
+            g_g2d_img_uv[i][0] = (float)ox * inv; g_g2d_img_uv[i][1] = (float)oy * inv;
+            g_g2d_img_uv[i][2] = (float)uw * inv; g_g2d_img_uv[i][3] = (float)uh * inv;
+        }
+    }
+    if (g_g2d_img_page[i] < 0) {
+        WGPUTexture tex = rae_g2d_create_rgba_texture(uw, uh);
+        rae_g2d_write_rgba(tex, 0, 0, rgba, uw, uh);
+        g_g2d_img_tex[i] = tex;
+        g_g2d_img_view[i] = wgpuTextureCreateView(tex, NULL);
+    }
+    g_g2d_img_w[i] = (int)uw; g_g2d_img_h[i] = (int)uh;
+    return (int64_t)(++g_g2d_img_n);   /* 1-based */
+}
+
+/* The texture an image samples and an id for it that batching compares:
+ * the image index for its own texture, RAE_G2D_MAX_IMG + page for an
+ * atlas page. */
+static int rae_g2d_img_tex_id(int idx) {
+    return g_g2d_img_page[idx] >= 0 ? RAE_G2D_MAX_IMG + g_g2d_img_page[idx] : idx;
+}
+
+static WGPUTextureView rae_g2d_img_tex_view(int tex_id) {
+    if (tex_id >= RAE_G2D_MAX_IMG) return g_g2d_atlas_page_view[tex_id - RAE_G2D_MAX_IMG];
+    return g_g2d_img_view[tex_id];
+}
+
 /* Decode an image file and upload it as an RGBA8 texture. Decode policy
- * lives in rae_g2d_decode_rgba; a failure logs one line and returns
+ * lives in rae_image_decode_rgba; a failure logs one line and returns
  * handle 0, which callers already render as their placeholder. */
 int64_t rae_ext_gpu2d_loadImage(rae_String path) {
     if (!path.data || !g_wgpu_dev || g_g2d_img_n >= RAE_G2D_MAX_IMG) return 0;
     unsigned char* rgba = NULL; unsigned uw = 0, uh = 0;
     const char* cpath = (const char*)path.data;
     const char* why = "decode failed";
-    if (!rae_g2d_decode_rgba(cpath, &rgba, &uw, &uh, &why)) {
+    if (!rae_image_decode_rgba(cpath, &rgba, &uw, &uh, &why)) {
         fprintf(stderr, "[gpu2d] image decode failed (%s): %s\n", cpath, why);
         return 0;
     }
-    WGPUTextureDescriptor td; memset(&td, 0, sizeof(td));
-    td.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst;
-    td.dimension = WGPUTextureDimension_2D;
-    td.size.width = uw; td.size.height = uh; td.size.depthOrArrayLayers = 1;
-    td.format = WGPUTextureFormat_RGBA8Unorm; td.mipLevelCount = 1; td.sampleCount = 1;
-    WGPUTexture tex = wgpuDeviceCreateTexture(g_wgpu_dev, &td);
-    WGPUTexelCopyTextureInfo dst; memset(&dst, 0, sizeof(dst));
-    dst.texture = tex; dst.aspect = WGPUTextureAspect_All;
-    WGPUTexelCopyBufferLayout layout; memset(&layout, 0, sizeof(layout));
-    layout.bytesPerRow = uw * 4; layout.rowsPerImage = uh;
-    WGPUExtent3D ext; ext.width = uw; ext.height = uh; ext.depthOrArrayLayers = 1;
-    wgpuQueueWriteTexture(g_wgpu_queue, &dst, rgba, (size_t)uw * uh * 4, &layout, &ext);
+    int64_t h = rae_g2d_upload_rgba(rgba, uw, uh);
     free(rgba);
-    int i = g_g2d_img_n;
-    g_g2d_img_tex[i] = tex;
-    g_g2d_img_view[i] = wgpuTextureCreateView(tex, NULL);
-    g_g2d_img_w[i] = (int)uw; g_g2d_img_h[i] = (int)uh;
-    return (int64_t)(++g_g2d_img_n);   /* 1-based */
+    return h;
 }
 
 /* Name->handle registry, so a renderer can resolve a Sprite.textureKey to an
@@ -308,11 +397,9 @@ static int rae_g2d_handle_for_key(const char* k) {
     return 0;
 }
 
-/* Decode+upload `path` and register it under `key` (returns the handle, 0 on
- * failure). Re-registering a key updates it. */
-int64_t rae_ext_gpu2d_loadImageKey(rae_String key, rae_String path) {
-    int64_t h = rae_ext_gpu2d_loadImage(path);
-    if (h <= 0 || !key.data) return h;
+/* Point `key` at texture handle `h`. Re-registering a key updates it. */
+static void rae_g2d_register_key(rae_String key, int64_t h) {
+    if (h <= 0 || !key.data) return;
     int slot = -1;
     for (int i = 0; i < g_g2d_img_key_n; i++)
         if (strcmp(g_g2d_img_key[i], (const char*)key.data) == 0) { slot = i; break; }
@@ -322,6 +409,28 @@ int64_t rae_ext_gpu2d_loadImageKey(rae_String key, rae_String path) {
         g_g2d_img_key[slot][95] = '\0';
         g_g2d_img_key_handle[slot] = (int)h;
     }
+}
+
+/* Decode+upload `path` and register it under `key` (returns the handle, 0 on
+ * failure). Re-registering a key updates it. */
+int64_t rae_ext_gpu2d_loadImageKey(rae_String key, rae_String path) {
+    int64_t h = rae_ext_gpu2d_loadImage(path);
+    rae_g2d_register_key(key, h);
+    return h;
+}
+
+/* Upload an image the background asset loader already decoded (job `job`
+ * of loader `loader`, see runtime_asset_loader.c) and register it under
+ * `key`. Only the texture upload runs here, on the render thread; the
+ * decoded pixels are released either way. Returns the handle, 0 if the
+ * job did not decode or the upload failed. */
+int64_t rae_ext_gpu2d_uploadAssetImage(rae_String key, int64_t loader, int64_t job) {
+    unsigned uw = 0, uh = 0;
+    unsigned char* rgba = rae_asset_take_rgba(loader, job, &uw, &uh);
+    if (!rgba) return 0;
+    int64_t h = rae_g2d_upload_rgba(rgba, uw, uh);
+    free(rgba);
+    rae_g2d_register_key(key, h);
     return h;
 }
 
@@ -355,7 +464,11 @@ static void rae_g2d_queue_image(double x, double y, double w, double h, double r
     c->tint[2] = (float)( t        & 0xFF) / 255.0f;
     c->tint[3] = (float)((t >> 24) & 0xFF) / 255.0f;
     c->radius = (float)radius;
-    c->uv[0] = u0; c->uv[1] = v0; c->uv[2] = u1 - u0; c->uv[3] = v1 - v0;
+    /* Image-relative uv into the image's rect of its texture (identity for
+     * an image with its own texture, a sub-rect for an atlas one). */
+    const float* r = g_g2d_img_uv[handle - 1];
+    c->uv[0] = r[0] + u0 * r[2]; c->uv[1] = r[1] + v0 * r[3];
+    c->uv[2] = (u1 - u0) * r[2]; c->uv[3] = (v1 - v0) * r[3];
     c->clip = g_g2d_cur_clip;
 }
 
@@ -448,64 +561,133 @@ static void rae_g2d_init_img_pipeline(void) {
     }
 }
 
-/* Emit one draw per queued image into the active render pass. */
-static void rae_g2d_flush_images(void) {
-    if (g_g2d_img_cmd_count <= 0) return;
-    rae_g2d_init_img_pipeline();
-    /* Grow the per-draw uniform-buffer pool to cover this frame. */
-    int total_img_uniforms = g_g2d_img_frame_bind_n + g_g2d_img_cmd_count;
-    if (g_g2d_img_ubuf_n < total_img_uniforms) {
-        g_g2d_img_ubuf = (WGPUBuffer*)realloc(g_g2d_img_ubuf, (size_t)total_img_uniforms * sizeof(WGPUBuffer));
-        for (int i = g_g2d_img_ubuf_n; i < total_img_uniforms; i++) {
-            WGPUBufferDescriptor bd; memset(&bd, 0, sizeof(bd));
-            bd.size = 64; bd.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
-            g_g2d_img_ubuf[i] = wgpuDeviceCreateBuffer(g_wgpu_dev, &bd);
+static void rae_g2d_img_grow_scratch(int n) {
+    if (n <= g_g2d_img_scratch_cap) return;
+    int cap = g_g2d_img_scratch_cap ? g_g2d_img_scratch_cap : 32;
+    while (cap < n) cap *= 2;
+    g_g2d_img_order = (int*)realloc(g_g2d_img_order, (size_t)cap * sizeof(int));
+    g_g2d_img_next = (int*)realloc(g_g2d_img_next, (size_t)cap * sizeof(int));
+    g_g2d_img_inst = (float*)realloc(g_g2d_img_inst, (size_t)cap * G2D_IMG_FLOATS * sizeof(float));
+    g_g2d_img_inst_tex = (int*)realloc(g_g2d_img_inst_tex, (size_t)cap * sizeof(int));
+    g_g2d_img_inst_clip = (int*)realloc(g_g2d_img_inst_clip, (size_t)cap * sizeof(int));
+    g_g2d_img_scratch_cap = cap;
+}
+
+/* Order the queued images so same-state ones (texture, clip) sit
+ * together, fills g_g2d_img_order. An image joins the latest batch with
+ * its state when no batch after that one overlaps it, and opens a new
+ * batch otherwise, so any two overlapping images keep their submission
+ * order. Looks back at most RAE_G2D_IMG_PLAN_WINDOW batches. */
+static void rae_g2d_plan_images(int n) {
+    int nb = 0;
+    for (int i = 0; i < n; i++) {
+        RaeG2dImgCmd* c = &g_g2d_img_cmds[i];
+        int idx = c->handle - 1;
+        int64_t key = ((int64_t)rae_g2d_img_tex_id(idx) << 32) | (int64_t)(uint32_t)c->clip;
+        float x0 = c->rect[0], y0 = c->rect[1];
+        float x1 = c->rect[0] + c->rect[2], y1 = c->rect[1] + c->rect[3];
+        g_g2d_img_next[i] = -1;
+        int target = -1;
+        int stop = nb - 1 - RAE_G2D_IMG_PLAN_WINDOW;
+        if (stop < -1) stop = -1;
+        for (int b = nb - 1; b > stop; b--) {
+            if (g_g2d_img_batch_key[b] == key) { target = b; break; }
+            float* bb = &g_g2d_img_batch_box[b * 4];
+            if (x0 < bb[2] && bb[0] < x1 && y0 < bb[3] && bb[1] < y1) break;
         }
-        g_g2d_img_ubuf_n = total_img_uniforms;
-    }
-    WGPUBindGroupLayout bgl = wgpuRenderPipelineGetBindGroupLayout(g_g2d_img_pipeline, 0);
-    if (g_g2d_img_frame_bind_cap < total_img_uniforms) {
-        int old_cap = g_g2d_img_frame_bind_cap;
-        g_g2d_img_frame_binds = (WGPUBindGroup*)realloc(g_g2d_img_frame_binds, (size_t)total_img_uniforms * sizeof(WGPUBindGroup));
-        g_g2d_img_frame_handles = (int*)realloc(g_g2d_img_frame_handles, (size_t)total_img_uniforms * sizeof(int));
-        for (int i = old_cap; i < total_img_uniforms; i++) {
-            g_g2d_img_frame_binds[i] = NULL;
-            g_g2d_img_frame_handles[i] = 0;
+        if (target >= 0) {
+            g_g2d_img_next[g_g2d_img_batch_tail[target]] = i;
+            g_g2d_img_batch_tail[target] = i;
+            float* bb = &g_g2d_img_batch_box[target * 4];
+            if (x0 < bb[0]) bb[0] = x0;
+            if (y0 < bb[1]) bb[1] = y0;
+            if (x1 > bb[2]) bb[2] = x1;
+            if (y1 > bb[3]) bb[3] = y1;
+            continue;
+        }
+        if (nb + 1 > g_g2d_img_batch_cap) {
+            int cap = g_g2d_img_batch_cap ? g_g2d_img_batch_cap * 2 : 32;
+            g_g2d_img_batch_key = (int64_t*)realloc(g_g2d_img_batch_key, (size_t)cap * sizeof(int64_t));
+            g_g2d_img_batch_box = (float*)realloc(g_g2d_img_batch_box, (size_t)cap * 4 * sizeof(float));
+            g_g2d_img_batch_head = (int*)realloc(g_g2d_img_batch_head, (size_t)cap * sizeof(int));
+            g_g2d_img_batch_tail = (int*)realloc(g_g2d_img_batch_tail, (size_t)cap * sizeof(int));
+            g_g2d_img_batch_cap = cap;
         }
-        g_g2d_img_frame_bind_cap = total_img_uniforms;
+        g_g2d_img_batch_key[nb] = key;
+        g_g2d_img_batch_box[nb * 4 + 0] = x0; g_g2d_img_batch_box[nb * 4 + 1] = y0;
+        g_g2d_img_batch_box[nb * 4 + 2] = x1; g_g2d_img_batch_box[nb * 4 + 3] = y1;
+        g_g2d_img_batch_head[nb] = i;
+        g_g2d_img_batch_tail[nb] = i;
+        nb++;
     }
-    wgpuRenderPassEncoderSetPipeline(g_g2d_pass, g_g2d_img_pipeline);
-    for (int i = 0; i < g_g2d_img_cmd_count; i++) {
+    int out = 0;
+    for (int b = 0; b < nb; b++) {
+        for (int e = g_g2d_img_batch_head[b]; e >= 0; e = g_g2d_img_next[e]) g_g2d_img_order[out++] = e;
+    }
+}
+
+/* Draw the queued images into the active render pass: one storage-buffer
+ * upload, then one instanced draw per run of equal texture and clip, and
+ * a bind group only where the texture changes. */
+static void rae_g2d_flush_images(void) {
+    int n = g_g2d_img_cmd_count;
+    if (n <= 0) return;
+    rae_g2d_init_img_pipeline();
+    rae_g2d_img_grow_scratch(n);
+    /* Drop commands whose texture is gone before planning. */
+    int live = 0;
+    for (int i = 0; i < n; i++) {
         RaeG2dImgCmd* c = &g_g2d_img_cmds[i];
         int idx = c->handle - 1;
-        if (idx < 0 || idx >= g_g2d_img_n || !g_g2d_img_view[idx]) continue;
-        int uniform_slot = g_g2d_img_frame_bind_n;
-        float u[16];
+        if (idx < 0 || idx >= g_g2d_img_n) continue;
+        if (!rae_g2d_img_tex_view(rae_g2d_img_tex_id(idx))) continue;
+        if (live != i) g_g2d_img_cmds[live] = *c;
+        live++;
+    }
+    g_g2d_img_cmd_count = 0;
+    if (live == 0) return;
+    rae_g2d_plan_images(live);
+    for (int k = 0; k < live; k++) {
+        RaeG2dImgCmd* c = &g_g2d_img_cmds[g_g2d_img_order[k]];
+        float* u = &g_g2d_img_inst[(size_t)k * G2D_IMG_FLOATS];
         u[0]=c->rect[0]; u[1]=c->rect[1]; u[2]=c->rect[2]; u[3]=c->rect[3];
         u[4]=c->tint[0]; u[5]=c->tint[1]; u[6]=c->tint[2]; u[7]=c->tint[3];
         u[8]=c->radius;  u[9]=0.0f; u[10]=0.0f; u[11]=0.0f;
         u[12]=c->uv[0];  u[13]=c->uv[1]; u[14]=c->uv[2]; u[15]=c->uv[3];
-        wgpuQueueWriteBuffer(g_wgpu_queue, g_g2d_img_ubuf[uniform_slot], 0, u, sizeof(u));
-        WGPUBindGroupEntry e[4]; memset(e, 0, sizeof(e));
-        e[0].binding = 0; e[0].buffer = g_g2d_uniform; e[0].size = 32;
-        e[1].binding = 1; e[1].buffer = g_g2d_img_ubuf[uniform_slot]; e[1].size = 64;
-        e[2].binding = 2; e[2].textureView = g_g2d_img_view[idx];
-        e[3].binding = 3; e[3].sampler = g_g2d_sampler;
-        WGPUBindGroupDescriptor bgd; memset(&bgd, 0, sizeof(bgd));
-        bgd.layout = bgl; bgd.entryCount = 4; bgd.entries = e;
-        if (g_g2d_img_frame_binds[uniform_slot] == NULL ||
-            g_g2d_img_frame_handles[uniform_slot] != c->handle) {
-            if (g_g2d_img_frame_binds[uniform_slot]) wgpuBindGroupRelease(g_g2d_img_frame_binds[uniform_slot]);
-            g_g2d_img_frame_binds[uniform_slot] = wgpuDeviceCreateBindGroup(g_wgpu_dev, &bgd);
-            g_g2d_img_frame_handles[uniform_slot] = c->handle;
+        g_g2d_img_inst_tex[k] = rae_g2d_img_tex_id(c->handle - 1);
+        g_g2d_img_inst_clip[k] = c->clip;
+    }
+    WGPUBuffer instbuf = rae_g2d_img_frame_buffer(live);
+    uint64_t bytes = (uint64_t)live * G2D_IMG_FLOATS * sizeof(float);
+    wgpuQueueWriteBuffer(g_wgpu_queue, instbuf, 0, g_g2d_img_inst, (size_t)bytes);
+    WGPUBindGroupLayout bgl = wgpuRenderPipelineGetBindGroupLayout(g_g2d_img_pipeline, 0);
+    wgpuRenderPassEncoderSetPipeline(g_g2d_pass, g_g2d_img_pipeline);
+    g_g2d_stat_pipelines++;
+    int bound = -1;
+    int s = 0;
+    while (s < live) {
+        int tex = g_g2d_img_inst_tex[s], clip = g_g2d_img_inst_clip[s];
+        int e = s + 1;
+        while (e < live && g_g2d_img_inst_tex[e] == tex && g_g2d_img_inst_clip[e] == clip) e++;
+        if (tex != bound) {
+            WGPUBindGroupEntry be[4]; memset(be, 0, sizeof(be));
+            be[0].binding = 0; be[0].buffer = g_g2d_uniform; be[0].size = 32;
+            be[1].binding = 1; be[1].buffer = instbuf; be[1].size = bytes;
+            be[2].binding = 2; be[2].textureView = rae_g2d_img_tex_view(tex);
+            be[3].binding = 3; be[3].sampler = g_g2d_sampler;
+            WGPUBindGroupDescriptor bgd; memset(&bgd, 0, sizeof(bgd));
+            bgd.layout = bgl; bgd.entryCount = 4; bgd.entries = be;
+            WGPUBindGroup bind = wgpuDeviceCreateBindGroup(g_wgpu_dev, &bgd);
+            rae_g2d_keep_frame_bind(bind);
+            wgpuRenderPassEncoderSetBindGroup(g_g2d_pass, 0, bind, 0, NULL);
+            g_g2d_stat_binds++;
+            bound = tex;
         }
-        WGPUBindGroup bind = g_g2d_img_frame_binds[uniform_slot];
-        g_g2d_img_frame_bind_n++;
-        rae_g2d_set_scissor(c->clip);
-        wgpuRenderPassEncoderSetBindGroup(g_g2d_pass, 0, bind, 0, NULL);
-        wgpuRenderPassEncoderDraw(g_g2d_pass, 6, 1, 0, 0);
+        rae_g2d_set_scissor(clip);
+        wgpuRenderPassEncoderDraw(g_g2d_pass, 6, (uint32_t)(e - s), 0, (uint32_t)s);
+        g_g2d_stat_draws++;
+        s = e;
     }
+    g_g2d_stat_images += live;
     wgpuBindGroupLayoutRelease(bgl);
-    g_g2d_img_cmd_count = 0;
 }
-
@@ -11,6 +11,7 @@ void rae_ext_gpu2d_waitEvents(float timeoutSec){ (void)timeoutSec; }
 int64_t rae_ext_gpu2d_loadImage(rae_String path) { (void)path; return 0; }
 int64_t rae_ext_gpu2d_decodeImageProbe(rae_String path) { (void)path; return 0; }
 int64_t rae_ext_gpu2d_loadImageKey(rae_String key, rae_String path) { (void)key; (void)path; return 0; }
+int64_t rae_ext_gpu2d_uploadAssetImage(rae_String key, int64_t loader, int64_t job) { (void)key; rae_ext_rae_asset_release(loader, job); return 0; }
 rae_Bool rae_ext_gpu2d_hasImageKey(rae_String key) { (void)key; return 0; }
 void rae_ext_gpu2d_drawImageKey(rae_String key, float x, float y, float w, float h, float radius, int64_t tint){ (void)key; (void)x; (void)y; (void)w; (void)h; (void)radius; (void)tint; }
 void rae_ext_gpu2d_drawImageKeyScaled(rae_String key, float x, float y, float w, float h, float radius, int64_t tint, int64_t scaleMode){ (void)key; (void)x; (void)y; (void)w; (void)h; (void)radius; (void)tint; (void)scaleMode; }
@@ -54,6 +55,7 @@ void rae_g2d_present_and_cleanup(void) {}
 void rae_g2d_tick(void) {}
 rae_Bool rae_ext_gpu2d_lastPresentOk(void) { return 0; }
 void rae_ext_gpu2d_flush(void) {}
+int64_t rae_ext_gpu2d_frameStat(int64_t which) { (void)which; return 0; }
 void rae_ext_gpu2d_closeWindow(void) {}
 void rae_ext_gpu2d_drawRect(float x, float y, float w, float h, int64_t color){ (void)x; (void)y; (void)w; (void)h; (void)color; }
 void rae_ext_gpu2d_drawRoundedRect(float x, float y, float w, float h, float radius, int64_t color){ (void)x; (void)y; (void)w; (void)h; (void)radius; (void)color; }
@@ -0,0 +1,958 @@
+/* Sampling heap profiler kernel (lib/heap_profile.rae).
+ *
+ * This module is included by rae_runtime.c into one translation unit.
+ */
+
+/* ----- Heap profiler --------------------------------------------------- */
+/* Built on the allocation site tags in runtime_core_memory.c: every String
+ * body and List/Buffer allocation already funnels through rae_mem_str_tag
+ * or rae_ext_rae_buf_alloc/resize, which hand the pointer, size and tag to
+ * rae_heap_note_alloc. Each thread counts bytes down from an exponentially
+ * distributed interval (mean `rate`, 512 KiB by default) and the allocation
+ * that crosses zero is sampled: its call stack is captured with backtrace(),
+ * interned in a stack table, and the pointer goes into a live table so the
+ * matching free can retire it. A sample of `bytes` stands for bytes / p
+ * bytes and 1 / p allocations, p = 1 - exp(-bytes / rate), the unbiased
+ * estimate tcmalloc and Go use, so totals and per-stack figures read as
+ * whole-heap numbers.
+ *
+ * Per stack the table keeps cumulative allocations, the live estimate and
+ * its peak. A snapshot copies the live column so a later profile or report
+ * can show only what grew since. Profiles are pprof protobuf (profile.proto,
+ * uncompressed, which pprof and speedscope both open); the leaf frame of
+ * every stack is the allocation's site tag ("string interp", "buf"), and
+ * Rae frames are named `module.func` from the executable's own symbol table
+ * (RAE_SYMBOL_TABLE below), so no symbolizer is needed afterwards. Frames
+ * the table does not cover keep their address and the binary's mapping, so
+ * `pprof` can still symbolize them offline.
+ *
+ * Environment: RAE_HEAP_PROFILE=path samples from startup and writes the
+ * profile at exit; RAE_HEAP_PROFILE_RATE=bytes sets the mean interval;
+ * RAE_HEAP_PROFILE_INTERVAL=seconds also writes a numbered profile
+ * (heap.1.pb, heap.2.pb, ...) every interval for `pprof -diff_base`. */
+#define RAE_HEAP_RATE 524288        /* default mean bytes between samples */
+#define RAE_HEAP_DEPTH 32           /* frames kept per sample */
+#define RAE_HEAP_STACKS 8192        /* distinct stacks; slot 0 is overflow */
+#define RAE_HEAP_STACK_SLOTS 16384  /* open-addressing index; 2x stacks */
+#define RAE_HEAP_LIVE 65536         /* sampled live allocations; power of two */
+#define RAE_HEAP_SNAPSHOTS 16       /* retained snapshots, newest first out */
+
+#if !defined(__wasm__) || defined(RAE_WASM_THREADS)
+#define RAE_HEAP_THREADS 1
+#else
+#define RAE_HEAP_THREADS 0
+#endif
+
+typedef struct {
+  uint64_t hash;
+  uint8_t site;
+  uint8_t depth;
+  void* pcs[RAE_HEAP_DEPTH];
+  int64_t alloc_n, alloc_b;  /* estimated, cumulative */
+  int64_t live_n, live_b;    /* estimated, outstanding */
+  int64_t peak_b;
+} RaeHeapStack;
+
+typedef struct {
+  void* ptr;                 /* NULL = empty slot */
+  uint32_t stack;
+  int64_t n, b;              /* this sample's estimates */
+} RaeHeapLive;
+
+typedef struct {
+  int64_t id;                /* 0 = unused */
+  int64_t time_ns;
+  uint32_t count;            /* stacks when taken */
+  int64_t* live_n;
+  int64_t* live_b;
+} RaeHeapSnapshot;
+
+static struct {
+  pthread_mutex_t mu;        /* everything below */
+  int64_t rate;
+  int epoch;                 /* atomic: bumped per start, reseeds threads */
+  RaeHeapStack* stacks;
+  uint32_t stack_count;
+  uint32_t* stack_slots;     /* stack index + 1; 0 is empty */
+  RaeHeapLive* live;
+  int64_t live_b, peak_b;    /* estimated totals */
+  int64_t samples;
+  int64_t untracked;         /* samples the full live table could not hold */
+  int64_t start_ns;
+  RaeHeapSnapshot snaps[RAE_HEAP_SNAPSHOTS];
+  int64_t next_snap;
+  const char* out;           /* RAE_HEAP_PROFILE */
+  double interval;           /* RAE_HEAP_PROFILE_INTERVAL, seconds */
+  int64_t written_seq;
+} g_rae_heap = { .mu = PTHREAD_MUTEX_INITIALIZER };
+
+static __thread int g_rae_heap_epoch;
+static __thread uint64_t g_rae_heap_rng;
+
+static void rae_heap_lock(void) {
+#if RAE_HEAP_THREADS
+  pthread_mutex_lock(&g_rae_heap.mu);
+#endif
+}
+
+static void rae_heap_unlock(void) {
+#if RAE_HEAP_THREADS
+  pthread_mutex_unlock(&g_rae_heap.mu);
+#endif
+}
+
+/* Exponential interval with mean `rate`, from a per-thread xorshift. */
+static int64_t rae_heap_next_interval(void) {
+  uint64_t x = g_rae_heap_rng;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  g_rae_heap_rng = x;
+  double u = ((double)(x >> 11) + 1.0) / 9007199254740993.0;  /* (0, 1] */
+  return (int64_t)(-log(u) * (double)g_rae_heap.rate) + 1;
+}
+
+static uint64_t rae_heap_stack_hash(void* const* pcs, int depth, uint8_t site) {
+  uint64_t h = 0xcbf29ce484222325ULL ^ site;
+  for (int i = 0; i < depth; i++) {
+    h ^= (uint64_t)(uintptr_t)pcs[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h ^ (h >> 29);
+}
+
+/* Stack index for this trace, interning it; 0 (the overflow stack) once
+ * the table is full. Caller holds the lock. */
+static uint32_t rae_heap_intern_stack(void* const* pcs, int depth, uint8_t site) {
+  uint64_t h = rae_heap_stack_hash(pcs, depth, site);
+  uint32_t ix = (uint32_t)h & (RAE_HEAP_STACK_SLOTS - 1);
+  for (uint32_t i = 0; i < RAE_HEAP_STACK_SLOTS; i++) {
+    uint32_t k = (ix + i) & (RAE_HEAP_STACK_SLOTS - 1);
+    uint32_t slot = g_rae_heap.stack_slots[k];
+    if (slot == 0) {
+      if (g_rae_heap.stack_count >= RAE_HEAP_STACKS) return 0;
+      uint32_t id = g_rae_heap.stack_count++;
+      RaeHeapStack* s = &g_rae_heap.stacks[id];
+      s->hash = h;
+      s->site = site;
+      s->depth = (uint8_t)depth;
+      memcpy(s->pcs, pcs, sizeof(void*) * (size_t)depth);
+      g_rae_heap.stack_slots[k] = id + 1;
+      return id;
+    }
+    RaeHeapStack* s = &g_rae_heap.stacks[slot - 1];
+    if (s->hash == h && s->site == site && s->depth == depth &&
+        memcmp(s->pcs, pcs, sizeof(void*) * (size_t)depth) == 0) {
+      return slot - 1;
+    }
+  }
+  return 0;
+}
+
+static inline uint32_t rae_heap_live_ix(void* ptr) {
+  uint64_t x = (uint64_t)(uintptr_t)ptr;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  return (uint32_t)(x & (RAE_HEAP_LIVE - 1));
+}
+
+/* Filter counters saturate: a bucket that reaches 255 stays set, which
+ * only costs the frees that hash there a lock. */
+static void rae_heap_filter_add(void* ptr, int delta) {
+  uint8_t* c = &g_rae_heap_filter[rae_heap_filter_ix(ptr)];
+  uint8_t v = __atomic_load_n(c, __ATOMIC_RELAXED);
+  if (v == 255) return;
+  __atomic_store_n(c, (uint8_t)(v + delta), __ATOMIC_RELAXED);
+}
+
+/* Caller holds the lock. */
+static void rae_heap_account(RaeHeapStack* s, int64_t n, int64_t b) {
+  s->live_n += n;
+  s->live_b += b;
+  if (s->live_b > s->peak_b) s->peak_b = s->live_b;
+  g_rae_heap.live_b += b;
+  if (g_rae_heap.live_b > g_rae_heap.peak_b) g_rae_heap.peak_b = g_rae_heap.live_b;
+}
+
+static void rae_heap_sample(void* ptr, int64_t bytes, uint8_t site) {
+  int epoch = __atomic_load_n(&g_rae_heap.epoch, __ATOMIC_RELAXED);
+  if (g_rae_heap_epoch != epoch) {
+    /* First allocation on this thread since the profiler started: seed the
+     * generator and start counting rather than sample a partial interval. */
+    g_rae_heap_epoch = epoch;
+    g_rae_heap_rng = (uint64_t)(uintptr_t)&g_rae_heap_rng * 0x9e3779b97f4a7c15ULL ^ (uint64_t)rae_ext_nowNs();
+    if (!g_rae_heap_rng) g_rae_heap_rng = 1;
+    g_rae_heap_until = rae_heap_next_interval();
+    return;
+  }
+  g_rae_heap_until = rae_heap_next_interval();
+  /* Frame arena blocks are released by the arena reset, never freed one
+   * by one, so a sample of one would stay live forever. */
+  if (rae_alloc_is_arena(ptr)) return;
+
+  void* pcs[RAE_HEAP_DEPTH + 1];
+  int depth = 0;
+#ifdef RAE_HAVE_BACKTRACE
+  depth = backtrace(pcs, RAE_HEAP_DEPTH + 1) - 1;  /* drop this frame */
+  if (depth < 0) depth = 0;
+#endif
+  double p = 1.0 - exp(-(double)bytes / (double)g_rae_heap.rate);
+  int64_t est_n = (int64_t)(1.0 / p + 0.5);
+  int64_t est_b = (int64_t)((double)bytes / p + 0.5);
+
+  rae_heap_lock();
+  if (!g_rae_heap_on || !g_rae_heap.stacks) { rae_heap_unlock(); return; }
+  uint32_t id = rae_heap_intern_stack(pcs + 1, depth, site);
+  RaeHeapStack* s = &g_rae_heap.stacks[id];
+  s->alloc_n += est_n;
+  s->alloc_b += est_b;
+  g_rae_heap.samples++;
+  int64_t live_n = __atomic_load_n(&g_rae_heap_live_n, __ATOMIC_RELAXED);
+  if (live_n * 4 >= RAE_HEAP_LIVE * 3) {
+    g_rae_heap.untracked++;
+    rae_heap_unlock();
+    return;
+  }
+  uint32_t ix = rae_heap_live_ix(ptr);
+  for (;;) {
+    RaeHeapLive* e = &g_rae_heap.live[ix];
+    if (!e->ptr || e->ptr == ptr) {
+      /* A pointer still marked live was freed by a path that skipped its
+       * untag; retire the stale sample before reusing the slot. */
+      if (e->ptr) rae_heap_account(&g_rae_heap.stacks[e->stack], -e->n, -e->b);
+      else __atomic_store_n(&g_rae_heap_live_n, live_n + 1, __ATOMIC_RELAXED);
+      if (!e->ptr) rae_heap_filter_add(ptr, 1);
+      e->ptr = ptr;
+      e->stack = id;
+      e->n = est_n;
+      e->b = est_b;
+      break;
+    }
+    ix = (ix + 1) & (RAE_HEAP_LIVE - 1);
+  }
+  rae_heap_account(s, est_n, est_b);
+  rae_heap_unlock();
+}
+
+/* A filter hit on free: retire the sample if `ptr` is one. Removal compacts
+ * the probe cluster like rae_mem_hash_remove. */
+static void rae_heap_release(void* ptr) {
+  rae_heap_lock();
+  if (!g_rae_heap.live) { rae_heap_unlock(); return; }
+  uint32_t ix = rae_heap_live_ix(ptr);
+  for (;;) {
+    RaeHeapLive* e = &g_rae_heap.live[ix];
+    if (!e->ptr) break;
+    if (e->ptr != ptr) { ix = (ix + 1) & (RAE_HEAP_LIVE - 1); continue; }
+    rae_heap_account(&g_rae_heap.stacks[e->stack], -e->n, -e->b);
+    rae_heap_filter_add(ptr, -1);
+    __atomic_store_n(&g_rae_heap_live_n, __atomic_load_n(&g_rae_heap_live_n, __ATOMIC_RELAXED) - 1,
+                     __ATOMIC_RELAXED);
+    e->ptr = NULL;
+    uint32_t hole = ix;
+    for (uint32_t j = 1; j < RAE_HEAP_LIVE; j++) {
+      uint32_t k = (hole + j) & (RAE_HEAP_LIVE - 1);
+      if (!g_rae_heap.live[k].ptr) break;
+      uint32_t nat = rae_heap_live_ix(g_rae_heap.live[k].ptr);
+      uint32_t dist_hole = (k - hole) & (RAE_HEAP_LIVE - 1);
+      uint32_t dist_nat = (k - nat) & (RAE_HEAP_LIVE - 1);
+      if (dist_nat >= dist_hole) {
+        g_rae_heap.live[hole] = g_rae_heap.live[k];
+        g_rae_heap.live[k].ptr = NULL;
+        hole = k;
+      }
+    }
+    break;
+  }
+  rae_heap_unlock();
+}
+
+/* ----- Symbols --------------------------------------------------------- */
+/* Function symbols of the running executable, sorted by address, read once
+ * on the first profile write: ELF .symtab from /proc/self/exe on Linux,
+ * the mapped LC_SYMTAB on Apple. Generated Rae functions are static, so
+ * neither dladdr nor the dynamic symbol table can see them. */
+#if defined(__linux__) || defined(__APPLE__)
+#define RAE_SYMBOL_TABLE 1
+#endif
+
+typedef struct {
+  uintptr_t addr;
+  uintptr_t size;            /* 0 = unknown: up to the next symbol */
+  const char* name;
+  int local;
+} RaeHeapSym;
+
+static RaeHeapSym* g_rae_heap_syms;
+static size_t g_rae_heap_sym_count;
+static int g_rae_heap_syms_loaded;
+static uintptr_t g_rae_heap_image_lo, g_rae_heap_image_hi;
+static char g_rae_heap_image_path[1024];
+
+static int rae_heap_sym_cmp(const void* a, const void* b) {
+  uintptr_t x = ((const RaeHeapSym*)a)->addr, y = ((const RaeHeapSym*)b)->addr;
+  return x < y ? -1 : x > y;
+}
+
+static void rae_heap_add_sym(size_t* cap, uintptr_t addr, uintptr_t size, const char* name, int local) {
+  if (!name || !name[0] || !addr) return;
+  if (g_rae_heap_sym_count == *cap) {
+    size_t ncap = *cap ? *cap * 2 : 4096;
+    RaeHeapSym* grown = (RaeHeapSym*)realloc(g_rae_heap_syms, ncap * sizeof(RaeHeapSym));
+    if (!grown) return;
+    g_rae_heap_syms = grown;
+    *cap = ncap;
+  }
+  g_rae_heap_syms[g_rae_heap_sym_count++] = (RaeHeapSym){addr, size, name, local};
+  if (!g_rae_heap_image_lo || addr < g_rae_heap_image_lo) g_rae_heap_image_lo = addr;
+  if (addr + size > g_rae_heap_image_hi) g_rae_heap_image_hi = addr + (size ? size : 1);
+}
+
+#if defined(__linux__)
+#include <elf.h>
+
+static void rae_heap_load_syms(void) {
+  ssize_t plen = readlink("/proc/self/exe", g_rae_heap_image_path, sizeof(g_rae_heap_image_path) - 1);
+  if (plen <= 0) return;
+  g_rae_heap_image_path[plen] = '\0';
+  /* Load bias of a PIE: the lowest mapping of the executable at offset 0. */
+  uintptr_t bias = 0;
+  FILE* maps = fopen("/proc/self/maps", "r");
+  if (maps) {
+    char line[1400];
+    while (fgets(line, sizeof(line), maps)) {
+      unsigned long lo, hi, off, inode;
+      char perms[8], dev[16], path[1200] = {0};
+      if (sscanf(line, "%lx-%lx %7s %lx %15s %lu %1199s", &lo, &hi, perms, &off, dev, &inode, path) == 7 &&
+          off == 0 && strcmp(path, g_rae_heap_image_path) == 0) {
+        bias = (uintptr_t)lo;
+        break;
+      }
+    }
+    fclose(maps);
+  }
+  FILE* f = fopen(g_rae_heap_image_path, "rb");
+  if (!f) return;
+  Elf64_Ehdr eh;
+  if (fread(&eh, sizeof(eh), 1, f) != 1 || memcmp(eh.e_ident, ELFMAG, SELFMAG) != 0 ||
+      eh.e_ident[EI_CLASS] != ELFCLASS64 || eh.e_shentsize != sizeof(Elf64_Shdr)) {
+    fclose(f);
+    return;
+  }
+  if (eh.e_type == ET_EXEC) bias = 0;
+  Elf64_Shdr* sh = (Elf64_Shdr*)malloc(sizeof(Elf64_Shdr) * eh.e_shnum);
+  if (!sh || fseek(f, (long)eh.e_shoff, SEEK_SET) != 0 ||
+      fread(sh, sizeof(Elf64_Shdr), eh.e_shnum, f) != eh.e_shnum) {
+    free(sh);
+    fclose(f);
+    return;
+  }
+  int symtab = -1;
+  for (int i = 0; i < eh.e_shnum; i++) {
+    if (sh[i].sh_type == SHT_SYMTAB) symtab = i;
+    if (sh[i].sh_type == SHT_DYNSYM && symtab < 0) symtab = i;
+  }
+  if (symtab >= 0 && sh[symtab].sh_link < eh.e_shnum) {
+    Elf64_Shdr* ss = &sh[symtab];
+    Elf64_Shdr* st = &sh[ss->sh_link];
+    Elf64_Sym* syms = (Elf64_Sym*)malloc(ss->sh_size);
+    char* strs = (char*)malloc(st->sh_size + 1);
+    if (syms && strs && fseek(f, (long)ss->sh_offset, SEEK_SET) == 0 &&
+        fread(syms, 1, ss->sh_size, f) == ss->sh_size &&
+        fseek(f, (long)st->sh_offset, SEEK_SET) == 0 && fread(strs, 1, st->sh_size, f) == st->sh_size) {
+      strs[st->sh_size] = '\0';
+      size_t cap = 0;
+      for (size_t i = 0; i < ss->sh_size / sizeof(Elf64_Sym); i++) {
+        if (ELF64_ST_TYPE(syms[i].st_info) != STT_FUNC || syms[i].st_name >= st->sh_size) continue;
+        rae_heap_add_sym(&cap, (uintptr_t)syms[i].st_value + bias, (uintptr_t)syms[i].st_size,
+                         strs + syms[i].st_name, ELF64_ST_BIND(syms[i].st_info) == STB_LOCAL);
+      }
+      strs = NULL;           /* owned by the symbol table now */
+    }
+    free(syms);
+    free(strs);
+  }
+  free(sh);
+  fclose(f);
+}
+#elif defined(__APPLE__)
+#include <mach-o/dyld.h>
+#include <mach-o/loader.h>
+#include <mach-o/nlist.h>
+
+static void rae_heap_load_syms(void) {
+  const struct mach_header_64* mh = (const struct mach_header_64*)_dyld_get_image_header(0);
+  if (!mh || mh->magic != MH_MAGIC_64) return;
+  const char* path = _dyld_get_image_name(0);
+  if (path) snprintf(g_rae_heap_image_path, sizeof(g_rae_heap_image_path), "%s", path);
+  intptr_t slide = _dyld_get_image_vmaddr_slide(0);
+  const struct segment_command_64* linkedit = NULL;
+  const struct symtab_command* symtab = NULL;
+  const uint8_t* lc = (const uint8_t*)(mh + 1);
+  for (uint32_t i = 0; i < mh->ncmds; i++) {
+    const struct load_command* cmd = (const struct load_command*)lc;
+    if (cmd->cmd == LC_SEGMENT_64 &&
+        strcmp(((const struct segment_command_64*)cmd)->segname, "__LINKEDIT") == 0) {
+      linkedit = (const struct segment_command_64*)cmd;
+    } else if (cmd->cmd == LC_SYMTAB) {
+      symtab = (const struct symtab_command*)cmd;
+    }
+    lc += cmd->cmdsize;
+  }
+  if (!linkedit || !symtab) return;
+  uintptr_t base = (uintptr_t)slide + linkedit->vmaddr - linkedit->fileoff;
+  const struct nlist_64* syms = (const struct nlist_64*)(base + symtab->symoff);
+  const char* strs = (const char*)(base + symtab->stroff);
+  size_t cap = 0;
+  for (uint32_t i = 0; i < symtab->nsyms; i++) {
+    if (syms[i].n_type & N_STAB) continue;
+    if ((syms[i].n_type & N_TYPE) != N_SECT) continue;
+    const char* name = strs + syms[i].n_un.n_strx;
+    if (name[0] == '_') name++;
+    rae_heap_add_sym(&cap, (uintptr_t)syms[i].n_value + (uintptr_t)slide, 0, name,
+                     !(syms[i].n_type & N_EXT));
+  }
+}
+#else
+static void rae_heap_load_syms(void) {}
+#endif
+
+static const RaeHeapSym* rae_heap_find_sym(uintptr_t pc) {
+  if (!g_rae_heap_syms_loaded) {
+    g_rae_heap_syms_loaded = 1;
+    rae_heap_load_syms();
+    if (g_rae_heap_syms) qsort(g_rae_heap_syms, g_rae_heap_sym_count, sizeof(RaeHeapSym), rae_heap_sym_cmp);
+  }
+  /* libc and other shared objects are outside the table; don't let the last
+   * executable symbol (often a size-0 _fini) claim their frames. */
+  if (pc < g_rae_heap_image_lo || pc >= g_rae_heap_image_hi) return NULL;
+  size_t lo = 0, hi = g_rae_heap_sym_count;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (g_rae_heap_syms[mid].addr <= pc) lo = mid + 1; else hi = mid;
+  }
+  /* The innermost symbol starting at or before pc that still covers it. */
+  for (size_t i = lo; i-- > 0;) {
+    const RaeHeapSym* s = &g_rae_heap_syms[i];
+    if (s->size ? pc < s->addr + s->size : (i + 1 == g_rae_heap_sym_count || pc < g_rae_heap_syms[i + 1].addr)) {
+      return s;
+    }
+    if (lo - i > 4) break;
+  }
+  return NULL;
+}
+
+/* Display name for a frame. Generated functions are static and mangle as
+ * rae_<module path>_<name>_<parameter types>; they read as `module.name`
+ * (rae_gltf_skin_batch_poseCharacter_rae_Mod_... -> gltf_skin_batch.poseCharacter).
+ * Runtime and libc frames keep their C names. */
+static void rae_heap_frame_name(uintptr_t pc, char* out, size_t cap) {
+  const RaeHeapSym* s = rae_heap_find_sym(pc);
+  if (!s) {
+    snprintf(out, cap, "0x%llx", (unsigned long long)pc);
+    return;
+  }
+  char name[512];
+  snprintf(name, sizeof(name), "%s", s->name);
+  char* dot = strchr(name, '.');           /* .constprop.0, .isra.0, .cold */
+  if (dot) *dot = '\0';
+  size_t len = strlen(name);
+  const char* params = strstr(name + 4, "_rae_");
+  const char* any = strstr(name + 4, "_RaeAny");
+  if (!params || (any && any < params)) params = any;
+  int generated = s->local && strncmp(name, "rae_", 4) == 0 &&
+                  (params || (len > 5 && name[len - 1] == '_'));
+  if (!generated) {
+    snprintf(out, cap, "%s", name);
+    return;
+  }
+  size_t end = params ? (size_t)(params - name) : len - 1;
+  name[end] = '\0';
+  char* body = name + 4;
+  char* sep = strrchr(body, '_');
+  if (sep && sep != body) {
+    *sep = '\0';
+    snprintf(out, cap, "%s.%s", body, sep + 1);
+  } else {
+    snprintf(out, cap, "%s", body);
+  }
+}
+
+static const char* rae_heap_site_name(uint8_t site) {
+  static char names[RAE_SITE__COUNT][32];
+  if (site > RAE_HEAP_SITE_BUF) return "[other stacks]";
+  if (site == RAE_HEAP_SITE_BUF) return "[buf]";
+  if (!names[site][0]) snprintf(names[site], sizeof(names[site]), "[string %s]", g_rae_site_names[site]);
+  return names[site];
+}
+
+/* ----- pprof encoding -------------------------------------------------- */
+/* profile.proto, written field by field: every submessage is small enough
+ * for a RaeProfPb (runtime_profile.c) except the string table, whose
+ * entries are emitted one by one. */
+
+static void rae_heap_put(FILE* f, uint32_t field, const RaeProfPb* msg) {
+  RaeProfPb head = {.n = 0};
+  rae_pb_varint(&head, ((uint64_t)field << 3) | 2);
+  rae_pb_varint(&head, msg->n);
+  fwrite(head.b, 1, head.n, f);
+  fwrite(msg->b, 1, msg->n, f);
+}
+
+static void rae_heap_put_int(FILE* f, uint32_t field, int64_t v) {
+  RaeProfPb pb = {.n = 0};
+  rae_pb_uint(&pb, field, (uint64_t)v);
+  fwrite(pb.b, 1, pb.n, f);
+}
+
+typedef struct {
+  const char** strs;         /* string table; strs[0] = "" */
+  size_t count, cap;
+} RaeHeapStrings;
+
+/* Index of `s` in the table, appending it (linear dedupe: profiles hold a
+ * few hundred distinct names). `s` must outlive the write. */
+static int64_t rae_heap_str(RaeHeapStrings* t, const char* s) {
+  for (size_t i = 0; i < t->count; i++) if (strcmp(t->strs[i], s) == 0) return (int64_t)i;
+  if (t->count == t->cap) {
+    size_t ncap = t->cap ? t->cap * 2 : 64;
+    const char** grown = (const char**)realloc((void*)t->strs, ncap * sizeof(char*));
+    if (!grown) return 0;
+    t->strs = grown;
+    t->cap = ncap;
+  }
+  t->strs[t->count] = s;
+  return (int64_t)t->count++;
+}
+
+typedef struct {
+  uintptr_t pc;              /* 0 for a site frame */
+  uint8_t site;
+  uint64_t function;
+  char* name;
+} RaeHeapLoc;
+
+/* Writes the live heap (minus snapshot `base`'s live column when base > 0)
+ * and cumulative allocations per stack. Caller holds the lock; the stack
+ * table and snapshots are only read. Returns false if the file failed. */
+static int rae_heap_write_pprof(const char* path, const RaeHeapSnapshot* base) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return 0;
+  RaeHeapStrings strs = {0};
+  rae_heap_str(&strs, "");
+  int64_t s_alloc_objects = rae_heap_str(&strs, "alloc_objects");
+  int64_t s_alloc_space = rae_heap_str(&strs, "alloc_space");
+  int64_t s_inuse_objects = rae_heap_str(&strs, "inuse_objects");
+  int64_t s_inuse_space = rae_heap_str(&strs, "inuse_space");
+  int64_t s_count = rae_heap_str(&strs, "count");
+  int64_t s_bytes = rae_heap_str(&strs, "bytes");
+  int64_t s_space = rae_heap_str(&strs, "space");
+  int64_t s_image = rae_heap_str(&strs, g_rae_heap_image_path[0] ? g_rae_heap_image_path : "rae");
+
+  /* Locations: one per distinct pc and one per site tag. */
+  RaeHeapLoc* locs = NULL;
+  size_t nlocs = 0, loc_cap = 0;
+  uint64_t* stack_locs = (uint64_t*)malloc(sizeof(uint64_t) * (RAE_HEAP_DEPTH + 1) * (g_rae_heap.stack_count + 1));
+  int all_named = 1;
+  for (uint32_t si = 0; si < g_rae_heap.stack_count && stack_locs; si++) {
+    RaeHeapStack* s = &g_rae_heap.stacks[si];
+    for (int fi = -1; fi < s->depth; fi++) {
+      uintptr_t pc = fi < 0 ? 0 : (uintptr_t)s->pcs[fi];
+      size_t li = 0;
+      while (li < nlocs && !(locs[li].pc == pc && (pc || locs[li].site == s->site))) li++;
+      if (li == nlocs) {
+        if (nlocs == loc_cap) {
+          loc_cap = loc_cap ? loc_cap * 2 : 256;
+          RaeHeapLoc* grown = (RaeHeapLoc*)realloc(locs, loc_cap * sizeof(RaeHeapLoc));
+          if (!grown) break;
+          locs = grown;
+        }
+        char name[512];
+        if (pc) {
+          /* Return addresses point after the call; look up the call. */
+          rae_heap_frame_name(pc - 1, name, sizeof(name));
+          if (name[0] == '0' && name[1] == 'x') all_named = 0;
+        } else {
+          snprintf(name, sizeof(name), "%s", rae_heap_site_name(s->site));
+        }
+        size_t len = strlen(name) + 1;
+        char* copy = (char*)malloc(len);
+        if (!copy) break;
+        memcpy(copy, name, len);
+        locs[nlocs] = (RaeHeapLoc){pc, s->site, 0, copy};
+        nlocs++;
+      }
+      stack_locs[(size_t)si * (RAE_HEAP_DEPTH + 1) + (size_t)(fi + 1)] = li + 1;
+    }
+  }
+
+  RaeProfPb pb;
+  /* sample_type (1): alloc_objects, alloc_space, inuse_objects, inuse_space */
+  int64_t types[4][2] = {{s_alloc_objects, s_count}, {s_alloc_space, s_bytes},
+                         {s_inuse_objects, s_count}, {s_inuse_space, s_bytes}};
+  for (int i = 0; i < 4; i++) {
+    pb.n = 0;
+    rae_pb_uint(&pb, 1, (uint64_t)types[i][0]);
+    rae_pb_uint(&pb, 2, (uint64_t)types[i][1]);
+    rae_heap_put(f, 1, &pb);
+  }
+  /* sample (2) */
+  for (uint32_t si = 0; si < g_rae_heap.stack_count && stack_locs; si++) {
+    RaeHeapStack* s = &g_rae_heap.stacks[si];
+    int64_t live_n = s->live_n, live_b = s->live_b;
+    if (base && si < base->count) {
+      live_n -= base->live_n[si];
+      live_b -= base->live_b[si];
+    }
+    if (s->alloc_n == 0 && live_n == 0) continue;
+    RaeProfPb ids = {.n = 0};
+    for (int fi = 0; fi <= s->depth; fi++) rae_pb_varint(&ids, stack_locs[(size_t)si * (RAE_HEAP_DEPTH + 1) + (size_t)fi]);
+    RaeProfPb vals = {.n = 0};
+    rae_pb_varint(&vals, (uint64_t)s->alloc_n);
+    rae_pb_varint(&vals, (uint64_t)s->alloc_b);
+    rae_pb_varint(&vals, (uint64_t)live_n);
+    rae_pb_varint(&vals, (uint64_t)live_b);
+    pb.n = 0;
+    rae_pb_bytes(&pb, 1, ids.b, ids.n);
+    rae_pb_bytes(&pb, 2, vals.b, vals.n);
+    rae_heap_put(f, 2, &pb);
+  }
+  /* mapping (3): the executable, so unnamed frames symbolize offline. */
+  pb.n = 0;
+  rae_pb_uint(&pb, 1, 1);
+  rae_pb_uint(&pb, 2, g_rae_heap_image_lo);
+  rae_pb_uint(&pb, 3, g_rae_heap_image_hi);
+  rae_pb_uint(&pb, 5, (uint64_t)s_image);
+  rae_pb_uint(&pb, 7, (uint64_t)all_named);
+  rae_heap_put(f, 3, &pb);
+  /* location (4) and function (5) */
+  uint64_t next_function = 1;
+  for (size_t li = 0; li < nlocs; li++) {
+    for (size_t k = 0; k < li; k++) {
+      if (strcmp(locs[k].name, locs[li].name) == 0) { locs[li].function = locs[k].function; break; }
+    }
+    if (!locs[li].function) {
+      locs[li].function = next_function++;
+      int64_t sname = rae_heap_str(&strs, locs[li].name);
+      pb.n = 0;
+      rae_pb_uint(&pb, 1, locs[li].function);
+      rae_pb_uint(&pb, 2, (uint64_t)sname);
+      rae_pb_uint(&pb, 3, (uint64_t)sname);
+      rae_heap_put(f, 5, &pb);
+    }
+    RaeProfPb line = {.n = 0};
+    rae_pb_uint(&line, 1, locs[li].function);
+    pb.n = 0;
+    rae_pb_uint(&pb, 1, li + 1);
+    if (locs[li].pc) {
+      rae_pb_uint(&pb, 2, 1);
+      rae_pb_uint(&pb, 3, locs[li].pc - 1);
+    }
+    rae_pb_bytes(&pb, 4, line.b, line.n);
+    rae_heap_put(f, 4, &pb);
+  }
+  /* string_table (6) */
+  for (size_t i = 0; i < strs.count; i++) {
+    RaeProfPb head = {.n = 0};
+    size_t len = strlen(strs.strs[i]);
+    rae_pb_varint(&head, (6u << 3) | 2);
+    rae_pb_varint(&head, len);
+    fwrite(head.b, 1, head.n, f);
+    fwrite(strs.strs[i], 1, len, f);
+  }
+  /* time_nanos (9), duration_nanos (10), period_type (11), period (12),
+   * default_sample_type (14) */
+  rae_heap_put_int(f, 9, (int64_t)time(NULL) * 1000000000LL);
+  rae_heap_put_int(f, 10, rae_ext_nowNs() - g_rae_heap.start_ns);
+  pb.n = 0;
+  rae_pb_uint(&pb, 1, (uint64_t)s_space);
+  rae_pb_uint(&pb, 2, (uint64_t)s_bytes);
+  rae_heap_put(f, 11, &pb);
+  rae_heap_put_int(f, 12, g_rae_heap.rate);
+  rae_heap_put_int(f, 14, s_inuse_space);
+
+  for (size_t li = 0; li < nlocs; li++) free(locs[li].name);
+  free(locs);
+  free(stack_locs);
+  free((void*)strs.strs);
+  int ok = !ferror(f);
+  return fclose(f) == 0 && ok;
+}
+
+/* ----- Snapshots and reports ------------------------------------------ */
+
+/* The retained snapshot with this id, or NULL (none asked for, evicted, or
+ * never taken). Caller holds the lock. */
+static const RaeHeapSnapshot* rae_heap_snapshot_of(int64_t id) {
+  if (id <= 0) return NULL;
+  const RaeHeapSnapshot* s = &g_rae_heap.snaps[id % RAE_HEAP_SNAPSHOTS];
+  return s->id == id ? s : NULL;
+}
+
+static void rae_heap_free_tables(void) {
+  free(g_rae_heap.stacks);
+  free(g_rae_heap.stack_slots);
+  free(g_rae_heap.live);
+  g_rae_heap.stacks = NULL;
+  g_rae_heap.stack_slots = NULL;
+  g_rae_heap.live = NULL;
+  for (int i = 0; i < RAE_HEAP_SNAPSHOTS; i++) {
+    free(g_rae_heap.snaps[i].live_n);
+    free(g_rae_heap.snaps[i].live_b);
+    memset(&g_rae_heap.snaps[i], 0, sizeof(RaeHeapSnapshot));
+  }
+}
+
+static int rae_heap_start(int64_t rate) {
+  rae_heap_lock();
+  if (g_rae_heap_on) { rae_heap_unlock(); return 1; }
+  rae_heap_free_tables();
+  g_rae_heap.stacks = (RaeHeapStack*)calloc(RAE_HEAP_STACKS, sizeof(RaeHeapStack));
+  g_rae_heap.stack_slots = (uint32_t*)calloc(RAE_HEAP_STACK_SLOTS, sizeof(uint32_t));
+  g_rae_heap.live = (RaeHeapLive*)calloc(RAE_HEAP_LIVE, sizeof(RaeHeapLive));
+  if (!g_rae_heap.stacks || !g_rae_heap.stack_slots || !g_rae_heap.live) {
+    rae_heap_free_tables();
+    rae_heap_unlock();
+    return 0;
+  }
+  g_rae_heap.stack_count = 1;  /* slot 0: stacks past RAE_HEAP_STACKS */
+  g_rae_heap.stacks[0].site = RAE_HEAP_SITE_BUF + 1;
+  g_rae_heap.rate = rate > 0 ? rate : RAE_HEAP_RATE;
+  g_rae_heap.live_b = g_rae_heap.peak_b = 0;
+  g_rae_heap.samples = g_rae_heap.untracked = 0;
+  g_rae_heap.next_snap = 1;
+  g_rae_heap.start_ns = rae_ext_nowNs();
+  memset(g_rae_heap_filter, 0, sizeof(g_rae_heap_filter));
+  __atomic_store_n(&g_rae_heap_live_n, 0, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&g_rae_heap.epoch, 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&g_rae_heap_on, 1, __ATOMIC_RELEASE);
+  rae_heap_unlock();
+#ifdef RAE_HAVE_BACKTRACE
+  /* glibc's first backtrace() loads libgcc; do it here, not mid-sample. */
+  void* warm[2];
+  backtrace(warm, 2);
+#endif
+  return 1;
+}
+
+/* Sampling stops; the tables stay readable until the next start. Frees of
+ * sampled pointers still retire them, so live figures stay honest. */
+static void rae_heap_stop(void) {
+  __atomic_store_n(&g_rae_heap_on, 0, __ATOMIC_RELEASE);
+}
+
+typedef struct {
+  uint32_t stack;
+  int64_t live_b, live_n;
+} RaeHeapRow;
+
+static int rae_heap_row_cmp(const void* a, const void* b) {
+  int64_t x = ((const RaeHeapRow*)a)->live_b, y = ((const RaeHeapRow*)b)->live_b;
+  return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static void rae_heap_fmt_bytes(char* out, size_t cap, int64_t b) {
+  double v = (double)(b < 0 ? -b : b);
+  const char* sign = b < 0 ? "-" : "";
+  if (v >= 1048576.0) snprintf(out, cap, "%s%.1f MiB", sign, v / 1048576.0);
+  else if (v >= 1024.0) snprintf(out, cap, "%s%.1f KiB", sign, v / 1024.0);
+  else snprintf(out, cap, "%s%lld B", sign, (long long)v);
+}
+
+/* ----- Rae entry points ------------------------------------------------ */
+
+rae_Bool rae_ext_rae_sys_heap_start(int64_t rate) {
+  return rae_heap_start(rate) != 0;
+}
+
+void rae_ext_rae_sys_heap_stop(void) {
+  rae_heap_stop();
+}
+
+rae_Bool rae_ext_rae_sys_heap_active(void) {
+  return __atomic_load_n(&g_rae_heap_on, __ATOMIC_RELAXED) != 0;
+}
+
+/* Estimated live and peak bytes across all sampled stacks. */
+int64_t rae_ext_rae_sys_heap_live_bytes(void) {
+  rae_heap_lock();
+  int64_t v = g_rae_heap.live_b;
+  rae_heap_unlock();
+  return v;
+}
+
+int64_t rae_ext_rae_sys_heap_peak_bytes(void) {
+  rae_heap_lock();
+  int64_t v = g_rae_heap.peak_b;
+  rae_heap_unlock();
+  return v;
+}
+
+/* Copies every stack's live figures; returns the snapshot id (> 0), or 0
+ * if nothing is being profiled. The oldest of RAE_HEAP_SNAPSHOTS retained
+ * snapshots is dropped to make room. */
+int64_t rae_ext_rae_sys_heap_snapshot(void) {
+  rae_heap_lock();
+  if (!g_rae_heap.stacks) { rae_heap_unlock(); return 0; }
+  int64_t id = g_rae_heap.next_snap++;
+  RaeHeapSnapshot* s = &g_rae_heap.snaps[id % RAE_HEAP_SNAPSHOTS];
+  free(s->live_n);
+  free(s->live_b);
+  s->count = g_rae_heap.stack_count;
+  s->live_n = (int64_t*)malloc(sizeof(int64_t) * s->count);
+  s->live_b = (int64_t*)malloc(sizeof(int64_t) * s->count);
+  if (!s->live_n || !s->live_b) {
+    free(s->live_n);
+    free(s->live_b);
+    memset(s, 0, sizeof(*s));
+    rae_heap_unlock();
+    return 0;
+  }
+  for (uint32_t i = 0; i < s->count; i++) {
+    s->live_n[i] = g_rae_heap.stacks[i].live_n;
+    s->live_b[i] = g_rae_heap.stacks[i].live_b;
+  }
+  s->time_ns = rae_ext_nowNs();
+  s->id = id;
+  rae_heap_unlock();
+  return id;
+}
+
+/* Writes a pprof profile; with `since` a snapshot id, the inuse columns are
+ * the growth since that snapshot (pprof shows shrinkage as negative). */
+rae_Bool rae_ext_rae_sys_heap_write(rae_String path, int64_t since) {
+  char cpath[1024];
+  size_t len = path.len < (int64_t)sizeof(cpath) ? (size_t)path.len : sizeof(cpath) - 1;
+  memcpy(cpath, path.data, len);
+  cpath[len] = '\0';
+  rae_heap_lock();
+  if (!g_rae_heap.stacks || (since > 0 && !rae_heap_snapshot_of(since))) {
+    rae_heap_unlock();
+    return 0;
+  }
+  int ok = rae_heap_write_pprof(cpath, rae_heap_snapshot_of(since));
+  rae_heap_unlock();
+  return ok != 0;
+}
+
+/* The `top` stacks by live bytes (growth since snapshot `since` when > 0),
+ * one per line: live, peak, objects, then the site tag and the innermost
+ * frames, Rae functions as `module.func`. */
+rae_String rae_ext_rae_sys_heap_report(int64_t top, int64_t since) {
+  size_t cap = 4096, n = 0;
+  char* out = (char*)malloc(cap);
+  if (!out) return rae_ext_rae_str_from_cstr("");
+  out[0] = '\0';
+  rae_heap_lock();
+  const RaeHeapSnapshot* base = rae_heap_snapshot_of(since);
+  uint32_t count = g_rae_heap.stacks ? g_rae_heap.stack_count : 0;
+  RaeHeapRow* rows = count ? (RaeHeapRow*)malloc(sizeof(RaeHeapRow) * count) : NULL;
+  uint32_t nrows = 0;
+  for (uint32_t i = 0; i < count && rows; i++) {
+    int64_t b = g_rae_heap.stacks[i].live_b, c = g_rae_heap.stacks[i].live_n;
+    if (base && i < base->count) { b -= base->live_b[i]; c -= base->live_n[i]; }
+    if (b != 0) rows[nrows++] = (RaeHeapRow){i, b, c};
+  }
+  if (rows) qsort(rows, nrows, sizeof(RaeHeapRow), rae_heap_row_cmp);
+  for (uint32_t r = 0; r < nrows && (int64_t)r < top; r++) {
+    RaeHeapStack* s = &g_rae_heap.stacks[rows[r].stack];
+    char line[2048], live[32], peak[32];
+    rae_heap_fmt_bytes(live, sizeof(live), rows[r].live_b);
+    rae_heap_fmt_bytes(peak, sizeof(peak), s->peak_b);
+    int m = snprintf(line, sizeof(line), "%10s live %10s peak %8lld objs  %s", live, peak,
+                     (long long)rows[r].live_n, rae_heap_site_name(s->site));
+    for (int fi = 0; fi < s->depth && fi < 8 && m < (int)sizeof(line) - 600; fi++) {
+      char name[512];
+      rae_heap_frame_name((uintptr_t)s->pcs[fi] - 1, name, sizeof(name));
+      m += snprintf(line + m, sizeof(line) - (size_t)m, " <- %s", name);
+      if (strcmp(name, "main") == 0) break;
+    }
+    size_t ll = strlen(line);
+    if (n + ll + 2 > cap) {
+      while (n + ll + 2 > cap) cap *= 2;
+      char* grown = (char*)realloc(out, cap);
+      if (!grown) break;
+      out = grown;
+    }
+    memcpy(out + n, line, ll);
+    n += ll;
+    out[n++] = '\n';
+    out[n] = '\0';
+  }
+  rae_heap_unlock();
+  free(rows);
+  /* Allocated after the lock is released: this string is itself sampled. */
+  rae_String s = rae_ext_rae_str_from_cstr(out);
+  free(out);
+  return s;
+}
+
+/* ----- Environment capture -------------------------------------------- */
+
+static void rae_heap_numbered_path(char* out, size_t cap, const char* path, int64_t seq) {
+  const char* dot = strrchr(path, '.');
+  const char* slash = strrchr(path, '/');
+  if (dot && (!slash || dot > slash)) {
+    snprintf(out, cap, "%.*s.%lld%s", (int)(dot - path), path, (long long)seq, dot);
+  } else {
+    snprintf(out, cap, "%s.%lld", path, (long long)seq);
+  }
+}
+
+#if RAE_HEAP_THREADS
+static void* rae_heap_interval_main(void* arg) {
+  (void)arg;
+  for (;;) {
+    rae_ext_rae_sleep((int64_t)(g_rae_heap.interval * 1000.0));
+    char path[1100];
+    rae_heap_lock();
+    g_rae_heap.written_seq++;
+    rae_heap_numbered_path(path, sizeof(path), g_rae_heap.out, g_rae_heap.written_seq);
+    if (g_rae_heap.stacks && !rae_heap_write_pprof(path, NULL)) {
+      fprintf(stderr, "heap profile: FAILED to write %s\n", path);
+    }
+    rae_heap_unlock();
+  }
+  return NULL;
+}
+#endif
+
+static void rae_heap_exit(void) {
+  rae_heap_stop();
+  rae_heap_lock();
+  int ok = g_rae_heap.stacks && rae_heap_write_pprof(g_rae_heap.out, NULL);
+  char live[32], peak[32];
+  rae_heap_fmt_bytes(live, sizeof(live), g_rae_heap.live_b);
+  rae_heap_fmt_bytes(peak, sizeof(peak), g_rae_heap.peak_b);
+  int64_t samples = g_rae_heap.samples, untracked = g_rae_heap.untracked;
+  rae_heap_unlock();
+  if (!ok) {
+    fprintf(stderr, "heap profile: FAILED to write %s\n", g_rae_heap.out);
+    return;
+  }
+  fprintf(stderr, "heap profile: wrote %s (%lld samples; live %s, peak %s)\n", g_rae_heap.out,
+          (long long)samples, live, peak);
+  if (untracked) {
+    fprintf(stderr, "heap profile: WARNING %lld samples not tracked as live (table full)\n",
+            (long long)untracked);
+  }
+}
+
+__attribute__((constructor))
+static void rae_install_heap_profile(void) {
+  const char* out = getenv("RAE_HEAP_PROFILE");
+  if (!out || !out[0]) return;
+  const char* rate = getenv("RAE_HEAP_PROFILE_RATE");
+  if (!rae_heap_start(rate && rate[0] ? atoll(rate) : RAE_HEAP_RATE)) return;
+  g_rae_heap.out = out;
+  atexit(rae_heap_exit);
+#if RAE_HEAP_THREADS
+  const char* interval = getenv("RAE_HEAP_PROFILE_INTERVAL");
+  g_rae_heap.interval = interval && interval[0] ? atof(interval) : 0.0;
+  if (g_rae_heap.interval > 0) {
+    pthread_t th;
+    if (pthread_create(&th, NULL, rae_heap_interval_main, NULL) == 0) pthread_detach(th);
+  }
+#endif
+}
@@ -45,6 +45,91 @@
 #pragma GCC diagnostic pop
 #endif
 
+/* Read a whole file into a malloc'd buffer. Returns NULL on failure. */
+static unsigned char* rae_image_read_whole_file(const char* path, size_t* out_len) {
+    if (!path || !out_len) return NULL;
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    if (fseek(f, 0, SEEK_END) != 0) { fclose(f); return NULL; }
+    long sz = ftell(f);
+    if (sz <= 0) { fclose(f); return NULL; }
+    if (fseek(f, 0, SEEK_SET) != 0) { fclose(f); return NULL; }
+    unsigned char* buf = (unsigned char*)malloc((size_t)sz);
+    if (!buf) { fclose(f); return NULL; }
+    size_t got = fread(buf, 1, (size_t)sz, f);
+    fclose(f);
+    if (got != (size_t)sz) { free(buf); return NULL; }
+    *out_len = (size_t)sz;
+    return buf;
+}
+
+/* Decode an image file to RGBA8 (#228; contract + rationale in
+ * docs/image-decoding-design.md): strict magic-byte dispatch, ONE
+ * decoder per format, no fallback cascade.
+ *   FF D8 FF     -> vendored stb_image (JPEG, every platform)
+ *   89 50 4E 47  -> lodepng (PNG)
+ *   anything else -> unsupported
+ * Output is straight-alpha RGBA8, no colour management.
+ *
+ * stb is the sole JPEG decoder. macOS previously used ImageIO, but
+ * ImageIO silently rendered truncated downloads half-grey (no error);
+ * stb correctly rejects them, and decodes every valid file (verified
+ * ok=102/102 on the cached Spotify artwork set). The truncation guard
+ * below turns a partial download into a loud failure the caller can
+ * evict + re-fetch, rather than a decoder-dependent glitch.
+ * Returns 1 with a malloc-compatible *out_rgba on success; on
+ * failure returns 0 and points *out_err at a static reason string.
+ * Lives here rather than in the gpu2d module so it is compiled into every
+ * build: gpu2d upload and the background asset loader share it. Reentrant
+ * (no globals; stb/lodepng keep their state on the stack), so loader
+ * workers call it concurrently. */
+static int rae_image_decode_rgba(const char* path, unsigned char** out_rgba,
+                                 unsigned* out_w, unsigned* out_h,
+                                 const char** out_err) {
+    *out_rgba = NULL; *out_w = 0; *out_h = 0; *out_err = "unreadable file";
+    size_t len = 0;
+    unsigned char* bytes = rae_image_read_whole_file(path, &len);
+    if (!bytes) return 0;
+    if (len >= 3 && bytes[0] == 0xFF && bytes[1] == 0xD8 && bytes[2] == 0xFF) {
+        /* Truncation guard: a JPEG without its EOI marker (FF D9) in
+         * the last 64 bytes is an interrupted download. Fail loudly
+         * so callers can evict the bad cache entry and re-fetch. */
+        {
+            size_t scan = len < 64 ? len : 64;
+            int has_eoi = 0;
+            for (size_t i = len - scan; i + 1 < len; i++) {
+                if (bytes[i] == 0xFF && bytes[i + 1] == 0xD9) { has_eoi = 1; break; }
+            }
+            if (!has_eoi) {
+                free(bytes);
+                *out_err = "truncated JPEG (missing EOI marker)";
+                return 0;
+            }
+        }
+        int w = 0, h = 0, comp = 0;
+        unsigned char* px = stbi_load_from_memory(bytes, (int)len, &w, &h, &comp, 4);
+        free(bytes);
+        if (!px) {
+            *out_err = stbi_failure_reason();
+            return 0;
+        }
+        *out_rgba = px; *out_w = (unsigned)w; *out_h = (unsigned)h;
+        return 1;
+    }
+    if (len >= 4 && bytes[0] == 0x89 && bytes[1] == 0x50 && bytes[2] == 0x4E && bytes[3] == 0x47) {
+        unsigned err = lodepng_decode32(out_rgba, out_w, out_h, bytes, len);
+        free(bytes);
+        if (err) {
+            *out_err = lodepng_error_text(err);
+            return 0;
+        }
+        return 1;
+    }
+    free(bytes);
+    *out_err = "unsupported format (not JPEG/PNG)";
+    return 0;
+}
+
 /* Save w*h*4 top-down RGBA8 bytes to `path` as a PNG. Returns 0 on success. */
 static int rae_png_save_rgba32(const char* path, const unsigned char* rgba, int w, int h) {
     if (!path || !rgba || w <= 0 || h <= 0) return 1;
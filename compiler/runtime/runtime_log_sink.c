@@ -0,0 +1,433 @@
+/* Log sink behind log/logS and lib/logging.rae: per-thread line buffers,
+ * buffered flush policies and a background drain thread.
+ *
+ * This module is included by rae_runtime.c into one translation unit.
+ */
+
+/* ----- Log sink --------------------------------------------------------- */
+/* The log functions (runtime_system_log.c) format into the calling thread's
+ * open line instead of stdio. A line only leaves the thread once it is
+ * complete, so lines from concurrent tasks never interleave mid-line.
+ *
+ * Flush policy (RAE_LOG_FLUSH, or logging.setFlush):
+ *
+ *   line      default. Each log call is one write(2) as it returns: a line
+ *             for log, the fragment so far for logS (a prompt or progress
+ *             dots still show at once). Behaves like the old fflush per call.
+ *   size      complete lines collect in a per-thread ring and the thread
+ *             writes the ring out itself once it holds RAE_LOG_FLUSH_BYTES.
+ *   interval  as size, plus a drain thread that writes every ring out every
+ *             RAE_LOG_FLUSH_MS milliseconds, so a quiet thread's lines
+ *             still appear promptly.
+ *
+ * In the buffered policies a logS fragment waits for the rest of its line,
+ * and lines of different threads reach stdout in drain order, not global
+ * call order; each thread's own lines stay in order. Everything buffered is
+ * written at exit, by logging.flush, before a stdin read, and (best effort)
+ * by the crash handler. A thread that exits writes out its unfinished line.
+ *
+ * Each ring is single-producer: its thread appends at `head`. Consumers (a
+ * thread draining its own ring when full, the drain thread, flush, exit)
+ * hold the sink mutex, which also serializes every write to stdout. A
+ * retired thread's ring is reused by the next new thread once drained.
+ *
+ * Levels (lib/logging.rae): RAE_LOG_LEVEL / logging.setLevel drop lines
+ * below the threshold at run time; `rae build --log-level` removes the
+ * calls below it from the program altogether (c_call.c). */
+#define RAE_LOG_RING (256 * 1024)        /* committed bytes per thread; power of two */
+#define RAE_LOG_FLUSH_BYTES (64 * 1024)  /* default RAE_LOG_FLUSH_BYTES */
+#define RAE_LOG_FLUSH_MS 50              /* default RAE_LOG_FLUSH_MS */
+
+/* Policy and level codes; the order is logFlush* / logLevel* in
+ * lib/logging.rae. */
+#define RAE_LOG_POLICY_LINE 0
+#define RAE_LOG_POLICY_SIZE 1
+#define RAE_LOG_POLICY_INTERVAL 2
+#define RAE_LOG_LEVEL_DEBUG 0
+#define RAE_LOG_LEVEL_OFF 4
+
+#if !defined(__wasm__) || defined(RAE_WASM_THREADS)
+#define RAE_LOG_THREADS 1
+#else
+#define RAE_LOG_THREADS 0
+#endif
+
+typedef struct RaeLogThread {
+  char* ring;              /* RAE_LOG_RING bytes; allocated on first buffered line */
+  uint64_t head;           /* producer-owned; release-published */
+  uint64_t tail;           /* consumers, under the mutex; release-published */
+  char* line;              /* the open line; producer only */
+  size_t len;
+  size_t cap;
+  int retired;             /* owning thread exited; atomic */
+  struct RaeLogThread* next;
+} RaeLogThread;
+
+static struct {
+  pthread_mutex_t mu;      /* registry, ring consumers and stdout writes */
+  RaeLogThread* threads;
+  int policy;              /* atomic */
+  int64_t flush_bytes;
+  int64_t flush_ms;
+  int64_t level;           /* runtime threshold; atomic */
+  int stopping;            /* atomic: drain thread should exit */
+  int drainer_running;     /* set under the mutex; atomic */
+  int64_t written;         /* bytes that reached stdout */
+#if RAE_LOG_THREADS
+  pthread_t drainer;
+#endif
+} g_rae_log = {
+  .mu = PTHREAD_MUTEX_INITIALIZER,
+  .flush_bytes = RAE_LOG_FLUSH_BYTES,
+  .flush_ms = RAE_LOG_FLUSH_MS,
+};
+
+static __thread RaeLogThread* g_rae_log_self = NULL;
+
+static void rae_log_lock(void) {
+#if RAE_LOG_THREADS
+  pthread_mutex_lock(&g_rae_log.mu);
+#endif
+}
+
+static void rae_log_unlock(void) {
+#if RAE_LOG_THREADS
+  pthread_mutex_unlock(&g_rae_log.mu);
+#endif
+}
+
+/* All of p to stdout, across short writes and EINTR. write(2) only, so the
+ * crash handler can use it too. */
+static void rae_log_write_fd(const char* p, size_t n) {
+  while (n > 0) {
+    ssize_t w = write(STDOUT_FILENO, p, n);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    p += w;
+    n -= (size_t)w;
+  }
+}
+
+/* Mutex held. */
+static void rae_log_emit(const char* p, size_t n) {
+  rae_log_write_fd(p, n);
+  g_rae_log.written += (int64_t)n;
+}
+
+/* Mutex held (or the crash handler). Writes t's committed bytes. */
+static void rae_log_drain_ring(RaeLogThread* t) {
+  uint64_t head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+  uint64_t tail = t->tail;
+  if (head == tail) return;
+  size_t from = (size_t)(tail & (RAE_LOG_RING - 1));
+  size_t n = (size_t)(head - tail);
+  size_t first = n < RAE_LOG_RING - from ? n : RAE_LOG_RING - from;
+  rae_log_emit(t->ring + from, first);
+  if (first < n) rae_log_emit(t->ring, n - first);
+  __atomic_store_n(&t->tail, head, __ATOMIC_RELEASE);
+}
+
+/* Mutex held. */
+static void rae_log_drain_all(void) {
+  for (RaeLogThread* t = g_rae_log.threads; t; t = t->next) {
+    if (t->ring) rae_log_drain_ring(t);
+  }
+}
+
+#if RAE_LOG_THREADS
+static pthread_key_t g_rae_log_key;
+static pthread_once_t g_rae_log_key_once = PTHREAD_ONCE_INIT;
+
+static void rae_log_commit_open(RaeLogThread* t);
+
+/* Thread exit: the unfinished line goes out with the thread's last lines;
+ * the ring stays registered until it has been drained. */
+static void rae_log_retire(void* p) {
+  RaeLogThread* t = (RaeLogThread*)p;
+  rae_log_commit_open(t);
+  if (__atomic_load_n(&g_rae_log.policy, __ATOMIC_RELAXED) == RAE_LOG_POLICY_SIZE) {
+    rae_log_lock();
+    rae_log_drain_ring(t);
+    rae_log_unlock();
+  }
+  __atomic_store_n(&t->retired, 1, __ATOMIC_RELEASE);
+}
+
+static void rae_log_make_key(void) {
+  pthread_key_create(&g_rae_log_key, rae_log_retire);
+}
+#endif
+
+static RaeLogThread* rae_log_self(void) {
+  RaeLogThread* t = g_rae_log_self;
+  if (t) return t;
+  rae_log_lock();
+  for (RaeLogThread* r = g_rae_log.threads; r; r = r->next) {
+    if (__atomic_load_n(&r->retired, __ATOMIC_ACQUIRE) &&
+        __atomic_load_n(&r->head, __ATOMIC_RELAXED) == r->tail) {
+      t = r;
+      break;
+    }
+  }
+  if (!t) {
+    t = (RaeLogThread*)calloc(1, sizeof(RaeLogThread));
+    if (!t) {
+      rae_log_unlock();
+      return NULL;
+    }
+    t->next = g_rae_log.threads;
+    g_rae_log.threads = t;
+  }
+  t->len = 0;
+  __atomic_store_n(&t->retired, 0, __ATOMIC_RELEASE);
+  rae_log_unlock();
+#if RAE_LOG_THREADS
+  pthread_once(&g_rae_log_key_once, rae_log_make_key);
+  pthread_setspecific(g_rae_log_key, t);
+#endif
+  g_rae_log_self = t;
+  return t;
+}
+
+#if RAE_LOG_THREADS
+static void* rae_log_drainer_main(void* arg) {
+  (void)arg;
+  while (!__atomic_load_n(&g_rae_log.stopping, __ATOMIC_ACQUIRE)) {
+    usleep((useconds_t)(g_rae_log.flush_ms * 1000));
+    rae_log_lock();
+    rae_log_drain_all();
+    rae_log_unlock();
+  }
+  return NULL;
+}
+#endif
+
+/* Mutex held. Started by the first line buffered under `interval`. */
+static void rae_log_start_drainer(void) {
+#if RAE_LOG_THREADS
+  if (g_rae_log.drainer_running) return;
+  __atomic_store_n(&g_rae_log.stopping, 0, __ATOMIC_RELEASE);
+  if (pthread_create(&g_rae_log.drainer, NULL, rae_log_drainer_main, NULL) == 0) {
+    __atomic_store_n(&g_rae_log.drainer_running, 1, __ATOMIC_RELEASE);
+  }
+#endif
+}
+
+/* Joins the drain thread, if any; its last pass may still be writing. */
+static void rae_log_stop_drainer(void) {
+#if RAE_LOG_THREADS
+  rae_log_lock();
+  int running = g_rae_log.drainer_running;
+  __atomic_store_n(&g_rae_log.drainer_running, 0, __ATOMIC_RELEASE);
+  rae_log_unlock();
+  if (!running) return;
+  __atomic_store_n(&g_rae_log.stopping, 1, __ATOMIC_RELEASE);
+  pthread_join(g_rae_log.drainer, NULL);
+#endif
+}
+
+/* Moves t's open line into its ring (buffered policies) or out to stdout
+ * (line policy, or no ring could be allocated). */
+static void rae_log_commit_open(RaeLogThread* t) {
+  size_t n = t->len;
+  if (n == 0) return;
+  t->len = 0;
+  int policy = __atomic_load_n(&g_rae_log.policy, __ATOMIC_RELAXED);
+  if (policy != RAE_LOG_POLICY_LINE && !t->ring) t->ring = (char*)malloc(RAE_LOG_RING);
+  if (policy == RAE_LOG_POLICY_LINE || !t->ring || n > RAE_LOG_RING) {
+    rae_log_lock();
+    if (t->ring) rae_log_drain_ring(t);
+    rae_log_emit(t->line, n);
+    rae_log_unlock();
+    return;
+  }
+  uint64_t head = t->head;
+  if (head - __atomic_load_n(&t->tail, __ATOMIC_ACQUIRE) + n > RAE_LOG_RING) {
+    rae_log_lock();
+    rae_log_drain_ring(t);
+    rae_log_unlock();
+  }
+  size_t at = (size_t)(head & (RAE_LOG_RING - 1));
+  size_t first = n < RAE_LOG_RING - at ? n : RAE_LOG_RING - at;
+  memcpy(t->ring + at, t->line, first);
+  if (first < n) memcpy(t->ring, t->line + first, n - first);
+  __atomic_store_n(&t->head, head + n, __ATOMIC_RELEASE);
+  if (head + n - __atomic_load_n(&t->tail, __ATOMIC_ACQUIRE) >= (uint64_t)g_rae_log.flush_bytes) {
+    rae_log_lock();
+    rae_log_drain_ring(t);
+    rae_log_unlock();
+  } else if (policy == RAE_LOG_POLICY_INTERVAL &&
+             !__atomic_load_n(&g_rae_log.drainer_running, __ATOMIC_ACQUIRE)) {
+    rae_log_lock();
+    rae_log_start_drainer();
+    rae_log_unlock();
+  }
+}
+
+/* ----- Producer side (runtime_system_log.c) ---------------------------- */
+
+/* Room for n more bytes at the end of the open line, or NULL. */
+static char* rae_log_reserve(RaeLogThread* t, size_t n) {
+  if (t->len + n > t->cap) {
+    size_t cap = t->cap ? t->cap * 2 : 256;
+    while (cap < t->len + n) cap *= 2;
+    char* grown = (char*)realloc(t->line, cap);
+    if (!grown) return NULL;
+    t->line = grown;
+    t->cap = cap;
+  }
+  return t->line + t->len;
+}
+
+static void rae_log_put(const void* p, size_t n) {
+  RaeLogThread* t = rae_log_self();
+  char* dst = t ? rae_log_reserve(t, n) : NULL;
+  if (!dst) return;
+  memcpy(dst, p, n);
+  t->len += n;
+}
+
+static void rae_log_puts(const char* s) {
+  rae_log_put(s, strlen(s));
+}
+
+static void rae_log_put_i64(int64_t v) {
+  char buffer[24];
+  rae_log_put(buffer, (size_t)rae_format_i64(buffer, v));
+}
+
+static void rae_log_put_u64(uint64_t v) {
+  char buffer[24];
+  rae_log_put(buffer, (size_t)snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)v));
+}
+
+/* Floats log as toString and interpolation print them. */
+static void rae_log_put_f64(double v) {
+  char buffer[RAE_FLOAT_TEXT_MAX];
+  rae_log_put(buffer, (size_t)rae_format_f64(buffer, v));
+}
+
+static void rae_log_put_f32(float v) {
+  char buffer[RAE_FLOAT_TEXT_MAX];
+  rae_log_put(buffer, (size_t)rae_format_f32(buffer, v));
+}
+
+static void rae_log_put_char(uint32_t v) {
+  uint8_t buffer[4];
+  rae_log_put(buffer, (size_t)rae_format_char(buffer, v));
+}
+
+/* End of a log call: the line is complete. */
+static void rae_log_end_line(void) {
+  rae_log_put("\n", 1);
+  RaeLogThread* t = g_rae_log_self;
+  if (t) rae_log_commit_open(t);
+}
+
+/* End of a logS call: under `line` the fragment goes out now; buffered
+ * policies keep it for the rest of its line. */
+static void rae_log_end_fragment(void) {
+  RaeLogThread* t = g_rae_log_self;
+  if (t && __atomic_load_n(&g_rae_log.policy, __ATOMIC_RELAXED) == RAE_LOG_POLICY_LINE) {
+    rae_log_commit_open(t);
+  }
+}
+
+/* ----- Control (lib/logging.rae) --------------------------------------- */
+
+/* Writes every buffered line, and the caller's unfinished one. Other
+ * threads' unfinished lines stay with them. */
+void rae_ext_rae_log_flush(void) {
+  RaeLogThread* t = g_rae_log_self;
+  if (t) rae_log_commit_open(t);
+  rae_log_lock();
+  rae_log_drain_all();
+  rae_log_unlock();
+}
+
+/* bytes / ms <= 0 keep the current value. Buffered lines are written out
+ * before the policy changes. */
+void rae_ext_rae_log_set_flush(int64_t policy, int64_t bytes, int64_t ms) {
+  if (policy < RAE_LOG_POLICY_LINE || policy > RAE_LOG_POLICY_INTERVAL) return;
+  rae_ext_rae_log_flush();
+  if (policy != RAE_LOG_POLICY_INTERVAL) rae_log_stop_drainer();
+  rae_log_lock();
+  if (bytes > 0) g_rae_log.flush_bytes = bytes > RAE_LOG_RING ? RAE_LOG_RING : bytes;
+  if (ms > 0) g_rae_log.flush_ms = ms;
+  __atomic_store_n(&g_rae_log.policy, (int)policy, __ATOMIC_RELAXED);
+  rae_log_unlock();
+}
+
+int64_t rae_ext_rae_log_flush_policy(void) {
+  return __atomic_load_n(&g_rae_log.policy, __ATOMIC_RELAXED);
+}
+
+void rae_ext_rae_log_set_level(int64_t level) {
+  if (level < RAE_LOG_LEVEL_DEBUG) level = RAE_LOG_LEVEL_DEBUG;
+  if (level > RAE_LOG_LEVEL_OFF) level = RAE_LOG_LEVEL_OFF;
+  __atomic_store_n(&g_rae_log.level, level, __ATOMIC_RELAXED);
+}
+
+int64_t rae_ext_rae_log_level(void) {
+  return __atomic_load_n(&g_rae_log.level, __ATOMIC_RELAXED);
+}
+
+/* Bytes written to stdout so far (log output only). */
+int64_t rae_ext_rae_log_written(void) {
+  rae_log_lock();
+  int64_t n = g_rae_log.written;
+  rae_log_unlock();
+  return n;
+}
+
+/* ----- Startup, exit and crash ----------------------------------------- */
+
+static void rae_log_exit(void) {
+  rae_log_stop_drainer();
+  rae_ext_rae_log_flush();
+}
+
+static int64_t rae_log_parse_level(const char* s) {
+  static const char* names[] = {"debug", "info", "warn", "error", "off"};
+  for (int64_t i = 0; i <= RAE_LOG_LEVEL_OFF; i++) {
+    if (strcmp(s, names[i]) == 0) return i;
+  }
+  return atoll(s);
+}
+
+__attribute__((constructor))
+static void rae_log_init(void) {
+  const char* level = getenv("RAE_LOG_LEVEL");
+  if (level && level[0]) rae_ext_rae_log_set_level(rae_log_parse_level(level));
+  const char* bytes = getenv("RAE_LOG_FLUSH_BYTES");
+  if (bytes && bytes[0] && atoll(bytes) > 0) {
+    g_rae_log.flush_bytes = atoll(bytes) > RAE_LOG_RING ? RAE_LOG_RING : atoll(bytes);
+  }
+  const char* ms = getenv("RAE_LOG_FLUSH_MS");
+  if (ms && ms[0] && atoll(ms) > 0) g_rae_log.flush_ms = atoll(ms);
+  const char* policy = getenv("RAE_LOG_FLUSH");
+  if (policy && strcmp(policy, "size") == 0) g_rae_log.policy = RAE_LOG_POLICY_SIZE;
+  else if (policy && strcmp(policy, "interval") == 0) g_rae_log.policy = RAE_LOG_POLICY_INTERVAL;
+  atexit(rae_log_exit);
+}
+
+/* Crash handler and hard-exit hook. Best effort: write(2) only and no
+ * waiting; if another thread holds the sink lock, only the current
+ * thread's unfinished line is written. */
+void rae_log_crash_flush(void) {
+#if RAE_LOG_THREADS
+  if (pthread_mutex_trylock(&g_rae_log.mu) == 0) {
+    rae_log_drain_all();
+    pthread_mutex_unlock(&g_rae_log.mu);
+  }
+#else
+  rae_log_drain_all();
+#endif
+  RaeLogThread* t = g_rae_log_self;
+  if (t && t->len > 0) {
+    rae_log_write_fd(t->line, t->len);
+    t->len = 0;
+  }
+}
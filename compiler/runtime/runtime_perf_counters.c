@@ -0,0 +1,208 @@
+/* Hardware performance counters (perfCounters* in lib/sys.rae,
+ * profilePerfCounters in lib/profile.rae, and `rae bench` reports).
+ *
+ * This module is included by rae_runtime.c into one translation unit.
+ */
+
+/* ----- Performance counters ------------------------------------------- */
+/* Each thread that asks opens its own counters with perf_event_open on
+ * first use: cycles, instructions, cache misses and branch misses as one
+ * group (so IPC comes from one scheduling window), and page faults, a
+ * software event, on its own. They count the calling thread, user space
+ * only, which is what perf_event_paranoid 2 (the common default) allows
+ * an unprivileged process, from open until the thread exits.
+ *
+ * Any counter may be missing: no PMU in a VM or container, a kernel
+ * without perf events, a seccomp filter, or an event the CPU lacks. A
+ * missing counter reads -1 and the rest still work; without the group
+ * leader (cycles) there are no hardware counters at all, but page faults
+ * usually remain. Off Linux every counter is missing.
+ *
+ * When more events are scheduled than the PMU has counters, the kernel
+ * multiplexes the group; readings are scaled by enabled / running time,
+ * the estimate `perf stat` prints. */
+#define RAE_PERF_CYCLES 0
+#define RAE_PERF_INSTRUCTIONS 1
+#define RAE_PERF_CACHE_MISSES 2
+#define RAE_PERF_BRANCH_MISSES 3
+#define RAE_PERF_PAGE_FAULTS 4
+#define RAE_PERF_COUNT 5
+
+/* Counter track names in profile captures, in RAE_PERF_* order. */
+static const char* const g_rae_perf_names[RAE_PERF_COUNT] = {
+  "cycles", "instructions", "cache misses", "branch misses", "page faults"
+};
+
+typedef struct {
+  int64_t v[RAE_PERF_COUNT];  /* -1: counter unavailable */
+} RaePerfValues;
+
+typedef struct {
+  int opened;
+  int fd[RAE_PERF_COUNT];     /* -1: not open */
+  int slot[RAE_PERF_COUNT];   /* position in the group read */
+  int group_size;
+  RaePerfValues begin;        /* perfCountersBegin reading */
+  RaePerfValues last;         /* perfCountersEnd deltas */
+  RaePerfValues prof_prev;    /* profilePerfCounters' previous reading */
+  int64_t prof_capture;       /* start_ns of the capture prof_prev is from */
+} RaePerfThread;
+
+static __thread RaePerfThread g_rae_perf_self;
+
+#if defined(__linux__) && !defined(__wasm__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+
+static pthread_key_t g_rae_perf_key;
+static pthread_once_t g_rae_perf_key_once = PTHREAD_ONCE_INIT;
+
+static void rae_perf_close(void* p) {
+  RaePerfThread* t = (RaePerfThread*)p;
+  for (int i = 0; i < RAE_PERF_COUNT; i++) {
+    if (t->fd[i] >= 0) close(t->fd[i]);
+    t->fd[i] = -1;
+  }
+}
+
+static void rae_perf_make_key(void) {
+  pthread_key_create(&g_rae_perf_key, rae_perf_close);
+}
+
+static int rae_perf_open_one(uint32_t type, uint64_t config, int group_fd, uint64_t read_format) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = read_format;
+  return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+static RaePerfThread* rae_perf_self(void) {
+  RaePerfThread* t = &g_rae_perf_self;
+  if (t->opened) return t;
+  t->opened = 1;
+  for (int i = 0; i < RAE_PERF_COUNT; i++) t->fd[i] = -1;
+  static const uint64_t hw[RAE_PERF_PAGE_FAULTS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+  };
+  uint64_t group_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  int leader = rae_perf_open_one(PERF_TYPE_HARDWARE, hw[0], -1, group_format);
+  if (leader >= 0) {
+    t->fd[RAE_PERF_CYCLES] = leader;
+    t->slot[RAE_PERF_CYCLES] = t->group_size++;
+    for (int i = 1; i < RAE_PERF_PAGE_FAULTS; i++) {
+      t->fd[i] = rae_perf_open_one(PERF_TYPE_HARDWARE, hw[i], leader, group_format);
+      if (t->fd[i] >= 0) t->slot[i] = t->group_size++;
+    }
+  }
+  t->fd[RAE_PERF_PAGE_FAULTS] = rae_perf_open_one(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, -1, 0);
+  pthread_once(&g_rae_perf_key_once, rae_perf_make_key);
+  pthread_setspecific(g_rae_perf_key, t);
+  return t;
+}
+
+/* Current counts since open; returns whether any counter is available. */
+static int rae_perf_read(RaePerfValues* out) {
+  RaePerfThread* t = rae_perf_self();
+  int any = 0;
+  for (int i = 0; i < RAE_PERF_COUNT; i++) out->v[i] = -1;
+  if (t->fd[RAE_PERF_CYCLES] >= 0) {
+    uint64_t buf[3 + RAE_PERF_COUNT];
+    ssize_t want = (ssize_t)((3 + t->group_size) * sizeof(uint64_t));
+    if (read(t->fd[RAE_PERF_CYCLES], buf, sizeof(buf)) == want && buf[2] > 0) {
+      double scale = (double)buf[1] / (double)buf[2];
+      for (int i = 0; i < RAE_PERF_PAGE_FAULTS; i++) {
+        if (t->fd[i] < 0) continue;
+        uint64_t raw = buf[3 + t->slot[i]];
+        out->v[i] = scale > 1.0 ? (int64_t)((double)raw * scale) : (int64_t)raw;
+        any = 1;
+      }
+    }
+  }
+  uint64_t faults;
+  if (t->fd[RAE_PERF_PAGE_FAULTS] >= 0 &&
+      read(t->fd[RAE_PERF_PAGE_FAULTS], &faults, sizeof(faults)) == (ssize_t)sizeof(faults)) {
+    out->v[RAE_PERF_PAGE_FAULTS] = (int64_t)faults;
+    any = 1;
+  }
+  return any;
+}
+#else
+static RaePerfThread* rae_perf_self(void) {
+  RaePerfThread* t = &g_rae_perf_self;
+  if (!t->opened) {
+    t->opened = 1;
+    for (int i = 0; i < RAE_PERF_COUNT; i++) t->fd[i] = -1;
+  }
+  return t;
+}
+
+static int rae_perf_read(RaePerfValues* out) {
+  rae_perf_self();
+  for (int i = 0; i < RAE_PERF_COUNT; i++) out->v[i] = -1;
+  return 0;
+}
+#endif
+
+/* `to - from` per counter, -1 where either reading is missing. */
+static void rae_perf_delta(const RaePerfValues* from, const RaePerfValues* to, RaePerfValues* out) {
+  for (int i = 0; i < RAE_PERF_COUNT; i++) {
+    out->v[i] = from->v[i] >= 0 && to->v[i] >= 0 ? to->v[i] - from->v[i] : -1;
+  }
+}
+
+/* ----- Rae entry points ------------------------------------------------ */
+
+rae_Bool rae_ext_rae_sys_perf_available(int64_t which) {
+  RaePerfThread* t = rae_perf_self();
+  if (which < 0 || which >= RAE_PERF_COUNT) {
+    for (int i = 0; i < RAE_PERF_COUNT; i++) {
+      if (t->fd[i] >= 0) return 1;
+    }
+    return 0;
+  }
+  return t->fd[which] >= 0;
+}
+
+void rae_ext_rae_sys_perf_begin(void) {
+  RaePerfThread* t = rae_perf_self();
+  rae_perf_read(&t->begin);
+}
+
+void rae_ext_rae_sys_perf_end(void) {
+  RaePerfValues now;
+  rae_perf_read(&now);
+  RaePerfThread* t = rae_perf_self();
+  rae_perf_delta(&t->begin, &now, &t->last);
+}
+
+/* One counter of the last begin/end pair on this thread; -1 if missing. */
+int64_t rae_ext_rae_sys_perf_value(int64_t which) {
+  if (which < 0 || which >= RAE_PERF_COUNT) return -1;
+  return rae_perf_self()->last.v[which];
+}
+
+/* Record each available counter's change since the previous call as a
+ * counter event in the running profile capture. The first call of a
+ * capture on a thread only takes the starting reading. */
+void rae_ext_rae_sys_perf_profile(void) {
+  if (!rae_ext_rae_sys_prof_active()) return;
+  RaePerfThread* t = rae_perf_self();
+  RaePerfValues now, delta;
+  if (!rae_perf_read(&now)) return;
+  if (t->prof_capture == g_rae_prof.start_ns) {
+    rae_perf_delta(&t->prof_prev, &now, &delta);
+    for (int i = 0; i < RAE_PERF_COUNT; i++) {
+      if (delta.v[i] < 0) continue;
+      const char* name = g_rae_perf_names[i];
+      rae_ext_rae_sys_prof_event((rae_String){(uint8_t*)name, (int64_t)strlen(name), 0, 0}, RAE_PROF_COUNTER, delta.v[i]);
+    }
+  }
+  t->prof_prev = now;
+  t->prof_capture = g_rae_prof.start_ns;
+}
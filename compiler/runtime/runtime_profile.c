@@ -0,0 +1,679 @@
+/* Frame profiler kernel (lib/profile.rae): per-thread binary event rings and
+ * a background trace writer.
+ *
+ * This module is included by rae_runtime.c into one translation unit.
+ */
+
+/* ----- Profiler (lib/profile.rae) ------------------------------------- */
+/* Every thread that records a zone gets its own single-producer ring of
+ * fixed-size records {ts, value, name id, phase}; recording is a relaxed
+ * flag test, a clock read, a name lookup that almost always hits a small
+ * per-thread cache, and one release store of the ring head. No lock, no
+ * allocation, no string copy.
+ *
+ * Zone names are interned once into a global append-only table (mutex on a
+ * miss only). The per-thread cache is keyed by the name's data pointer and
+ * length but is confirmed against the interned bytes, so a heap name whose
+ * storage is reused for different text can never alias another zone.
+ *
+ * A writer thread wakes every few milliseconds, drains every ring (it is the
+ * single consumer: it owns `tail`) and streams the events to disk, so a
+ * capture is bounded by disk, not memory. A ring that fills faster than the
+ * writer drains it drops events and counts them. Output is Chrome Trace
+ * Event JSON, or Perfetto protobuf (TracePacket / TrackEvent) when the path
+ * ends in `.pftrace` or `.perfetto-trace`.
+ *
+ * Each OS thread is its own track (`tid`): the capturing thread is tid 0
+ * ("CPU main loop"), others are numbered as they first record and can be
+ * renamed with rae_sys_prof_thread_name. A thread's ring is retired when it
+ * exits and reused, under a fresh tid, by the next new thread once drained,
+ * so short-lived spawn tasks don't accumulate rings.
+ *
+ * Compiler-inserted zones (`rae build --instrument`) come in through
+ * rae_prof_enter/leave with a static per-function RaeProfSite that caches
+ * its interned id, so they skip even the name cache. A site whose zones
+ * average under RAE_PROFILE_MIN_ZONE_NS after its first calls is muted for
+ * the rest of the run: a zone costs two clock reads, and a function that
+ * short, called that often, is mostly measuring the profiler. An instrumented
+ * program starts its own capture from RAE_PROFILE* at the top of main and
+ * finishes it at exit; a crash writes out what the rings hold, leaving the
+ * zones that were open at the fault unterminated in the trace.
+ *
+ * The JSON is the array form of the Trace Event format, whose closing `]`
+ * is optional, so a trace cut short by a crash still loads.
+ *
+ * Single-threaded wasm has no writer: a full ring is drained inline by the
+ * recording call instead, and stop drains the rest. */
+#define RAE_PROF_RING 16384          /* events per thread; power of two */
+#define RAE_PROF_MAX_NAMES 4096
+#define RAE_PROF_NAME_SLOTS 8192     /* open-addressing table; 2x names */
+#define RAE_PROF_NAME_MAX 200        /* longer names are truncated */
+#define RAE_PROF_CACHE 64            /* per-thread name cache; power of two */
+#define RAE_PROF_WRITER_US 2000
+#define RAE_PROF_MUTE_AFTER 1024     /* site calls before muting is judged */
+#define RAE_PROF_MIN_ZONE_NS 2000    /* default RAE_PROFILE_MIN_ZONE_NS */
+#define RAE_PROF_MUTED_MAX 64        /* muted site names kept for the report */
+
+/* Phase codes; the order is profPh* in lib/profile.rae. */
+#define RAE_PROF_BEGIN 0
+#define RAE_PROF_END 1
+#define RAE_PROF_COUNTER 2
+
+#if !defined(__wasm__) || defined(RAE_WASM_THREADS)
+#define RAE_PROF_THREADS 1
+#else
+#define RAE_PROF_THREADS 0
+#endif
+
+typedef struct {
+  int64_t ts;
+  int64_t value;
+  uint32_t name;
+  uint32_t ph;
+} RaeProfEvent;
+
+typedef struct RaeProfThread {
+  RaeProfEvent ring[RAE_PROF_RING];
+  /* Producer and writer fields sit on separate cache lines, and the
+   * producer re-reads `tail` only when its cached copy says the ring is
+   * full, so draining never bounces the recording thread's line. */
+  uint64_t head;           /* producer-owned; release-published */
+  uint64_t tail_seen;      /* producer's last read of `tail` */
+  uint64_t dropped;        /* events lost to a full ring; atomic */
+  uint32_t open;           /* recorded site zones not yet closed */
+  uint8_t pad[64];
+  uint64_t tail;           /* writer-owned; release-published */
+  int64_t tid;
+  int retired;             /* owning thread exited; atomic */
+  uint32_t name_seq;       /* bumped on rename, under the profiler mutex */
+  uint32_t announced_seq;  /* writer-only: name_seq last written to the trace */
+  char name[64];
+  struct { const uint8_t* ptr; int64_t len; uint32_t id; } cache[RAE_PROF_CACHE];
+  struct RaeProfThread* next;
+} RaeProfThread;
+
+static struct {
+  pthread_mutex_t mu;      /* registry, name-table inserts and track names */
+  RaeProfThread* threads;
+  int64_t next_tid;
+  char* names[RAE_PROF_MAX_NAMES];
+  char* json_names[RAE_PROF_MAX_NAMES];  /* JSON-escaped, for the writer */
+  uint32_t name_len[RAE_PROF_MAX_NAMES];
+  uint32_t name_count;     /* release-published */
+  uint32_t slots[RAE_PROF_NAME_SLOTS];   /* name id + 1; 0 is empty */
+  int stopping;            /* atomic: writer should exit */
+  int64_t start_ns;
+  int64_t end_ns;          /* writer finishes the capture here; 0 = never */
+  int writer_running;      /* capturing thread: writer needs a join */
+  int finished;            /* atomic: the open capture's file is closed */
+  int64_t result;          /* events written by the last finish, -1 failed */
+  FILE* out;
+  int proto;
+  int first_event;
+  int64_t written;
+  int64_t dropped;         /* of the last finished capture */
+  int64_t min_zone_ns;     /* site mute threshold; 0 = never mute */
+  const char* muted[RAE_PROF_MUTED_MAX];
+  int64_t muted_count;
+  uint8_t counter_track[RAE_PROF_MAX_NAMES];  /* Perfetto counter track written */
+#if RAE_PROF_THREADS
+  pthread_t writer;
+#endif
+} g_rae_prof = { .mu = PTHREAD_MUTEX_INITIALIZER, .min_zone_ns = RAE_PROF_MIN_ZONE_NS };
+
+/* Nonzero while a capture is recording; atomic. Exported so the inline
+ * rae_prof_enter/leave in rae_runtime.h can test it without a call. */
+int rae_prof_recording;
+
+static __thread RaeProfThread* g_rae_prof_self = NULL;
+
+static void rae_prof_lock(void) {
+#if RAE_PROF_THREADS
+  pthread_mutex_lock(&g_rae_prof.mu);
+#endif
+}
+
+static void rae_prof_unlock(void) {
+#if RAE_PROF_THREADS
+  pthread_mutex_unlock(&g_rae_prof.mu);
+#endif
+}
+
+#if RAE_PROF_THREADS
+static pthread_key_t g_rae_prof_key;
+static pthread_once_t g_rae_prof_key_once = PTHREAD_ONCE_INIT;
+
+/* Thread exit: the ring stays registered until the writer has drained it. */
+static void rae_prof_retire(void* p) {
+  __atomic_store_n(&((RaeProfThread*)p)->retired, 1, __ATOMIC_RELEASE);
+}
+
+static void rae_prof_make_key(void) {
+  pthread_key_create(&g_rae_prof_key, rae_prof_retire);
+}
+#endif
+
+/* `out` holds at least 6 * len + 1 bytes. */
+static void rae_prof_json_escape(char* out, const char* in, size_t len) {
+  size_t k = 0;
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = (unsigned char)in[i];
+    if (c == '"' || c == '\\') { out[k++] = '\\'; out[k++] = (char)c; }
+    else if (c < 0x20) { k += (size_t)snprintf(out + k, 7, "\\u%04x", c); }
+    else out[k++] = (char)c;
+  }
+  out[k] = '\0';
+}
+
+/* Called with the mutex held. Id 0 is the shared name for overflow. */
+static uint32_t rae_prof_add_name(const uint8_t* p, int64_t len) {
+  uint32_t id = g_rae_prof.name_count;
+  char* raw = (char*)malloc((size_t)len + 1);
+  char* esc = (char*)malloc((size_t)len * 6 + 1);
+  if (!raw || !esc) { free(raw); free(esc); return 0; }
+  memcpy(raw, p, (size_t)len);
+  raw[len] = '\0';
+  rae_prof_json_escape(esc, raw, (size_t)len);
+  g_rae_prof.names[id] = raw;
+  g_rae_prof.json_names[id] = esc;
+  g_rae_prof.name_len[id] = (uint32_t)len;
+  __atomic_store_n(&g_rae_prof.name_count, id + 1, __ATOMIC_RELEASE);
+  return id;
+}
+
+static uint32_t rae_prof_intern(RaeProfThread* t, rae_String s) {
+  int64_t len = s.len > RAE_PROF_NAME_MAX ? RAE_PROF_NAME_MAX : (s.len < 0 ? 0 : s.len);
+  const uint8_t* p = s.data ? s.data : (const uint8_t*)"";
+  unsigned c = (unsigned)(((uintptr_t)p >> 3) ^ (uintptr_t)len) & (RAE_PROF_CACHE - 1);
+  if (t->cache[c].ptr == p && t->cache[c].len == len &&
+      memcmp(g_rae_prof.names[t->cache[c].id], p, (size_t)len) == 0) {
+    return t->cache[c].id;
+  }
+  uint32_t h = 2166136261u;
+  for (int64_t i = 0; i < len; i++) h = (h ^ p[i]) * 16777619u;
+  uint32_t id = 0;
+  rae_prof_lock();
+  if (g_rae_prof.name_count == 0) rae_prof_add_name((const uint8_t*)"(names exhausted)", 17);
+  for (uint32_t i = h & (RAE_PROF_NAME_SLOTS - 1);; i = (i + 1) & (RAE_PROF_NAME_SLOTS - 1)) {
+    uint32_t slot = g_rae_prof.slots[i];
+    if (slot == 0) {
+      if (g_rae_prof.name_count < RAE_PROF_MAX_NAMES) {
+        id = rae_prof_add_name(p, len);
+        if (id != 0) g_rae_prof.slots[i] = id + 1;
+      }
+      break;
+    }
+    if (g_rae_prof.name_len[slot - 1] == (uint32_t)len &&
+        memcmp(g_rae_prof.names[slot - 1], p, (size_t)len) == 0) {
+      id = slot - 1;
+      break;
+    }
+  }
+  rae_prof_unlock();
+  if (id != 0) {
+    t->cache[c].ptr = p;
+    t->cache[c].len = len;
+    t->cache[c].id = id;
+  }
+  return id;
+}
+
+static RaeProfThread* rae_prof_self(void) {
+  RaeProfThread* t = g_rae_prof_self;
+  if (t) return t;
+  rae_prof_lock();
+  for (RaeProfThread* r = g_rae_prof.threads; r; r = r->next) {
+    if (__atomic_load_n(&r->retired, __ATOMIC_ACQUIRE) &&
+        __atomic_load_n(&r->head, __ATOMIC_RELAXED) == __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE)) {
+      t = r;
+      break;
+    }
+  }
+  if (!t) {
+    /* malloc + memset rather than calloc: calloc hands back untouched zero
+     * pages, which would then fault in one per ~170 events in the middle of
+     * measured zones. */
+    t = (RaeProfThread*)malloc(sizeof(RaeProfThread));
+    if (!t) { rae_prof_unlock(); return NULL; }
+    memset(t, 0, sizeof(RaeProfThread));
+    t->next = g_rae_prof.threads;
+    g_rae_prof.threads = t;
+  }
+  t->tid = g_rae_prof.next_tid++;
+  t->name[0] = '\0';
+  t->name_seq++;
+  t->dropped = 0;
+  t->open = 0;
+  __atomic_store_n(&t->retired, 0, __ATOMIC_RELEASE);
+  rae_prof_unlock();
+#if RAE_PROF_THREADS
+  pthread_once(&g_rae_prof_key_once, rae_prof_make_key);
+  pthread_setspecific(g_rae_prof_key, t);
+#endif
+  g_rae_prof_self = t;
+  return t;
+}
+
+/* ----- Trace encoding (writer side) ----------------------------------- */
+
+typedef struct { uint8_t b[512]; size_t n; } RaeProfPb;
+
+static void rae_pb_varint(RaeProfPb* pb, uint64_t v) {
+  while (v >= 0x80 && pb->n < sizeof(pb->b)) { pb->b[pb->n++] = (uint8_t)(v | 0x80); v >>= 7; }
+  if (pb->n < sizeof(pb->b)) pb->b[pb->n++] = (uint8_t)v;
+}
+
+static void rae_pb_uint(RaeProfPb* pb, uint32_t field, uint64_t v) {
+  rae_pb_varint(pb, (uint64_t)field << 3);
+  rae_pb_varint(pb, v);
+}
+
+static void rae_pb_bytes(RaeProfPb* pb, uint32_t field, const void* data, size_t len) {
+  rae_pb_varint(pb, ((uint64_t)field << 3) | 2);
+  rae_pb_varint(pb, len);
+  if (pb->n + len > sizeof(pb->b)) len = sizeof(pb->b) - pb->n;
+  memcpy(pb->b + pb->n, data, len);
+  pb->n += len;
+}
+
+/* One `Trace.packet` (field 1) record. */
+static void rae_prof_put_packet(const RaeProfPb* packet) {
+  RaeProfPb head = { .n = 0 };
+  rae_pb_varint(&head, (1u << 3) | 2);
+  rae_pb_varint(&head, packet->n);
+  fwrite(head.b, 1, head.n, g_rae_prof.out);
+  fwrite(packet->b, 1, packet->n, g_rae_prof.out);
+}
+
+/* Perfetto track uuids: the process, one per thread, one per counter name. */
+#define RAE_PROF_UUID_PROCESS 1
+#define RAE_PROF_UUID_THREAD(tid) (0x10000ull + (uint64_t)(tid))
+#define RAE_PROF_UUID_COUNTER(id) (0x100000000ull + (uint64_t)(id))
+
+static void rae_prof_put_track(uint64_t uuid, const char* name, int64_t tid, int counter) {
+  RaeProfPb desc = { .n = 0 };
+  rae_pb_uint(&desc, 1, uuid);
+  if (uuid == RAE_PROF_UUID_PROCESS) {
+    RaeProfPb proc = { .n = 0 };
+    rae_pb_uint(&proc, 1, 1);                      /* pid */
+    rae_pb_bytes(&proc, 6, "rae", 3);              /* process_name */
+    rae_pb_bytes(&desc, 3, proc.b, proc.n);
+  } else if (counter) {
+    rae_pb_bytes(&desc, 2, name, strlen(name));
+    rae_pb_uint(&desc, 5, RAE_PROF_UUID_PROCESS);  /* parent_uuid */
+    rae_pb_bytes(&desc, 8, "", 0);                 /* CounterDescriptor */
+  } else {
+    RaeProfPb th = { .n = 0 };
+    rae_pb_uint(&th, 1, 1);                        /* pid */
+    rae_pb_uint(&th, 2, (uint64_t)tid + 1);        /* tid; 0 is the idle task */
+    rae_pb_bytes(&th, 5, name, strlen(name));      /* thread_name */
+    rae_pb_uint(&desc, 5, RAE_PROF_UUID_PROCESS);
+    rae_pb_bytes(&desc, 4, th.b, th.n);
+  }
+  RaeProfPb packet = { .n = 0 };
+  rae_pb_bytes(&packet, 60, desc.b, desc.n);       /* track_descriptor */
+  rae_prof_put_packet(&packet);
+}
+
+static void rae_prof_put_thread_name(RaeProfThread* t) {
+  char name[64];
+  if (t->name[0]) snprintf(name, sizeof(name), "%s", t->name);
+  else if (t->tid == 0) snprintf(name, sizeof(name), "CPU main loop");
+  else snprintf(name, sizeof(name), "worker %lld", (long long)t->tid);
+  if (g_rae_prof.proto) {
+    rae_prof_put_track(RAE_PROF_UUID_THREAD(t->tid), name, t->tid, 0);
+    return;
+  }
+  char esc[sizeof(name) * 6];
+  rae_prof_json_escape(esc, name, strlen(name));
+  fprintf(g_rae_prof.out,
+          "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lld,\"args\":{\"name\":\"%s\"}}",
+          g_rae_prof.first_event ? "" : ",\n", (long long)t->tid, esc);
+  g_rae_prof.first_event = 0;
+}
+
+static void rae_prof_put_event(const RaeProfThread* t, const RaeProfEvent* e) {
+  int64_t rel = e->ts - g_rae_prof.start_ns;
+  if (rel < 0) rel = 0;
+  uint32_t id = e->name < __atomic_load_n(&g_rae_prof.name_count, __ATOMIC_ACQUIRE) ? e->name : 0;
+  if (g_rae_prof.proto) {
+    if (e->ph == RAE_PROF_COUNTER && !g_rae_prof.counter_track[id]) {
+      rae_prof_put_track(RAE_PROF_UUID_COUNTER(id), g_rae_prof.names[id], 0, 1);
+      g_rae_prof.counter_track[id] = 1;
+    }
+    RaeProfPb ev = { .n = 0 };
+    if (e->ph == RAE_PROF_COUNTER) {
+      rae_pb_uint(&ev, 9, 4);                      /* TYPE_COUNTER */
+      rae_pb_uint(&ev, 11, RAE_PROF_UUID_COUNTER(id));
+      rae_pb_uint(&ev, 30, (uint64_t)e->value);    /* counter_value */
+    } else {
+      rae_pb_uint(&ev, 9, e->ph == RAE_PROF_BEGIN ? 1 : 2);  /* SLICE_BEGIN / END */
+      rae_pb_uint(&ev, 11, RAE_PROF_UUID_THREAD(t->tid));
+      if (e->ph == RAE_PROF_BEGIN) rae_pb_bytes(&ev, 23, g_rae_prof.names[id], g_rae_prof.name_len[id]);
+    }
+    RaeProfPb packet = { .n = 0 };
+    rae_pb_uint(&packet, 8, (uint64_t)rel);        /* timestamp */
+    rae_pb_uint(&packet, 10, 1);                   /* trusted_packet_sequence_id */
+    rae_pb_bytes(&packet, 11, ev.b, ev.n);         /* track_event */
+    rae_prof_put_packet(&packet);
+    return;
+  }
+  const char* sep = g_rae_prof.first_event ? "" : ",\n";
+  g_rae_prof.first_event = 0;
+  if (e->ph == RAE_PROF_COUNTER) {
+    fprintf(g_rae_prof.out,
+            "%s{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%lld.%03lld,\"pid\":1,\"tid\":%lld,\"args\":{\"v\":%lld}}",
+            sep, g_rae_prof.json_names[id], (long long)(rel / 1000), (long long)(rel % 1000),
+            (long long)t->tid, (long long)e->value);
+  } else {
+    fprintf(g_rae_prof.out,
+            "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld.%03lld,\"pid\":1,\"tid\":%lld}",
+            sep, g_rae_prof.json_names[id], e->ph == RAE_PROF_BEGIN ? 'B' : 'E',
+            (long long)(rel / 1000), (long long)(rel % 1000), (long long)t->tid);
+  }
+}
+
+/* Consumer side: only the writer (or stop, after the writer has exited)
+ * calls this. Holding the mutex keeps the registry and track names stable;
+ * producers never take it on the recording path. */
+static void rae_prof_drain(void) {
+  rae_prof_lock();
+  for (RaeProfThread* t = g_rae_prof.threads; t; t = t->next) {
+    uint64_t head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = t->tail;
+    if (head == tail) continue;
+    if (t->announced_seq != t->name_seq) {
+      rae_prof_put_thread_name(t);
+      t->announced_seq = t->name_seq;
+    }
+    for (; tail != head; tail++) {
+      rae_prof_put_event(t, &t->ring[tail & (RAE_PROF_RING - 1)]);
+      g_rae_prof.written++;
+    }
+    __atomic_store_n(&t->tail, tail, __ATOMIC_RELEASE);
+  }
+  rae_prof_unlock();
+}
+
+/* Final drain, footer and close; idempotent. Runs on the writer at the
+ * deadline, or on the stopping thread once the writer has been joined. */
+static void rae_prof_finish(void) {
+  if (!g_rae_prof.out) return;
+  __atomic_store_n(&rae_prof_recording, 0, __ATOMIC_RELEASE);
+  rae_prof_drain();
+  rae_prof_lock();
+  int64_t dropped = 0;
+  for (RaeProfThread* t = g_rae_prof.threads; t; t = t->next) {
+    dropped += (int64_t)__atomic_load_n(&t->dropped, __ATOMIC_RELAXED);
+  }
+  rae_prof_unlock();
+  g_rae_prof.dropped = dropped;
+  if (!g_rae_prof.proto) fputs("\n]\n", g_rae_prof.out);
+  int failed = ferror(g_rae_prof.out);
+  if (fclose(g_rae_prof.out) != 0) failed = 1;
+  g_rae_prof.out = NULL;
+  g_rae_prof.result = failed ? -1 : g_rae_prof.written;
+  __atomic_store_n(&g_rae_prof.finished, 1, __ATOMIC_RELEASE);
+}
+
+#if RAE_PROF_THREADS
+static void* rae_prof_writer_main(void* arg) {
+  (void)arg;
+  while (!__atomic_load_n(&g_rae_prof.stopping, __ATOMIC_ACQUIRE)) {
+    usleep(RAE_PROF_WRITER_US);
+    if (g_rae_prof.end_ns && rae_ext_nowNs() >= g_rae_prof.end_ns) {
+      rae_prof_finish();
+      break;
+    }
+    rae_prof_drain();
+  }
+  return NULL;
+}
+#endif
+
+/* ----- Rae entry points ------------------------------------------------ */
+
+rae_Bool rae_ext_rae_sys_prof_active(void) {
+  return __atomic_load_n(&rae_prof_recording, __ATOMIC_RELAXED) != 0;
+}
+
+/* The slot for the calling thread's next event, or NULL when the ring has
+ * no room beyond `reserve` further events (counted as dropped). Publish it
+ * with rae_prof_commit. */
+static RaeProfEvent* rae_prof_slot(RaeProfThread* t, uint64_t reserve) {
+  uint64_t head = t->head;
+  if (head - t->tail_seen + reserve >= RAE_PROF_RING) {
+#if !RAE_PROF_THREADS
+    rae_prof_drain();
+#endif
+    t->tail_seen = __atomic_load_n(&t->tail, __ATOMIC_ACQUIRE);
+    if (head - t->tail_seen + reserve >= RAE_PROF_RING) {
+      __atomic_fetch_add(&t->dropped, 1, __ATOMIC_RELAXED);
+      return NULL;
+    }
+  }
+  return &t->ring[head & (RAE_PROF_RING - 1)];
+}
+
+static void rae_prof_commit(RaeProfThread* t) {
+  __atomic_store_n(&t->head, t->head + 1, __ATOMIC_RELEASE);
+}
+
+void rae_ext_rae_sys_prof_event(rae_String name, int64_t ph, int64_t value) {
+  if (!__atomic_load_n(&rae_prof_recording, __ATOMIC_RELAXED)) return;
+  RaeProfThread* t = rae_prof_self();
+  if (!t) return;
+  RaeProfEvent* e = rae_prof_slot(t, t->open);
+  if (!e) return;
+  e->name = rae_prof_intern(t, name);
+  e->ph = (uint32_t)ph;
+  e->value = value;
+  e->ts = rae_ext_nowNs();
+  rae_prof_commit(t);
+}
+
+static int64_t rae_prof_site_event(RaeProfThread* t, RaeProfEvent* e, RaeProfSite* site, uint32_t ph) {
+  uint32_t id = __atomic_load_n(&site->id, __ATOMIC_RELAXED);
+  if (id == 0) {
+    id = rae_prof_intern(t, (rae_String){(uint8_t*)site->name, site->len, 0, 0});
+    __atomic_store_n(&site->id, id, __ATOMIC_RELAXED);
+  }
+  e->name = id;
+  e->ph = ph;
+  e->value = 0;
+  e->ts = rae_ext_nowNs();
+  rae_prof_commit(t);
+  return e->ts;
+}
+
+static void rae_prof_mute(RaeProfSite* site, int64_t dur) {
+  int64_t calls = __atomic_add_fetch(&site->calls, 1, __ATOMIC_RELAXED);
+  int64_t total = __atomic_add_fetch(&site->total_ns, dur, __ATOMIC_RELAXED);
+  if (calls != RAE_PROF_MUTE_AFTER || total >= g_rae_prof.min_zone_ns * calls) return;
+  __atomic_store_n(&site->muted, 1, __ATOMIC_RELAXED);
+  rae_prof_lock();
+  if (g_rae_prof.muted_count < RAE_PROF_MUTED_MAX) g_rae_prof.muted[g_rae_prof.muted_count] = site->name;
+  g_rae_prof.muted_count++;
+  rae_prof_unlock();
+}
+
+/* Compiler-inserted zones stay balanced under overload: enter returns its
+ * timestamp, or 0 when the begin was dropped, and leave records the end only
+ * for a recorded begin. A thread keeps ring room for the end of every zone
+ * it has open, so that end always fits. */
+int64_t rae_prof_enter_slow(RaeProfSite* site) {
+  RaeProfThread* t = rae_prof_self();
+  if (!t) return 0;
+  RaeProfEvent* e = rae_prof_slot(t, t->open + 1);
+  if (!e) return 0;
+  t->open++;
+  return rae_prof_site_event(t, e, site, RAE_PROF_BEGIN);
+}
+
+void rae_prof_leave_slow(RaeProfSite* site, int64_t t0) {
+  RaeProfThread* t = rae_prof_self();
+  if (!t) return;
+  if (t->open) t->open--;
+  /* The capture stopped inside the zone. */
+  if (!__atomic_load_n(&rae_prof_recording, __ATOMIC_RELAXED)) return;
+  RaeProfEvent* e = rae_prof_slot(t, 0);
+  if (!e) return;
+  int64_t t1 = rae_prof_site_event(t, e, site, RAE_PROF_END);
+  if (g_rae_prof.min_zone_ns > 0) rae_prof_mute(site, t1 - t0);
+}
+
+void rae_ext_rae_sys_prof_thread_name(rae_String name) {
+  RaeProfThread* t = rae_prof_self();
+  if (!t) return;
+  size_t len = name.len < (int64_t)sizeof(t->name) ? (size_t)name.len : sizeof(t->name) - 1;
+  rae_prof_lock();
+  memcpy(t->name, name.data, len);
+  t->name[len] = '\0';
+  t->name_seq++;
+  rae_prof_unlock();
+}
+
+static int rae_prof_has_suffix(const char* s, const char* suffix) {
+  size_t n = strlen(s), m = strlen(suffix);
+  return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+rae_Bool rae_ext_rae_sys_prof_start(rae_String path) {
+#if RAE_PROF_THREADS
+  if (g_rae_prof.writer_running) {
+    /* Still recording, or finished at its deadline and never stopped. */
+    if (!__atomic_load_n(&g_rae_prof.finished, __ATOMIC_ACQUIRE)) return 0;
+    pthread_join(g_rae_prof.writer, NULL);
+    g_rae_prof.writer_running = 0;
+  }
+#endif
+  if (g_rae_prof.out) return 0;
+  char* cpath = (char*)malloc((size_t)path.len + 1);
+  if (!cpath) return 0;
+  memcpy(cpath, path.data, (size_t)path.len);
+  cpath[path.len] = '\0';
+  FILE* f = fopen(cpath, "wb");
+  if (!f) { free(cpath); return 0; }
+  setvbuf(f, NULL, _IOFBF, 1 << 20);
+  g_rae_prof.out = f;
+  g_rae_prof.proto = rae_prof_has_suffix(cpath, ".pftrace") || rae_prof_has_suffix(cpath, ".perfetto-trace");
+  free(cpath);
+
+  /* Registers the capturing thread first, so a fresh process makes it tid 0. */
+  RaeProfThread* self = rae_prof_self();
+  rae_prof_lock();
+  for (RaeProfThread* t = g_rae_prof.threads; t; t = t->next) {
+    __atomic_store_n(&t->tail, __atomic_load_n(&t->head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    t->dropped = 0;
+    t->announced_seq = 0;
+  }
+  memset(g_rae_prof.counter_track, 0, sizeof(g_rae_prof.counter_track));
+  rae_prof_unlock();
+
+  g_rae_prof.written = 0;
+  g_rae_prof.dropped = 0;
+  g_rae_prof.end_ns = 0;
+  __atomic_store_n(&g_rae_prof.finished, 0, __ATOMIC_RELEASE);
+  g_rae_prof.first_event = 1;
+  g_rae_prof.start_ns = rae_ext_nowNs();
+  if (g_rae_prof.proto) {
+    rae_prof_put_track(RAE_PROF_UUID_PROCESS, "rae", 0, 0);
+  } else {
+    fputs("[\n", f);
+  }
+  /* The main track is labelled even if the capture records nothing on it. */
+  if (self) {
+    rae_prof_put_thread_name(self);
+    self->announced_seq = self->name_seq;
+  }
+  __atomic_store_n(&g_rae_prof.stopping, 0, __ATOMIC_RELEASE);
+#if RAE_PROF_THREADS
+  if (pthread_create(&g_rae_prof.writer, NULL, rae_prof_writer_main, NULL) != 0) {
+    fclose(f);
+    g_rae_prof.out = NULL;
+    return 0;
+  }
+  g_rae_prof.writer_running = 1;
+#endif
+  __atomic_store_n(&rae_prof_recording, 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+/* Ends the capture: joins the writer, writes what is left and closes the
+ * file. Returns the number of events written, -1 if the file could not be
+ * written, or -2 if no capture was open. A capture the writer already
+ * finished at its deadline reports that result. */
+int64_t rae_ext_rae_sys_prof_stop(void) {
+  if (!g_rae_prof.writer_running && !g_rae_prof.out) return -2;
+  __atomic_store_n(&rae_prof_recording, 0, __ATOMIC_RELEASE);
+  __atomic_store_n(&g_rae_prof.stopping, 1, __ATOMIC_RELEASE);
+#if RAE_PROF_THREADS
+  if (g_rae_prof.writer_running) {
+    pthread_join(g_rae_prof.writer, NULL);
+    g_rae_prof.writer_running = 0;
+  }
+#endif
+  rae_prof_finish();
+  return g_rae_prof.result;
+}
+
+/* Events the last finished capture lost to full rings. */
+int64_t rae_ext_rae_sys_prof_dropped(void) {
+  return g_rae_prof.dropped;
+}
+
+/* ----- Instrumented builds -------------------------------------------- */
+
+static void rae_prof_instrument_exit(void) {
+  int64_t n = rae_ext_rae_sys_prof_stop();
+  if (n == -2) return;
+  if (n < 0) fprintf(stderr, "profile: FAILED to write the trace\n");
+  else fprintf(stderr, "profile: wrote %lld events\n", (long long)n);
+  if (g_rae_prof.dropped > 0) {
+    fprintf(stderr, "profile: WARNING %lld events dropped — a thread outran the writer\n",
+            (long long)g_rae_prof.dropped);
+  }
+  if (g_rae_prof.muted_count > 0) {
+    fprintf(stderr, "profile: muted %lld zones averaging under %lld ns:",
+            (long long)g_rae_prof.muted_count, (long long)g_rae_prof.min_zone_ns);
+    int64_t shown = g_rae_prof.muted_count < 8 ? g_rae_prof.muted_count : 8;
+    for (int64_t i = 0; i < shown; i++) fprintf(stderr, "%s %s", i ? "," : "", g_rae_prof.muted[i]);
+    fprintf(stderr, "%s\n", g_rae_prof.muted_count > shown ? ", ..." : "");
+  }
+}
+
+/* Emitted at the top of an instrumented main: the same RAE_PROFILE,
+ * RAE_PROFILE_SECONDS and RAE_PROFILE_OUT switches lib/profile.rae reads,
+ * plus RAE_PROFILE_MIN_ZONE_NS, so an instrumented binary needs no code to
+ * capture. The writer ends the
+ * capture at the deadline; exit finishes it otherwise. */
+void rae_prof_instrument_start(void) {
+  const char* flag = getenv("RAE_PROFILE");
+  if (!flag || !flag[0]) return;
+  const char* out = getenv("RAE_PROFILE_OUT");
+  if (!out || !out[0]) out = "rae_profile.json";
+  const char* secs = getenv("RAE_PROFILE_SECONDS");
+  double seconds = secs && secs[0] ? atof(secs) : 20.0;
+  const char* min_zone = getenv("RAE_PROFILE_MIN_ZONE_NS");
+  if (min_zone && min_zone[0]) g_rae_prof.min_zone_ns = atoll(min_zone);
+  if (!rae_ext_rae_sys_prof_start((rae_String){(uint8_t*)out, (int64_t)strlen(out), 0, 0})) {
+    fprintf(stderr, "profile: FAILED to open %s\n", out);
+    return;
+  }
+  if (seconds > 0) g_rae_prof.end_ns = g_rae_prof.start_ns + (int64_t)(seconds * 1e9);
+  atexit(rae_prof_instrument_exit);
+}
+
+/* Crash handler hook. Best effort and not async-signal-safe: if nothing
+ * holds the profiler lock, write out what the rings hold so the trace ends
+ * at the fault. The zones that were open stay open. */
+void rae_prof_crash_flush(void) {
+  if (!__atomic_load_n(&rae_prof_recording, __ATOMIC_ACQUIRE)) return;
+  __atomic_store_n(&rae_prof_recording, 0, __ATOMIC_RELEASE);
+#if RAE_PROF_THREADS
+  if (pthread_mutex_trylock(&g_rae_prof.mu) != 0) return;
+  pthread_mutex_unlock(&g_rae_prof.mu);
+#endif
+  rae_prof_drain();
+  if (g_rae_prof.out) fflush(g_rae_prof.out);
+}
@@ -260,7 +260,9 @@ static void rae_glfw_close_waker(GLFWwindow* w) {
   // textures, fds, and process memory regardless. Without this,
   // the app process can stay alive after the window is gone,
   // which in turn keeps the rae watch supervisor waiting and
-  // makes the devtools Stop button look broken.
+  // makes the devtools Stop button look broken. Buffered log lines
+  // are written first; that flush never waits on a lock.
+  rae_log_crash_flush();
   _exit(0);
 }
 
@@ -133,7 +133,7 @@ static void rae_spotify_cache_set_field(char** slot, const char* src, size_t len
 static rae_String rae_cstr_to_owned_rae_string(const char* s) {
     if (!s) return (rae_String){NULL, 0, 0, 0};
     size_t n = strlen(s);
-    uint8_t* buf = malloc(n + 1);
+    uint8_t* buf = rae_alloc(n + 1);
     if (!buf) return (rae_String){NULL, 0, 0, 0};
     memcpy(buf, s, n);
     buf[n] = '\0';
@@ -639,7 +639,7 @@ rae_String rae_ext_sys_spotify_itunesSearchArtworkUrl(rae_String term) {
     char* end = strchr(k, '"');
     if (!end) return (rae_String){NULL, 0, 0, 0};
     size_t len = (size_t)(end - k);
-    char* art = malloc(len + 1);
+    char* art = rae_alloc(len + 1);
     if (!art) return (rae_String){NULL, 0, 0, 0};
     memcpy(art, k, len);
     art[len] = '\0';
@@ -10,7 +10,7 @@
 rae_String rae_ext_rae_str_concat(rae_String a, rae_String b) {
   int64_t len_a = a.len;
   int64_t len_b = b.len;
-  uint8_t* result_data = malloc(len_a + len_b + 1);
+  uint8_t* result_data = rae_alloc((size_t)(len_a + len_b) + 1);
   if (result_data) {
     if (a.data) memcpy(result_data, a.data, len_a);
     if (b.data) memcpy(result_data + len_a, b.data, len_b);
@@ -71,7 +71,7 @@ rae_String rae_ext_rae_str_sub(rae_String s, int64_t start, int64_t len) {
   if (start + len > s.len) len = s.len - start;
   if (len <= 0) return (rae_String){NULL, 0, 0, 0};
 
-  uint8_t* result_data = malloc((size_t)len + 1);
+  uint8_t* result_data = rae_alloc((size_t)len + 1);
   if (result_data) {
     memcpy(result_data, s.data + start, (size_t)len);
     result_data[len] = '\0';
@@ -111,7 +111,7 @@ int64_t rae_ext_rae_str_index_of(rae_String s, rae_String sub) {
 
 rae_String rae_ext_rae_str_to_lower(rae_String s) {
   if (!s.data || s.len == 0) return (rae_String){NULL, 0, 0, 0};
-  uint8_t* out = malloc(s.len + 1);
+  uint8_t* out = rae_alloc((size_t)s.len + 1);
   if (!out) return (rae_String){NULL, 0, 0, 0};
   for (int64_t i = 0; i < s.len; i++) {
     uint8_t c = s.data[i];
@@ -156,12 +156,58 @@ uint32_t rae_ext_rae_str_at(rae_String s, int64_t index) {
   return (uint32_t)c;
 }
 
+/* toFloat/toInt keep atof/atoll semantics: skip leading whitespace, read
+ * the longest number prefix, 0 when there is none. */
+static int64_t rae_str_skip_space(rae_String s) {
+  int64_t i = 0;
+  while (i < s.len && (s.data[i] == ' ' || (s.data[i] >= '\t' && s.data[i] <= '\r'))) i++;
+  return i;
+}
+
 double rae_ext_rae_str_to_f64(rae_String s) {
   if (!s.data) return 0.0;
-  return atof((const char*)s.data);
+  int64_t start = rae_str_skip_space(s);
+  double v;
+  rae_parse_f64(s.data + start, s.len - start, &v);
+  return v;
+}
+
+float rae_ext_rae_str_to_f32(rae_String s) {
+  if (!s.data) return 0.0f;
+  int64_t start = rae_str_skip_space(s);
+  float v;
+  rae_parse_f32(s.data + start, s.len - start, &v);
+  return v;
 }
 
 int64_t rae_ext_rae_str_to_i64(rae_String s) {
   if (!s.data) return 0;
-  return (int64_t)atoll((const char*)s.data);
+  int64_t start = rae_str_skip_space(s);
+  int64_t v;
+  rae_parse_i64(s.data + start, s.len - start, &v);
+  return v;
+}
+
+/* parseFloat/parseInt: the whole string must be the number. The error
+ * position is where the scan stopped, -1 when it reached the end. */
+static void rae_str_parse_result(rae_String s, int64_t end, rae_Mod_Int64 error_at) {
+  if (error_at.ptr) *error_at.ptr = end > 0 && end == s.len ? -1 : end;
+}
+
+float rae_ext_rae_str_parse_f32(rae_String s, rae_Mod_Int64 error_at) {
+  float v = 0.0f;
+  rae_str_parse_result(s, s.data ? rae_parse_f32(s.data, s.len, &v) : 0, error_at);
+  return v;
+}
+
+double rae_ext_rae_str_parse_f64(rae_String s, rae_Mod_Int64 error_at) {
+  double v = 0.0;
+  rae_str_parse_result(s, s.data ? rae_parse_f64(s.data, s.len, &v) : 0, error_at);
+  return v;
+}
+
+int64_t rae_ext_rae_str_parse_i64(rae_String s, rae_Mod_Int64 error_at) {
+  int64_t v = 0;
+  rae_str_parse_result(s, s.data ? rae_parse_i64(s.data, s.len, &v) : 0, error_at);
+  return v;
 }
@@ -11,7 +11,7 @@
  * or "from_cstr". */
 static rae_String rae_str_from_buf_impl(const uint8_t* data, int64_t len, uint8_t site) {
   if (!data || len < 0) return (rae_String){NULL, 0, 0, 0};
-  uint8_t* buf = malloc(len + 1);
+  uint8_t* buf = rae_alloc((size_t)len + 1);
   if (buf) {
     memcpy(buf, data, len);
     buf[len] = '\0';
@@ -28,7 +28,7 @@ static rae_String rae_str_from_buf_impl(const uint8_t* data, int64_t len, uint8_
 static rae_String rae_str_from_cstr_impl(const char* s, uint8_t site) {
   if (!s) return (rae_String){NULL, 0, 0, 0};
   int64_t len = (int64_t)strlen(s);
-  uint8_t* data = malloc(len + 1);
+  uint8_t* data = rae_alloc((size_t)len + 1);
   if (data) {
     memcpy(data, s, len);
     data[len] = '\0';
@@ -62,7 +62,7 @@ void rae_ext_rae_str_free(rae_String s) {
   if (s.is_owned && s.data) {
     rae_string_pool_remove(s.data);
     rae_mem_str_untag(s.data, s.capacity > 0 ? s.capacity : s.len + 1);
-    free(s.data);
+    rae_free(s.data);
   }
 }
 
@@ -71,7 +71,7 @@ void rae_ext_rae_str_free(rae_String s) {
 // require a value copy of a String.
 rae_String rae_string_copy(rae_String src) {
   if (!src.data || src.len <= 0) return (rae_String){NULL, 0, 0, 0};
-  uint8_t* buf = malloc((size_t)src.len + 1);
+  uint8_t* buf = rae_alloc((size_t)src.len + 1);
   if (!buf) return (rae_String){NULL, 0, 0, 0};
   memcpy(buf, src.data, (size_t)src.len);
   buf[src.len] = '\0';
@@ -81,130 +81,385 @@ rae_String rae_string_copy(rae_String src) {
 
 // ---- String temp pool ----
 //
-// Statement-scope cleanup of heap allocations from compiler-emitted
-// concat/interpolation chains. See header for the contract.
+// Statement-, loop-iteration- and function-scope cleanup of heap
+// allocations from compiler-emitted concat/interpolation chains. See
+// header for the contract.
 //
-// Single-threaded today; if/when Rae grows real threading, this
-// becomes per-thread state. The C11 _Thread_local keyword exists
-// but we avoid it here to keep the runtime portable to compilers
-// that don't ship it cleanly (the Live VM target also uses this
-// file).
-#define RAE_STRING_POOL_MAX 4096
 // Thread-local: each OS thread (main + spawned workers) gets its own
-// statement-scope String temp pool. Without this, concurrent workers doing
-// string interpolation/concat race on a shared pool and corrupt each other's
-// temporaries. A returned String is pool_remove'd (detached) before return,
-// so it survives the worker's pool flush and is safe to hand to the parent.
-static __thread void* g_rae_string_pool[RAE_STRING_POOL_MAX];
-static __thread int g_rae_string_pool_count = 0;
+// pool. Without this, concurrent workers doing string interpolation/
+// concat race on a shared pool and corrupt each other's temporaries. A
+// returned String is pool_remove'd (detached) before return, so it
+// survives the worker's pool flush and is safe to hand to the parent.
+//
+// A pool is a stack of slots in registration order (a mark is a stack
+// depth) plus an open-addressing index from pointer to slot, so
+// register, remove and contains are O(1) however deep the pool is.
+// Remove leaves a NULL hole and pops holes off the top; flush frees
+// every slot above the mark. Both arrays grow on demand, so a
+// registration is never dropped. The arrays come from malloc, not
+// rae_alloc: they are bookkeeping, not program strings.
+typedef struct {
+  void* ptr;      /* NULL: empty */
+  int32_t slot;
+} RaePoolIndexEntry;
+
+typedef struct {
+  void** slots;
+  int32_t count, cap;
+  RaePoolIndexEntry* index;  /* power-of-two table, at most half full */
+  uint32_t index_mask;       /* capacity - 1; 0 until first register */
+  int32_t index_used;
+  int32_t* marks;            /* counts at the open marks, innermost last */
+  int32_t mark_count, mark_cap;
+} RaeStringPool;
+
+static __thread RaeStringPool g_rae_string_pool;
+static pthread_key_t g_rae_string_pool_key;
+static pthread_once_t g_rae_string_pool_once = PTHREAD_ONCE_INIT;
+
+/* Thread exit: release the pool's own arrays. Strings still in it were
+ * left by a scope that never flushed and leak, as they always have. */
+static void rae_string_pool_thread_exit(void* arg) {
+  RaeStringPool* p = (RaeStringPool*)arg;
+  free(p->slots);
+  free(p->index);
+  free(p->marks);
+  memset(p, 0, sizeof(*p));
+}
+
+static void rae_string_pool_key_init(void) {
+  pthread_key_create(&g_rae_string_pool_key, rae_string_pool_thread_exit);
+}
+
+static inline uint32_t rae_string_pool_hash(const void* ptr) {
+  /* Blocks are 16-byte aligned; drop those bits, then Fibonacci-hash. */
+  return (uint32_t)((((uint64_t)(uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+/* Index position of ptr, or -1. */
+static inline int64_t rae_string_pool_find(const RaeStringPool* p, const void* ptr) {
+  if (!p->index_mask) return -1;
+  uint32_t i = rae_string_pool_hash(ptr) & p->index_mask;
+  while (p->index[i].ptr) {
+    if (p->index[i].ptr == ptr) return i;
+    i = (i + 1) & p->index_mask;
+  }
+  return -1;
+}
+
+static inline void rae_string_pool_index_put(RaeStringPool* p, void* ptr, int32_t slot) {
+  uint32_t i = rae_string_pool_hash(ptr) & p->index_mask;
+  while (p->index[i].ptr) i = (i + 1) & p->index_mask;
+  p->index[i].ptr = ptr;
+  p->index[i].slot = slot;
+  p->index_used++;
+}
+
+/* Backward-shift deletion: later entries of the probe run move into the
+ * hole, so lookups never need tombstones. */
+static void rae_string_pool_unindex(RaeStringPool* p, uint32_t i) {
+  uint32_t mask = p->index_mask;
+  for (uint32_t j = (i + 1) & mask; p->index[j].ptr; j = (j + 1) & mask) {
+    uint32_t home = rae_string_pool_hash(p->index[j].ptr) & mask;
+    if (((j - home) & mask) >= ((j - i) & mask)) {
+      p->index[i] = p->index[j];
+      i = j;
+    }
+  }
+  p->index[i].ptr = NULL;
+  p->index_used--;
+}
+
+/* Room for one more registration; 0 if out of memory. */
+static int rae_string_pool_reserve(RaeStringPool* p) {
+  if (!p->slots) {
+    pthread_once(&g_rae_string_pool_once, rae_string_pool_key_init);
+    pthread_setspecific(g_rae_string_pool_key, p);
+  }
+  if (p->count == p->cap) {
+    int32_t cap = p->cap ? p->cap * 2 : 64;
+    void** slots = (void**)realloc(p->slots, (size_t)cap * sizeof(void*));
+    if (!slots) return 0;
+    p->slots = slots;
+    p->cap = cap;
+  }
+  if ((int64_t)(p->index_used + 1) * 2 > (int64_t)p->index_mask + 1) {
+    uint32_t cap = p->index_mask ? (p->index_mask + 1) * 2 : 128;
+    RaePoolIndexEntry* old = p->index;
+    uint32_t old_cap = p->index_mask ? p->index_mask + 1 : 0;
+    RaePoolIndexEntry* index = (RaePoolIndexEntry*)calloc(cap, sizeof(RaePoolIndexEntry));
+    if (!index) return 0;
+    p->index = index;
+    p->index_mask = cap - 1;
+    p->index_used = 0;
+    for (uint32_t i = 0; i < old_cap; i++) {
+      if (old[i].ptr) rae_string_pool_index_put(p, old[i].ptr, old[i].slot);
+    }
+    free(old);
+  }
+  return 1;
+}
 
 void rae_string_pool_register(void* ptr) {
   if (!ptr) return;
-  if (g_rae_string_pool_count >= RAE_STRING_POOL_MAX) return;
+  RaeStringPool* p = &g_rae_string_pool;
+  if (!rae_string_pool_reserve(p)) return;
   g_mem_pool_register_n++;
-  g_rae_string_pool[g_rae_string_pool_count++] = ptr;
+  int64_t at = rae_string_pool_find(p, ptr);
+  if (at >= 0) {
+    // Already present: the block was freed behind the pool's back and
+    // handed out again. The old slot is stale; drop it rather than
+    // free the new owner's block twice.
+    p->slots[p->index[at].slot] = NULL;
+    p->index[at].slot = p->count;
+  } else {
+    rae_string_pool_index_put(p, ptr, p->count);
+  }
+  p->slots[p->count++] = ptr;
 }
 
 int rae_string_pool_mark(void) {
-  return g_rae_string_pool_count;
+  RaeStringPool* p = &g_rae_string_pool;
+  if (p->mark_count == p->mark_cap) {
+    int32_t cap = p->mark_cap ? p->mark_cap * 2 : 32;
+    int32_t* marks = (int32_t*)realloc(p->marks, (size_t)cap * sizeof(int32_t));
+    if (!marks) return p->count;
+    p->marks = marks;
+    p->mark_cap = cap;
+  }
+  p->marks[p->mark_count++] = p->count;
+  return p->count;
 }
 
 void rae_string_pool_flush(int saved) {
+  RaeStringPool* p = &g_rae_string_pool;
   if (saved < 0) saved = 0;
-  if (saved > g_rae_string_pool_count) return;  // nothing to flush
+  // Close this scope's mark and any inner ones an early exit skipped.
+  // Nested scopes can share a count, so only one equal mark goes.
+  while (p->mark_count > 0 && p->marks[p->mark_count - 1] > saved) p->mark_count--;
+  if (p->mark_count > 0 && p->marks[p->mark_count - 1] == saved) p->mark_count--;
+  if (saved > p->count) return;  // nothing to flush
   g_mem_pool_flush_calls++;
-  for (int i = g_rae_string_pool_count - 1; i >= saved; i--) {
-    if (g_rae_string_pool[i]) {
-      /* The pool only knows the ptr; the hash lookup recovers the
-       * site and rae_malloc_size_safe gives us the byte count. */
-      rae_mem_str_untag(g_rae_string_pool[i], 0);
-      g_mem_pool_flush_freed++;
-      free(g_rae_string_pool[i]);
-    }
-    g_rae_string_pool[i] = NULL;
+  for (int32_t i = p->count - 1; i >= saved; i--) {
+    void* ptr = p->slots[i];
+    if (!ptr) continue;
+    rae_string_pool_unindex(p, (uint32_t)rae_string_pool_find(p, ptr));
+    /* The pool only knows the ptr; the site lookup recovers the
+     * site and rae_alloc_size gives us the byte count. */
+    rae_mem_str_untag(ptr, 0);
+    g_mem_pool_flush_freed++;
+    rae_free(ptr);
   }
-  g_rae_string_pool_count = saved;
+  p->count = saved;
 }
 
 void rae_string_pool_remove(void* ptr) {
   if (!ptr) return;
   g_mem_pool_remove_n++;
-  // Linear scan from the top — the entry we want to detach is
-  // almost always the most recently registered one (a binding
-  // taking the result of the just-emitted interpolation).
-  for (int i = g_rae_string_pool_count - 1; i >= 0; i--) {
-    if (g_rae_string_pool[i] == ptr) {
-      // Compact: swap with last, drop count by 1.
-      g_rae_string_pool[i] = g_rae_string_pool[g_rae_string_pool_count - 1];
-      g_rae_string_pool_count--;
-      return;
-    }
-  }
+  RaeStringPool* p = &g_rae_string_pool;
+  int64_t at = rae_string_pool_find(p, ptr);
+  if (at < 0) return;
+  p->slots[p->index[at].slot] = NULL;
+  rae_string_pool_unindex(p, (uint32_t)at);
+  // The detached entry is almost always the most recent one (a binding
+  // taking the result of the just-emitted interpolation), so this keeps
+  // the stack as deep as its live temporaries. Holes below the innermost
+  // open mark stay: that scope's flush must still see its own entries.
+  int32_t floor = p->mark_count > 0 ? p->marks[p->mark_count - 1] : 0;
+  while (p->count > floor && !p->slots[p->count - 1]) p->count--;
 }
 
-// Returns 1 if ptr is currently in the statement-scope String temp
-// pool, 0 otherwise. Used by rae_string_move_or_copy to decide
-// whether a Phase 2 struct-field init can MOVE the source heap or
-// must COPY it. A source whose heap is NOT in the pool was either
-// pool_take'd by the caller (owning-temp arg detached) or is a
-// borrowed/literal-backed value — either way, moving is safe and
-// avoids one allocation. A source in the pool will be flushed by
-// the caller's surrounding pool_flush, so the callee must deep-
-// copy to give its struct field a private heap.
+// Returns 1 if ptr is currently in the String temp pool, 0 otherwise.
+// Used by rae_string_move_or_copy to decide whether a Phase 2
+// struct-field init can MOVE the source heap or must COPY it. A source
+// whose heap is NOT in the pool was either pool_take'd by the caller
+// (owning-temp arg detached) or is a borrowed/literal-backed value —
+// either way, moving is safe and avoids one allocation. A source in the
+// pool will be flushed by the caller's surrounding pool_flush, so the
+// callee must deep-copy to give its struct field a private heap.
 int rae_string_pool_contains(void* ptr) {
   if (!ptr) return 0;
-  for (int i = g_rae_string_pool_count - 1; i >= 0; i--) {
-    if (g_rae_string_pool[i] == ptr) return 1;
-  }
-  return 0;
+  return rae_string_pool_find(&g_rae_string_pool, ptr) >= 0;
 }
 
 rae_String rae_ext_rae_str_interp(int n, ...) {
   if (n <= 0) return (rae_String){NULL, 0, 0, 0};
-  va_list args;
-  // Collect parts.
-  enum { MAX_PARTS = 64 };
-  if (n > MAX_PARTS) n = MAX_PARTS;
-  rae_String parts[MAX_PARTS];
-  int64_t total = 0;
+  // Two passes over the arguments (size, then copy and free), so any
+  // number of parts fits without a parts array.
+  va_list args, copy_args;
   va_start(args, n);
-  for (int i = 0; i < n; i++) {
-    parts[i] = va_arg(args, rae_String);
-    total += parts[i].len;
-  }
+  va_copy(copy_args, args);
+  int64_t total = 0;
+  for (int i = 0; i < n; i++) total += va_arg(args, rae_String).len;
   va_end(args);
 
-  uint8_t* buf = (total > 0) ? malloc((size_t)total + 1) : NULL;
-  if (buf) {
-    int64_t pos = 0;
-    for (int i = 0; i < n; i++) {
-      if (parts[i].data && parts[i].len > 0) {
-        memcpy(buf + pos, parts[i].data, (size_t)parts[i].len);
-        pos += parts[i].len;
-      }
+  uint8_t* buf = (total > 0) ? rae_alloc((size_t)total + 1) : NULL;
+  int64_t pos = 0;
+  for (int i = 0; i < n; i++) {
+    rae_String part = va_arg(copy_args, rae_String);
+    if (buf && part.data && part.len > 0) {
+      memcpy(buf + pos, part.data, (size_t)part.len);
+      pos += part.len;
     }
+    // Free any owned input — these are compiler-generated temporaries
+    // (e.g. rae_ext_rae_str_i64 results). Borrowed inputs (literals,
+    // rae_string_borrow-wrapped identifiers) are is_owned=0 and a
+    // no-op here. The pool_remove keeps the temp-pool in sync so a
+    // later flush doesn't double-free a heap we already returned to
+    // the allocator.
+    if (part.is_owned && part.data) {
+      rae_string_pool_remove(part.data);
+      rae_mem_str_untag(part.data, part.capacity > 0 ? part.capacity : part.len + 1);
+      rae_free(part.data);
+    }
+  }
+  va_end(copy_args);
+  if (buf) {
     buf[total] = '\0';
     rae_mem_str_tag(buf, total + 1, RAE_SITE_INTERP);
   }
 
-  // Free any owned input — these are compiler-generated temporaries
-  // (e.g. rae_ext_rae_str_i64 results). Borrowed inputs (literals,
-  // rae_string_borrow-wrapped identifiers) are is_owned=0 and a
-  // no-op here. The pool_remove keeps the temp-pool in sync so a
-  // later flush doesn't double-free a heap we already returned to
-  // the allocator.
-  for (int i = 0; i < n; i++) {
-    if (parts[i].is_owned && parts[i].data) {
-      rae_string_pool_remove(parts[i].data);
-      rae_mem_str_untag(parts[i].data, parts[i].capacity > 0 ? parts[i].capacity : parts[i].len + 1);
-      free(parts[i].data);
-    }
-  }
-
   rae_String result = {buf, total, total + 1, 1};
   rae_string_pool_register(buf);
   return result;
 }
 
+/* ----- Single-pass interpolation (RaeFmt, see rae_runtime.h) ----- */
+
+/* Decimal text of v into out (at least 20 bytes); returns the length.
+ * Two digits per step from a pair table, written back to front. */
+static int rae_format_i64(char* out, int64_t v) {
+  static const char pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+  char tmp[20];
+  char* p = tmp + sizeof tmp;
+  uint64_t u = v < 0 ? (uint64_t)0 - (uint64_t)v : (uint64_t)v;
+  while (u >= 100) {
+    unsigned d = (unsigned)(u % 100) * 2;
+    u /= 100;
+    *--p = pairs[d + 1];
+    *--p = pairs[d];
+  }
+  if (u >= 10) {
+    *--p = pairs[u * 2 + 1];
+    *--p = pairs[u * 2];
+  } else {
+    *--p = (char)('0' + u);
+  }
+  int len = 0;
+  if (v < 0) out[len++] = '-';
+  int digits = (int)(tmp + sizeof tmp - p);
+  memcpy(out + len, p, (size_t)digits);
+  return len + digits;
+}
+
+/* UTF-8 encoding of code point v into out (4 bytes); returns the length. */
+static int rae_format_char(uint8_t* out, uint32_t v) {
+  if (v < 0x80) {
+    out[0] = (uint8_t)v;
+    return 1;
+  }
+  if (v < 0x800) {
+    out[0] = (uint8_t)(0xC0 | (v >> 6));
+    out[1] = (uint8_t)(0x80 | (v & 0x3F));
+    return 2;
+  }
+  if (v < 0x10000) {
+    out[0] = (uint8_t)(0xE0 | (v >> 12));
+    out[1] = (uint8_t)(0x80 | ((v >> 6) & 0x3F));
+    out[2] = (uint8_t)(0x80 | (v & 0x3F));
+    return 3;
+  }
+  out[0] = (uint8_t)(0xF0 | (v >> 18));
+  out[1] = (uint8_t)(0x80 | ((v >> 12) & 0x3F));
+  out[2] = (uint8_t)(0x80 | ((v >> 6) & 0x3F));
+  out[3] = (uint8_t)(0x80 | (v & 0x3F));
+  return 4;
+}
+
+/* Out of the stack buffer: double into a heap buffer. The heap copy
+ * becomes the result's own storage in rae_fmt_finish. */
+void rae_fmt_grow(RaeFmt* f, int64_t extra) {
+  int64_t cap = f->cap * 2;
+  if (cap < f->len + extra) cap = f->len + extra;
+  uint8_t* nb;
+  if (f->buf == f->inline_buf) {
+    nb = rae_alloc((size_t)cap + 1);
+    if (nb) memcpy(nb, f->buf, (size_t)f->len);
+  } else {
+    nb = rae_realloc(f->buf, (size_t)cap + 1);
+  }
+  if (!nb) {
+    fprintf(stderr, "rae: out of memory formatting a %lld-byte string\n", (long long)(f->len + extra));
+    abort();
+  }
+  f->buf = nb;
+  f->cap = cap;
+}
+
+void rae_fmt_i64(RaeFmt* f, int64_t v) {
+  f->len += rae_format_i64((char*)rae_fmt_reserve(f, 20), v);
+}
+
+void rae_fmt_f64(RaeFmt* f, double v) {
+  f->len += rae_format_f64((char*)rae_fmt_reserve(f, RAE_FLOAT_TEXT_MAX), v);
+}
+
+void rae_fmt_f32(RaeFmt* f, float v) {
+  f->len += rae_format_f32((char*)rae_fmt_reserve(f, RAE_FLOAT_TEXT_MAX), v);
+}
+
+void rae_fmt_bool(RaeFmt* f, rae_Bool v) {
+  rae_fmt_str(f, v ? (rae_String){(uint8_t*)"true", 4, 0, 0} : (rae_String){(uint8_t*)"false", 5, 0, 0});
+}
+
+void rae_fmt_char(RaeFmt* f, uint32_t v) {
+  f->len += rae_format_char(rae_fmt_reserve(f, 4), v);
+}
+
+void rae_fmt_any(RaeFmt* f, RaeAny v) {
+  switch (v.type) {
+    case RAE_TYPE_INT64:
+    case RAE_TYPE_INT32:
+    case RAE_TYPE_UINT64:  rae_fmt_i64(f, v.as.i); break;
+    case RAE_TYPE_FLOAT64: rae_fmt_f64(f, v.as.f); break;
+    case RAE_TYPE_FLOAT32: rae_fmt_f32(f, (float)v.as.f); break;
+    case RAE_TYPE_BOOL:    rae_fmt_bool(f, v.as.b); break;
+    case RAE_TYPE_STRING:  rae_fmt_str(f, v.as.s); break;
+    case RAE_TYPE_CHAR:    rae_fmt_char(f, (uint32_t)v.as.i); break;
+    case RAE_TYPE_NONE:    rae_fmt_str(f, (rae_String){(uint8_t*)"none", 4, 0, 0}); break;
+    default: break;
+  }
+}
+
+/* Append, then release s if it owns its storage (the str_interp contract
+ * for owned parts). */
+void rae_fmt_str_owned(RaeFmt* f, rae_String s) {
+  rae_fmt_str(f, s);
+  rae_ext_rae_str_free(s);
+}
+
+rae_String rae_fmt_finish(RaeFmt* f) {
+  int64_t len = f->len;
+  uint8_t* buf = f->buf;
+  int64_t cap = f->cap + 1;
+  /* The stack buffer always needs a heap copy; a spilled buffer keeps its
+   * storage unless doubling left more than a quarter of it unused. */
+  if (buf == f->inline_buf || cap > len + 1 + (len + 1) / 4) {
+    if (len == 0) return (rae_String){NULL, 0, 0, 0};
+    buf = rae_alloc((size_t)len + 1);
+    if (!buf) return (rae_String){NULL, 0, 0, 0};
+    memcpy(buf, f->buf, (size_t)len);
+    if (f->buf != f->inline_buf) rae_free(f->buf);
+    cap = len + 1;
+  }
+  buf[len] = '\0';
+  rae_mem_str_tag(buf, cap, RAE_SITE_INTERP);
+  rae_string_pool_register(buf);
+  return (rae_String){buf, len, cap, 1};
+}
+
 static int64_t g_tick_counter = 0;
 
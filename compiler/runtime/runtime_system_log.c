@@ -41,7 +41,7 @@ rae_String rae_ext_time_formatTimestamp(int64_t epoch_ms) {
   char buf[32];
   int n = (int)strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", tm_p);
   if (n <= 0) return (rae_String){NULL, 0, 0, 0};
-  uint8_t* data = malloc((size_t)n + 1);
+  uint8_t* data = rae_alloc((size_t)n + 1);
   if (!data) return (rae_String){NULL, 0, 0, 0};
   memcpy(data, buf, (size_t)n);
   data[n] = '\0';
@@ -57,7 +57,7 @@ rae_String rae_ext_time_formatDate(int64_t epoch_ms) {
   char buf[16];
   int n = (int)strftime(buf, sizeof(buf), "%Y-%m-%d", tm_p);
   if (n <= 0) return (rae_String){NULL, 0, 0, 0};
-  uint8_t* data = malloc((size_t)n + 1);
+  uint8_t* data = rae_alloc((size_t)n + 1);
   if (!data) return (rae_String){NULL, 0, 0, 0};
   memcpy(data, buf, (size_t)n);
   data[n] = '\0';
@@ -101,7 +101,7 @@ RaeAny rae_ext_json_get(const char* json, const char* field) {
         const char* val_end = strchr(val_start, '\"');
         if (!val_end) return rae_any_none();
         size_t len = val_end - val_start;
-        uint8_t* res = malloc(len + 1);
+        uint8_t* res = rae_alloc(len + 1);
         memcpy(res, val_start, len);
         res[len] = '\0';
         rae_mem_str_tag(res, (int64_t)len + 1, RAE_SITE_JSON_GET_STR);
@@ -131,7 +131,7 @@ RaeAny rae_ext_json_get(const char* json, const char* field) {
             p++;
         }
         size_t len = p - val_start;
-        uint8_t* res = malloc(len + 1);
+        uint8_t* res = rae_alloc(len + 1);
         memcpy(res, val_start, len);
         res[len] = '\0';
         rae_mem_str_tag(res, (int64_t)len + 1, RAE_SITE_JSON_GET_OBJ);
@@ -141,21 +141,40 @@ RaeAny rae_ext_json_get(const char* json, const char* field) {
     return rae_any_none();
 }
 
+/* Logging formats into the calling thread's open line; the sink
+ * (runtime_log_sink.c) decides when it reaches stdout. */
+static void rae_log_stream_value(RaeAny value);
+static void rae_log_stream_list_fields(RaeAny* items, int64_t length, int64_t capacity);
+
 void rae_ext_rae_log_any(RaeAny value) {
-  if (value.is_view) printf("view ");
-  else if (value.is_mod) printf("mod ");
-  rae_ext_rae_log_stream_any(value);
-  printf("\n");
-  rae_flush_stdout();
+  if (value.is_view) rae_log_puts("view ");
+  else if (value.is_mod) rae_log_puts("mod ");
+  rae_log_stream_value(value);
+  rae_log_end_line();
+}
+
+/* `[warn] text`, or nothing below the RAE_LOG_LEVEL threshold
+ * (lib/logging.rae). */
+void rae_ext_rae_log_at(int64_t level, rae_String text) {
+  static const char* prefixes[] = {"[debug] ", "[info] ", "[warn] ", "[error] "};
+  if (level < rae_ext_rae_log_level() || level < 0 || level >= RAE_LOG_LEVEL_OFF) return;
+  rae_log_puts(prefixes[level]);
+  if (text.data) rae_log_put(text.data, (size_t)text.len);
+  rae_log_end_line();
 }
 
 void rae_ext_rae_log_stream_any(RaeAny value) {
+  rae_log_stream_value(value);
+  rae_log_end_fragment();
+}
+
+static void rae_log_stream_value(RaeAny value) {
   if (value.type == RAE_TYPE_ANY) {
       // If it's a reference to an Any, dereference and recurse
       RaeAny inner = *(RaeAny*)value.as.ptr;
       if (value.is_view) inner.is_view = true;
       if (value.is_mod) inner.is_mod = true;
-      rae_ext_rae_log_stream_any(inner);
+      rae_log_stream_value(inner);
       return;
   }
 
@@ -164,205 +183,210 @@ void rae_ext_rae_log_stream_any(RaeAny value) {
   switch (value.type) {
     case RAE_TYPE_INT64: {
         int64_t v = is_ref ? *(int64_t*)value.as.ptr : value.as.i;
-        printf("%lld", (long long)v); 
+        rae_log_put_i64(v);
         break;
     }
     case RAE_TYPE_INT32: {
         int32_t v = is_ref ? *(int32_t*)value.as.ptr : (int32_t)value.as.i;
-        printf("%d", v); 
+        rae_log_put_i64(v);
         break;
     }
     case RAE_TYPE_UINT64: {
         uint64_t v = is_ref ? *(uint64_t*)value.as.ptr : (uint64_t)value.as.i;
-        printf("%llu", (unsigned long long)v); 
+        rae_log_put_u64(v);
         break;
     }
     case RAE_TYPE_FLOAT64: {
         double v = is_ref ? *(double*)value.as.ptr : value.as.f;
-        printf("%g", v); 
+        rae_log_put_f64(v);
         break;
     }
     case RAE_TYPE_FLOAT32: {
         float v = is_ref ? *(float*)value.as.ptr : (float)value.as.f;
-        printf("%g", (double)v); 
+        rae_log_put_f32(v);
         break;
     }
     case RAE_TYPE_BOOL: {
         int8_t v = is_ref ? *(int8_t*)value.as.ptr : value.as.b;
-        printf("%s", v ? "true" : "false"); 
+        rae_log_puts(v ? "true" : "false");
         break;
     }
     case RAE_TYPE_STRING: {
         rae_String v = is_ref ? *(rae_String*)value.as.ptr : value.as.s;
-        if (v.data) fwrite(v.data, 1, v.len, stdout);
-        else printf("(null)"); 
+        if (v.data) rae_log_put(v.data, (size_t)v.len);
+        else rae_log_puts("(null)");
         break;
     }
     case RAE_TYPE_CHAR: {
         uint32_t v = is_ref ? *(uint32_t*)value.as.ptr : (uint32_t)value.as.i;
-        rae_ext_rae_log_stream_char(v); 
+        rae_log_put_char(v);
+        break;
+    }
+    case RAE_TYPE_ID: {
+        rae_log_puts("Id(");
+        rae_log_put_i64(value.as.i);
+        rae_log_puts(")");
         break;
     }
-    case RAE_TYPE_ID: printf("Id(%lld)", (long long)value.as.i); break;
     case RAE_TYPE_KEY: {
         rae_String v = is_ref ? *(rae_String*)value.as.ptr : value.as.s;
-        printf("Key(\"");
-        if (v.data) fwrite(v.data, 1, v.len, stdout);
-        printf("\")");
+        rae_log_puts("Key(\"");
+        if (v.data) rae_log_put(v.data, (size_t)v.len);
+        rae_log_puts("\")");
         break;
     }
     case RAE_TYPE_UINT32: {
         uint32_t v = is_ref ? *(uint32_t*)value.as.ptr : (uint32_t)value.as.i;
-        printf("%u", v); 
+        rae_log_put_i64(v);
         break;
     }
-    case RAE_TYPE_LIST: printf("[...]"); break;
-    case RAE_TYPE_BUFFER: printf("%p", value.as.ptr); break;
-    case RAE_TYPE_NONE: printf("none"); break;
-    case RAE_TYPE_ANY: printf("Any(...)"); break;
+    case RAE_TYPE_LIST: rae_log_puts("[...]"); break;
+    case RAE_TYPE_BUFFER: {
+        char buffer[32];
+        rae_log_put(buffer, (size_t)snprintf(buffer, sizeof(buffer), "%p", value.as.ptr));
+        break;
+    }
+    case RAE_TYPE_NONE: rae_log_puts("none"); break;
+    case RAE_TYPE_ANY: rae_log_puts("Any(...)"); break;
   }
 }
 
 void rae_ext_rae_log_list_fields(RaeAny* items, int64_t length, int64_t capacity) {
-  rae_ext_rae_log_stream_list_fields(items, length, capacity);
-  printf("\n");
-  fflush(stdout);
+  rae_log_stream_list_fields(items, length, capacity);
+  rae_log_end_line();
 }
 
 void rae_ext_rae_log_stream_list_fields(RaeAny* items, int64_t length, int64_t capacity) {
-  printf("{ #(");
+  rae_log_stream_list_fields(items, length, capacity);
+  rae_log_end_fragment();
+}
+
+static void rae_log_stream_list_fields(RaeAny* items, int64_t length, int64_t capacity) {
+  rae_log_puts("{ #(");
   for (int64_t i = 0; i < capacity; i++) {
-    if (i > 0) printf(", ");
+    if (i > 0) rae_log_puts(", ");
     if (i < length) {
-      rae_ext_rae_log_stream_any(items[i]);
+      rae_log_stream_value(items[i]);
     } else {
-      printf("none");
+      rae_log_puts("none");
     }
   }
-  printf("), %lld, %lld }", (long long)length, (long long)capacity);
+  rae_log_puts("), ");
+  rae_log_put_i64(length);
+  rae_log_puts(", ");
+  rae_log_put_i64(capacity);
+  rae_log_puts(" }");
 }
 
-void rae_ext_rae_log_stream_list_typed(void* data, int64_t length, int64_t capacity, int elem_kind) {
-  printf("{ #(");
+static void rae_log_stream_list_typed(void* data, int64_t length, int64_t capacity, int elem_kind) {
+  rae_log_puts("{ #(");
   for (int64_t i = 0; i < capacity; i++) {
-    if (i > 0) printf(", ");
-    if (i >= length) { printf("none"); continue; }
+    if (i > 0) rae_log_puts(", ");
+    if (i >= length) { rae_log_puts("none"); continue; }
     switch (elem_kind) {
-      case RAE_LIST_ELEM_ANY:    rae_ext_rae_log_stream_any(((RaeAny*)data)[i]); break;
-      case RAE_LIST_ELEM_INT64:  printf("%lld", (long long)((int64_t*)data)[i]); break;
-      case RAE_LIST_ELEM_FLOAT64:printf("%g", ((double*)data)[i]); break;
-      case RAE_LIST_ELEM_BOOL:   printf("%s", ((bool*)data)[i] ? "true" : "false"); break;
-      case RAE_LIST_ELEM_CHAR32: {
-        uint32_t cp = ((uint32_t*)data)[i];
-        // Encode as UTF-8 for printable codepoints, else fall back to U+XXXX.
-        if (cp < 0x80) { putchar((int)cp); }
-        else if (cp < 0x800) { putchar(0xC0 | (cp >> 6)); putchar(0x80 | (cp & 0x3F)); }
-        else if (cp < 0x10000) { putchar(0xE0 | (cp >> 12)); putchar(0x80 | ((cp >> 6) & 0x3F)); putchar(0x80 | (cp & 0x3F)); }
-        else { putchar(0xF0 | (cp >> 18)); putchar(0x80 | ((cp >> 12) & 0x3F)); putchar(0x80 | ((cp >> 6) & 0x3F)); putchar(0x80 | (cp & 0x3F)); }
-        break;
-      }
+      case RAE_LIST_ELEM_ANY:    rae_log_stream_value(((RaeAny*)data)[i]); break;
+      case RAE_LIST_ELEM_INT64:  rae_log_put_i64(((int64_t*)data)[i]); break;
+      case RAE_LIST_ELEM_FLOAT64:rae_log_put_f64(((double*)data)[i]); break;
+      case RAE_LIST_ELEM_BOOL:   rae_log_puts(((bool*)data)[i] ? "true" : "false"); break;
+      case RAE_LIST_ELEM_CHAR32: rae_log_put_char(((uint32_t*)data)[i]); break;
       case RAE_LIST_ELEM_STRING: {
         rae_String s = ((rae_String*)data)[i];
-        printf("\"%.*s\"", (int)s.len, (const char*)s.data);
+        rae_log_puts("\"");
+        if (s.data) rae_log_put(s.data, (size_t)s.len);
+        rae_log_puts("\"");
         break;
       }
-      default: printf("?"); break;
+      default: rae_log_puts("?"); break;
     }
   }
-  printf("), %lld, %lld }", (long long)length, (long long)capacity);
+  rae_log_puts("), ");
+  rae_log_put_i64(length);
+  rae_log_puts(", ");
+  rae_log_put_i64(capacity);
+  rae_log_puts(" }");
+}
+
+void rae_ext_rae_log_stream_list_typed(void* data, int64_t length, int64_t capacity, int elem_kind) {
+  rae_log_stream_list_typed(data, length, capacity, elem_kind);
+  rae_log_end_fragment();
 }
 
 void rae_ext_rae_log_list_typed(void* data, int64_t length, int64_t capacity, int elem_kind) {
-  rae_ext_rae_log_stream_list_typed(data, length, capacity, elem_kind);
-  printf("\n");
-  fflush(stdout);
+  rae_log_stream_list_typed(data, length, capacity, elem_kind);
+  rae_log_end_line();
 }
 
 void rae_ext_rae_log_cstr(const char* text) {
-  if (!text) {
-    fputs("(null)\n", stdout);
-    rae_flush_stdout();
-    return;
-  }
-  fputs(text, stdout);
-  fputc('\n', stdout);
-  rae_flush_stdout();
+  rae_log_puts(text ? text : "(null)");
+  rae_log_end_line();
 }
 
 void rae_ext_rae_log_stream_cstr(const char* text) {
   if (!text) {
     return;
   }
-  fputs(text, stdout);
-  rae_flush_stdout();
+  rae_log_puts(text);
+  rae_log_end_fragment();
 }
 
 void rae_ext_rae_log_string(rae_String value) {
-  rae_ext_rae_log_stream_string(value);
-  printf("\n");
-  rae_flush_stdout();
+  if (value.data) rae_log_put(value.data, (size_t)value.len);
+  rae_log_end_line();
 }
 
 void rae_ext_rae_log_stream_string(rae_String value) {
-  if (value.data) {
-    fwrite(value.data, 1, value.len, stdout);
-  }
-  rae_flush_stdout();
+  if (value.data) rae_log_put(value.data, (size_t)value.len);
+  rae_log_end_fragment();
 }
 
 void rae_ext_rae_log_i64(int64_t value) {
-  printf("%lld\n", (long long)value);
-  rae_flush_stdout();
+  rae_log_put_i64(value);
+  rae_log_end_line();
 }
 
 void rae_ext_rae_log_stream_i64(int64_t value) {
-  printf("%lld", (long long)value);
-  rae_flush_stdout();
+  rae_log_put_i64(value);
+  rae_log_end_fragment();
+}
+
+void rae_ext_rae_log_stream_f64(double value) {
+  rae_log_put_f64(value);
+  rae_log_end_fragment();
 }
 
 void rae_ext_rae_log_bool(int8_t value) {
-  printf("%s\n", value ? "true" : "false");
-  rae_flush_stdout();
+  rae_log_puts(value ? "true" : "false");
+  rae_log_end_line();
 }
 
 void rae_ext_rae_log_stream_bool(int8_t value) {
-  printf("%s", value ? "true" : "false");
-  rae_flush_stdout();
+  rae_log_puts(value ? "true" : "false");
+  rae_log_end_fragment();
 }
 
 void rae_ext_rae_log_char(uint32_t value) {
-  rae_ext_rae_log_stream_char(value);
-  printf("\n");
-  rae_flush_stdout();
+  rae_log_put_char(value);
+  rae_log_end_line();
 }
 
 void rae_ext_rae_log_stream_char(uint32_t value) {
-  if (value < 0x80) {
-    printf("%c", (char)value);
-  } else if (value < 0x800) {
-    printf("%c%c", (char)(0xC0 | (value >> 6)), (char)(0x80 | (value & 0x3F)));
-  } else if (value < 0x10000) {
-    printf("%c%c%c", (char)(0xE0 | (value >> 12)), (char)(0x80 | ((value >> 6) & 0x3F)), (char)(0x80 | (value & 0x3F)));
-  } else {
-    printf("%c%c%c%c", (char)(0xF0 | (value >> 18)), (char)(0x80 | ((value >> 12) & 0x3F)), (char)(0x80 | ((value >> 6) & 0x3F)), (char)(0x80 | (value & 0x3F)));
-  }
-  rae_flush_stdout();
+  rae_log_put_char(value);
+  rae_log_end_fragment();
 }
 
 void rae_ext_rae_log_id(int64_t value) {
-  printf("%lld\n", (long long)value);
-  rae_flush_stdout();
+  rae_log_put_i64(value);
+  rae_log_end_line();
 }
 
 void rae_ext_rae_log_stream_id(int64_t value) {
-  printf("%lld", (long long)value);
-  rae_flush_stdout();
+  rae_log_put_i64(value);
+  rae_log_end_fragment();
 }
 
 void rae_ext_rae_log_key(rae_String value) {
-  rae_ext_rae_log_stream_string(value);
-  printf("\n");
-  rae_flush_stdout();
+  if (value.data) rae_log_put(value.data, (size_t)value.len);
+  rae_log_end_line();
 }
 
 void rae_ext_rae_log_stream_key(rae_String value) {
@@ -370,12 +394,11 @@ void rae_ext_rae_log_stream_key(rae_String value) {
 }
 
 void rae_ext_rae_log_float(float value){
-  printf("%g\n", value);
-  rae_flush_stdout();
+  rae_log_put_f32(value);
+  rae_log_end_line();
 }
 
 void rae_ext_rae_log_stream_float(float value){
-  printf("%g", value);
-  rae_flush_stdout();
+  rae_log_put_f32(value);
+  rae_log_end_fragment();
 }
-
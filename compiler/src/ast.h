@@ -559,6 +559,17 @@ typedef struct CompilerContext {
 
     // Sema: expected type for return-type generic inference
     const AstTypeRef* sema_expected_type;
+
+    // `rae build --instrument` (c_backend.h); NULL when off.
+    const struct InstrumentOptions* instrument;
+
+    // `rae build --log-level`: lib/logging.rae calls below this level
+    // (0 = debug, 4 = off) are not emitted; 0 keeps them all.
+    int log_level;
+
+    // `rae bench`: emit a main that runs the program's `bench` functions
+    // through the runtime harness instead of the program's own main.
+    bool bench;
 } CompilerContext;
 
 void compiler_init(CompilerContext* ctx, Arena* ast_arena);
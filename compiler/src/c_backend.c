@@ -269,6 +269,11 @@ bool type_refs_equal(const AstTypeRef* a, const AstTypeRef* b) {
         if (!str_eq(a->parts->text, b->parts->text)) { res = false; goto done; }
     } else if (a->parts != b->parts) { res = false; goto done; }
     if (a->is_opt != b->is_opt || a->is_view != b->is_view || a->is_mod != b->is_mod) { res = false; goto done; }
+    /* Value arguments have no `parts`, so without this Array(Float, cap: 24)
+     * compared equal to Array(Float, cap: 16) and only the first one
+     * registered got its typedef. */
+    if (a->is_value_arg != b->is_value_arg) { res = false; goto done; }
+    if (a->is_value_arg && a->value_is_folded && b->value_is_folded && a->value_folded != b->value_folded) { res = false; goto done; }
     const AstTypeRef* arg_a = a->generic_args; const AstTypeRef* arg_b = b->generic_args;
     while (arg_a && arg_b) { if (!type_refs_equal(arg_a, arg_b)) { res = false; goto done; } arg_a = arg_a->next; arg_b = arg_b->next; }
     res = (arg_a == arg_b);
@@ -1085,6 +1090,145 @@ static bool global_init_is_deferred(const AstExpr* v) {
 }
 
 
+// ---- `rae build --instrument` ------------------------------------------
+// Every instrumented function gets a static RaeProfSite and an enter/leave
+// pair around its body (runtime_profile.c); each `ret` closes the zone
+// after its value, defers and drops (see AST_STMT_RET), and a crash leaves
+// the zones that were open unterminated in the trace, which is where the
+// fault happened.
+
+// Statements in a body, counting nested blocks. A zone costs two clock
+// reads, which would dominate a three-line getter, so loop-free functions
+// under InstrumentOptions.min_size stay uninstrumented.
+static int instrument_block_size(const AstBlock* b, bool* has_loop);
+
+static int instrument_stmt_size(const AstStmt* s, bool* has_loop) {
+  switch (s->kind) {
+    case AST_STMT_IF:
+      return 1 + instrument_block_size(s->as.if_stmt.then_block, has_loop)
+               + instrument_block_size(s->as.if_stmt.else_block, has_loop);
+    case AST_STMT_LOOP:
+      *has_loop = true;
+      return 1 + instrument_block_size(s->as.loop_stmt.body, has_loop);
+    case AST_STMT_MATCH: {
+      int n = 1;
+      for (const AstMatchCase* c = s->as.match_stmt.cases; c; c = c->next) {
+        n += instrument_block_size(c->block, has_loop);
+      }
+      return n;
+    }
+    case AST_STMT_DEFER:
+      return 1 + instrument_block_size(s->as.defer_stmt.block, has_loop);
+    default:
+      return 1;
+  }
+}
+
+static int instrument_block_size(const AstBlock* b, bool* has_loop) {
+  int n = 0;
+  if (b) { for (const AstStmt* s = b->first; s; s = s->next) n += instrument_stmt_size(s, has_loop); }
+  return n;
+}
+
+// Glob match with `*` as any run of characters.
+static bool instrument_glob(const char* pat, size_t plen, const char* s) {
+  if (plen == 0) return *s == '\0';
+  if (pat[0] == '*') {
+    for (;; s++) {
+      if (instrument_glob(pat + 1, plen - 1, s)) return true;
+      if (*s == '\0') return false;
+    }
+  }
+  return *s == pat[0] && instrument_glob(pat + 1, plen - 1, s + 1);
+}
+
+// `filter` is a comma-separated pattern list; NULL or empty matches all.
+static bool instrument_filter_match(const char* filter, const char* zone) {
+  if (!filter || !*filter) return true;
+  for (const char* p = filter; *p;) {
+    const char* end = strchr(p, ',');
+    size_t len = end ? (size_t)(end - p) : strlen(p);
+    if (len > 0 && instrument_glob(p, len, zone)) return true;
+    if (!end) break;
+    p = end + 1;
+  }
+  return false;
+}
+
+void emit_prof_zone_enter(CFuncContext* ctx, FILE* out) {
+  const InstrumentOptions* io = ctx->compiler_ctx->instrument;
+  const AstFuncDecl* f = ctx->func_decl;
+  if (!io || !io->enabled || !f || !f->body) return;
+  bool is_main = str_eq_cstr(f->name, "main");
+  // An instrumented binary captures from RAE_PROFILE* with no code of its own.
+  if (is_main) fprintf(out, "  rae_prof_instrument_start();\n");
+  // Zones are named `module.func` after the last segment of the module path
+  // ("main.update", "json.parse"); filters match that or the bare name.
+  const char* mod = f->module_name ? f->module_name : "main";
+  const char* slash = strrchr(mod, '/');
+  if (slash) mod = slash + 1;
+  // lib/profile.rae is the recorder's own surface, zoneBegin and friends;
+  // the core prelude is list and string primitives, leaves in every profile.
+  if (strcmp(mod, "profile") == 0 || strcmp(mod, "core") == 0) return;
+  bool has_loop = false;
+  if (!is_main && instrument_block_size(f->body, &has_loop) < io->min_size && !has_loop) return;
+  char zone[256];
+  snprintf(zone, sizeof(zone), "%s.%.*s", mod, (int)f->name.len, f->name.data);
+  // The bare name follows "mod."; a module name long enough to truncate
+  // `zone` leaves it empty rather than past the end of the buffer.
+  size_t zone_len = strlen(zone);
+  size_t bare_at = strlen(mod) + 1;
+  if (bare_at > zone_len) bare_at = zone_len;
+  if (!instrument_filter_match(io->filter, zone) &&
+      !instrument_filter_match(io->filter, zone + bare_at)) return;
+  fprintf(out, "  static RaeProfSite __rae_prof_site = { \"%s\", %zu, 0 };\n", zone, zone_len);
+  fprintf(out, "  int64_t __rae_prof_t0 = rae_prof_enter(&__rae_prof_site);\n");
+  ctx->prof_zone = true;
+}
+
+void emit_prof_zone_leave(CFuncContext* ctx, FILE* out) {
+  if (ctx->prof_zone) fprintf(out, "    rae_prof_leave(&__rae_prof_site, __rae_prof_t0);\n");
+}
+
+// Assign module-level globals whose initializers are function/method calls
+// (not valid as C static initializers) — run once at the top of main, before
+// its body, in declaration order. See global_init_is_deferred + the globals
+// emitter.
+static void emit_deferred_global_inits(CFuncContext* tctx, FILE* out) {
+  CompilerContext* ctx = tctx->compiler_ctx;
+  for (size_t gi = 0; gi < ctx->all_decl_count; gi++) {
+      const AstDecl* gd = ctx->all_decls[gi];
+      if (gd->kind != AST_DECL_GLOBAL_LET || !global_init_is_deferred(gd->as.let_decl.value)) continue;
+      bool sh = tctx->has_expected_type; AstTypeRef se = tctx->expected_type;
+      if (gd->as.let_decl.type) { tctx->expected_type = *gd->as.let_decl.type; tctx->has_expected_type = true; }
+      fprintf(out, "  %.*s = ", (int)gd->as.let_decl.name.len, gd->as.let_decl.name.data);
+      emit_expr(tctx, gd->as.let_decl.value, out, PREC_LOWEST, false, false);
+      fprintf(out, ";\n");
+      tctx->has_expected_type = sh; tctx->expected_type = se;
+  }
+}
+
+// `rae bench`: the program's own main is left out and this one hands every
+// `bench` function (sema checked the `(n: Int) ret Int` shape) to the
+// runtime harness, runtime_bench.c. Harness options arrive as argv.
+static void emit_bench_main(CompilerContext* ctx, const AstModule* module, FILE* out) {
+  CFuncContext tctx = {.compiler_ctx = ctx, .module = module, .func_first_let_idx = (size_t)-1};
+  int count = 0;
+  fprintf(out, "static const RaeBenchCase __rae_bench_cases[] = {\n");
+  for (size_t i = 0; i < ctx->all_decl_count; i++) {
+      const AstDecl* d = ctx->all_decls[i];
+      if (d->kind != AST_DECL_FUNC || d->as.func_decl.generic_params || d->as.func_decl.is_extern ||
+          !has_property(d->as.func_decl.properties, "bench")) continue;
+      fprintf(out, "  { \"%.*s\", %s },\n", (int)d->as.func_decl.name.len, d->as.func_decl.name.data,
+              rae_mangle_function(ctx, &d->as.func_decl));
+      count++;
+  }
+  fprintf(out, "  { NULL, NULL }\n};\n\n");
+  fprintf(out, "int main(int argc, char** argv) {\n");
+  emit_deferred_global_inits(&tctx, out);
+  fprintf(out, "  return rae_bench_main(argc, argv, __rae_bench_cases, %d);\n}\n\n", count);
+}
+
 bool emit_function(CompilerContext* ctx, const AstModule* m, const AstFuncDecl* f, FILE* out, const struct VmRegistry* r, bool ray) {
   if (f->is_extern || str_starts_with_cstr(f->name, "rae_ext_")) return true;
   CFuncContext tctx = {.compiler_ctx = ctx, .module = m, .func_decl = f, .uses_raylib = ray, .registry = r, .func_first_let_idx = (size_t)-1};
@@ -1135,7 +1279,7 @@ bool emit_function(CompilerContext* ctx, const AstModule* m, const AstFuncDecl*
   tctx.func_first_let_idx = first_let_idx;
 
   // Stage 4: per-function string-temp-pool guard. Catches any
-  // pool registrations from `rae_ext_rae_str_interp` that escape
+  // pool registrations from `rae_fmt_finish` (interpolation) that escape
   // their containing statement (e.g. `let n: Int = "{i}".length()`
   // where the interp result lives long enough to be read but isn't
   // captured by any String binding). The expression-statement and
@@ -1143,22 +1287,9 @@ bool emit_function(CompilerContext* ctx, const AstModule* m, const AstFuncDecl*
   // the safety net so the global pool doesn't grow unbounded
   // across long-running call chains.
   fprintf(out, "  int __rae_spm_func = rae_string_pool_mark();\n");
+  emit_prof_zone_enter(&tctx, out);
 
-  // Assign module-level globals whose initializers are function/method calls
-  // (not valid as C static initializers) — run once here, before main's body,
-  // in declaration order. See global_init_is_deferred + the globals emitter.
-  if (is_main) {
-      for (size_t gi = 0; gi < ctx->all_decl_count; gi++) {
-          const AstDecl* gd = ctx->all_decls[gi];
-          if (gd->kind != AST_DECL_GLOBAL_LET || !global_init_is_deferred(gd->as.let_decl.value)) continue;
-          bool sh = tctx.has_expected_type; AstTypeRef se = tctx.expected_type;
-          if (gd->as.let_decl.type) { tctx.expected_type = *gd->as.let_decl.type; tctx.has_expected_type = true; }
-          fprintf(out, "  %.*s = ", (int)gd->as.let_decl.name.len, gd->as.let_decl.name.data);
-          emit_expr(&tctx, gd->as.let_decl.value, out, PREC_LOWEST, false, false);
-          fprintf(out, ";\n");
-          tctx.has_expected_type = sh; tctx.expected_type = se;
-      }
-  }
+  if (is_main) emit_deferred_global_inits(&tctx, out);
 
   if (f->body) { for (AstStmt* s = f->body->first; s; s = s->next) emit_stmt(&tctx, s, out); }
 
@@ -1172,6 +1303,7 @@ bool emit_function(CompilerContext* ctx, const AstModule* m, const AstFuncDecl*
   emit_implicit_drops_for_own_params(&tctx, out, first_let_idx);
 
   fprintf(out, "  rae_string_pool_flush(__rae_spm_func);\n");
+  emit_prof_zone_leave(&tctx, out);
 
   if (is_main) fprintf(out, "  return 0;\n}\n\n");
   else fprintf(out, "}\n\n");
@@ -1350,10 +1482,12 @@ bool emit_specialized_function(CompilerContext* ctx, const AstModule* m, const A
   tctx.func_first_let_idx = first_let_idx;
   // Stage 4: per-function string-temp-pool guard. See emit_function.
   fprintf(out, "  int __rae_spm_func = rae_string_pool_mark();\n");
+  emit_prof_zone_enter(&tctx, out);
   if (f->body) { for (AstStmt* s = f->body->first; s; s = s->next) emit_stmt(&tctx, s, out); }
   emit_implicit_drops_for_body(&tctx, out, first_let_idx);
   emit_implicit_drops_for_own_params(&tctx, out, first_let_idx);
   fprintf(out, "  rae_string_pool_flush(__rae_spm_func);\n");
+  emit_prof_zone_leave(&tctx, out);
   fprintf(out, "}\n\n"); return true;
 }
 
@@ -1563,14 +1697,15 @@ bool c_backend_emit_module(CompilerContext* ctx, const AstModule* module, const
       const char* mangled = rae_mangle_type_specialized(ctx, NULL, NULL, &(AstTypeRef){.parts = &(AstIdentifierPart){.text = td->name}});
 
       fprintf(out, "RAE_UNUSED static rae_String rae_to_str_%s_(const %s* this) {\n", mangled, mangled);
-      fprintf(out, "  rae_String __out = (rae_String){(uint8_t*)\"{ \", 2};\n");
+      fprintf(out, "  RaeFmt __fmt; rae_fmt_begin(&__fmt);\n");
+      fprintf(out, "  rae_fmt_str(&__fmt, (rae_String){(uint8_t*)\"{ \", 2});\n");
       bool first = true;
       for (const AstTypeField* f = td->fields; f; f = f->next) {
-          if (!first) fprintf(out, "  __out = rae_ext_rae_str_concat(__out, (rae_String){(uint8_t*)\", \", 2});\n");
+          if (!first) fprintf(out, "  rae_fmt_str(&__fmt, (rae_String){(uint8_t*)\", \", 2});\n");
           first = false;
           Str fbase = get_base_type_name(f->type);
           // opt T fields are stored as RaeAny; routing through the _Generic
-          // macro picks rae_ext_rae_str_any. Nested concrete user structs go
+          // macro picks rae_fmt_any. Nested concrete user structs go
           // through their own rae_to_str_; c_struct fields (raylib Color etc.)
           // and generic instantiations (List(Int), Map(K,V)) have no entry in
           // the _Generic macro, so render them as a "<Type>" placeholder
@@ -1587,18 +1722,18 @@ bool c_backend_emit_module(CompilerContext* ctx, const AstModule* module, const
           bool is_opt_field = f->type && f->type->is_opt;
           if (is_user_struct && !is_opt_field && !has_generic_args) {
               const char* fmangled = rae_mangle_type_specialized(ctx, NULL, NULL, &(AstTypeRef){.parts = &(AstIdentifierPart){.text = fbase}});
-              fprintf(out, "  __out = rae_ext_rae_str_concat(__out, rae_to_str_%s_(&this->%.*s));\n",
+              fprintf(out, "  rae_fmt_str_owned(&__fmt, rae_to_str_%s_(&this->%.*s));\n",
                   fmangled, (int)f->name.len, f->name.data);
           } else if ((is_c_struct || has_generic_args || is_generic_template) && !is_opt_field) {
-              fprintf(out, "  __out = rae_ext_rae_str_concat(__out, (rae_String){(uint8_t*)\"<%.*s>\", %d});\n",
+              fprintf(out, "  rae_fmt_str(&__fmt, (rae_String){(uint8_t*)\"<%.*s>\", %d});\n",
                   (int)fbase.len, fbase.data, (int)fbase.len + 2);
           } else {
-              fprintf(out, "  __out = rae_ext_rae_str_concat(__out, rae_ext_rae_str(this->%.*s));\n",
+              fprintf(out, "  rae_fmt_put(&__fmt, this->%.*s);\n",
                   (int)f->name.len, f->name.data);
           }
       }
-      fprintf(out, "  __out = rae_ext_rae_str_concat(__out, (rae_String){(uint8_t*)\" }\", 2});\n");
-      fprintf(out, "  return __out;\n}\n\n");
+      fprintf(out, "  rae_fmt_str(&__fmt, (rae_String){(uint8_t*)\" }\", 2});\n");
+      fprintf(out, "  return rae_fmt_finish(&__fmt);\n}\n\n");
   }
 
   // Layer 5 (docs/scope-exit-dealloc.md) — synthesised per-struct
@@ -2338,10 +2473,14 @@ bool c_backend_emit_module(CompilerContext* ctx, const AstModule* module, const
   
   // Finally emit main
   size_t pre_main_spec_count = ctx->specialized_func_count;
-  for (size_t i = 0; i < ctx->all_decl_count; i++) {
-      const AstDecl* d = ctx->all_decls[i];
-      if (d->kind == AST_DECL_FUNC && str_eq_cstr(d->as.func_decl.name, "main")) {
-          emit_function(ctx, module, &d->as.func_decl, out, registry, false);
+  if (ctx->bench) {
+      emit_bench_main(ctx, module, out);
+  } else {
+      for (size_t i = 0; i < ctx->all_decl_count; i++) {
+          const AstDecl* d = ctx->all_decls[i];
+          if (d->kind == AST_DECL_FUNC && str_eq_cstr(d->as.func_decl.name, "main")) {
+              emit_function(ctx, module, &d->as.func_decl, out, registry, false);
+          }
       }
   }
 
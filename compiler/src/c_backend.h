@@ -8,6 +8,14 @@
 
 struct VmRegistry;
 
+/* `rae build --instrument`: wrap function bodies in profiler zones
+ * (lib/profile.rae's native recorder). */
+typedef struct InstrumentOptions {
+  bool enabled;
+  const char* filter;  /* comma-separated zone-name patterns, `*` wildcard; NULL = all */
+  int min_size;        /* loop-free functions with fewer statements are skipped */
+} InstrumentOptions;
+
 bool c_backend_emit_module(CompilerContext* ctx, const AstModule* module, const char* out_path, struct VmRegistry* registry, bool* out_uses_raylib);
 void register_generic_type(CompilerContext* ctx, const AstTypeRef* type);
 void register_function_specialization(CompilerContext* ctx, const AstFuncDecl* decl, const AstTypeRef* concrete_args);
@@ -110,7 +110,14 @@ typedef struct {
   // C break/continue, so a non-local loop exit runs the same scope-exit drops
   // as fallthrough. Index [loop_depth-1] is the innermost loop.
   size_t loop_body_local_start[32];
+  // For each open loop, the id N of its `__rae_spm_iterN` String temp
+  // pool mark, flushed at the end of every iteration and before a
+  // break/continue.
+  int loop_pool_mark[32];
   int loop_depth;
+  // `--instrument`: this function opened a profiler zone on its static
+  // `__rae_prof_site`, which every return path closes.
+  bool prof_zone;
 } CFuncContext;
 
 // -- Helpers (small, used widely) --
@@ -177,6 +184,8 @@ void emit_opt_unbox_suffix(CFuncContext* ctx, const AstFuncDecl* fd, const AstTy
 
 // -- Defer stack --
 bool emit_defers(CFuncContext* ctx, int min_depth, FILE* out);
+void emit_prof_zone_enter(CFuncContext* ctx, FILE* out);
+void emit_prof_zone_leave(CFuncContext* ctx, FILE* out);
 void pop_defers(CFuncContext* ctx, int depth);
 
 // -- Scope-exit dealloc (Stage 2; see docs/scope-exit-dealloc.md) --
@@ -85,6 +85,19 @@ static bool arg_is_addressable_lvalue(CFuncContext* ctx, const AstExpr* e) {
     }
 }
 
+// The level of a lib/logging.rae leveled call (debug 0 .. error 3), or -1.
+static int logging_call_level(const AstFuncDecl* fd) {
+    static const char* names[] = {"debug", "info", "warn", "error"};
+    const char* mod = fd->module_name;
+    const char* slash = mod ? strrchr(mod, '/') : NULL;
+    if (slash) mod = slash + 1;
+    if (!mod || strcmp(mod, "logging") != 0) return -1;
+    for (int i = 0; i < 4; i++) {
+        if (str_eq_cstr(fd->name, names[i])) return i;
+    }
+    return -1;
+}
+
 bool emit_call_expr(CFuncContext* ctx, const AstExpr* expr, FILE* out) {
     // Hoist a type argument out of the value-arg list if present —
     // new generic-call syntax. See c_backend.c for the helper.
@@ -470,6 +483,13 @@ bool emit_call_expr(CFuncContext* ctx, const AstExpr* expr, FILE* out) {
     }
 
     if (fd) {
+        // `--log-level`: a lib/logging.rae call below the build's level is
+        // left out, arguments and all.
+        int call_level = logging_call_level(fd);
+        if (call_level >= 0 && call_level < ctx->compiler_ctx->log_level) {
+            fprintf(out, "((void)0)");
+            return true;
+        }
         if ((str_eq_cstr(fd->name, "log") || str_eq_cstr(fd->name, "logS")) && expr->as.call.args) {
             const AstExpr* arg_val = expr->as.call.args->value; if (arg_val->kind == AST_EXPR_BOX) arg_val = arg_val->as.unary.operand;
             const AstTypeRef* arg_tr = infer_expr_type_ref(ctx, arg_val);
@@ -52,10 +52,14 @@ static bool type_ref_is_c_struct(CFuncContext* ctx, const AstTypeRef* tr) {
 // (count>=2).
 extern int rae_func_count_param_refs(const AstFuncDecl* fd, Str name);
 
-// Emit "rae_ext_rae_str(X)" for primitives, "rae_to_str_<Type>_(&X)" for user
-// structs. The _Generic-based macro can't be extended from generated code,
-// so user types route through the per-type function emitted in c_backend.c.
-static void emit_to_string_expr(CFuncContext* ctx, const AstExpr* operand, FILE* out) {
+// How a value becomes text: an enum prints its member name through the
+// generated rae_enum_toString_<Enum>, a user struct goes through its
+// generated rae_to_str_<Type>_, and everything else through the runtime's
+// _Generic dispatch (rae_ext_rae_str / rae_fmt_put), which can't be
+// extended from generated code.
+typedef enum { TO_STRING_GENERIC, TO_STRING_ENUM, TO_STRING_STRUCT } ToStringKind;
+
+static ToStringKind classify_to_string(CFuncContext* ctx, const AstExpr* operand, Str* base_out) {
     const AstTypeRef* tr = infer_expr_type_ref(ctx, operand);
     Str base = get_base_type_name(tr);
     // A direct enum member access `Enum.member` may not infer to the enum type;
@@ -65,24 +69,41 @@ static void emit_to_string_expr(CFuncContext* ctx, const AstExpr* operand, FILE*
         && find_enum_decl(ctx, ctx->module, operand->as.member.object->as.ident) != NULL) {
         base = operand->as.member.object->as.ident;
     }
-    // Enum value -> its member NAME (auto-generated rae_enum_toString_<Enum>),
-    // so ClipKind.walk.toString() is "walk", not the ordinal "1".
+    *base_out = base;
+    // Enum value -> its member NAME, so ClipKind.walk.toString() is "walk",
+    // not the ordinal "1".
     if (base.len > 0 && !(tr && tr->is_opt) && find_enum_decl(ctx, ctx->module, base) != NULL) {
-        fprintf(out, "rae_enum_toString_%.*s((int64_t)(", (int)base.len, base.data);
-        emit_expr(ctx, operand, out, PREC_LOWEST, false, false);
-        fprintf(out, "))");
-        return;
+        return TO_STRING_ENUM;
     }
     const AstDecl* d = (base.len > 0) ? find_type_decl(ctx, ctx->module, base) : NULL;
     bool is_user_struct = d && d->kind == AST_DECL_TYPE
         && !has_property(d->as.type_decl.properties, "c_struct")
         && !d->as.type_decl.generic_params
         && !(tr && tr->is_opt);
-    if (is_user_struct) {
+    return is_user_struct ? TO_STRING_STRUCT : TO_STRING_GENERIC;
+}
+
+// Emit the enum / struct String conversion for a classified operand.
+static void emit_to_string_call(CFuncContext* ctx, const AstExpr* operand, ToStringKind kind, Str base, FILE* out) {
+    if (kind == TO_STRING_ENUM) {
+        fprintf(out, "rae_enum_toString_%.*s((int64_t)(", (int)base.len, base.data);
+        emit_expr(ctx, operand, out, PREC_LOWEST, false, false);
+        fprintf(out, "))");
+    } else {
         const char* mangled = rae_mangle_type_specialized(ctx->compiler_ctx, NULL, NULL, &(AstTypeRef){.parts = &(AstIdentifierPart){.text = base}});
         fprintf(out, "rae_to_str_%s_(&(", mangled);
         emit_expr(ctx, operand, out, PREC_LOWEST, false, false);
         fprintf(out, "))");
+    }
+}
+
+// Emit "rae_ext_rae_str(X)" for primitives, the generated enum / struct
+// conversion otherwise.
+static void emit_to_string_expr(CFuncContext* ctx, const AstExpr* operand, FILE* out) {
+    Str base;
+    ToStringKind kind = classify_to_string(ctx, operand, &base);
+    if (kind != TO_STRING_GENERIC) {
+        emit_to_string_call(ctx, operand, kind, base, out);
     } else {
         fprintf(out, "rae_ext_rae_str((");
         emit_expr(ctx, operand, out, PREC_LOWEST, false, false);
@@ -90,6 +111,32 @@ static void emit_to_string_expr(CFuncContext* ctx, const AstExpr* operand, FILE*
     }
 }
 
+// One interpolation part appended to the RaeFmt `__fmt<fmt_id>`: literals
+// and Strings are copied in as they are, primitives are formatted in place
+// by rae_fmt_put, and enum / struct conversions hand their String to
+// rae_fmt_str_owned, which releases it if it owns heap.
+static void emit_fmt_part(CFuncContext* ctx, const AstExpr* operand, int fmt_id, FILE* out) {
+    if (operand->kind == AST_EXPR_STRING) {
+        // The parser splits `"{a}{b}"` around empty literals; skip them.
+        if (operand->as.string_lit.len == 0) return;
+        fprintf(out, "rae_fmt_str(&__fmt%d, ", fmt_id);
+        emit_expr(ctx, operand, out, PREC_LOWEST, false, false);
+        fprintf(out, "); ");
+        return;
+    }
+    Str base;
+    ToStringKind kind = classify_to_string(ctx, operand, &base);
+    if (kind != TO_STRING_GENERIC) {
+        fprintf(out, "rae_fmt_str_owned(&__fmt%d, ", fmt_id);
+        emit_to_string_call(ctx, operand, kind, base, out);
+    } else {
+        fprintf(out, "rae_fmt_put(&__fmt%d, (", fmt_id);
+        emit_expr(ctx, operand, out, PREC_LOWEST, false, false);
+        fprintf(out, ")");
+    }
+    fprintf(out, "); ");
+}
+
 // Does this expression evaluate to a `String` (or `view String` after
 // the existing IDENT-deref) value? Used to drive the `+` → concat
 // lowering — infer_expr_type_ref doesn't always pin .toString() /
@@ -1030,57 +1077,21 @@ bool emit_expr(CFuncContext* ctx, const AstExpr* expr, FILE* out, int parent_pre
         break;
     }
     case AST_EXPR_INTERP: {
-        // Stage 4: interpolation lowers to a single varargs runtime
-        // call that concatenates all parts into one owned String,
-        // frees any owned input parts (the str_i64/str_f64/etc.
-        // conversions that produce heap data), and registers the
-        // result with the per-statement string pool. The result
-        // gets flushed at end-of-statement unless a let/assign/etc.
-        // explicitly takes ownership via rae_string_pool_take(...).
-        //
-        // For each part:
-        //   - AST_EXPR_STRING (literal)  → emit as borrowed (is_owned=0)
-        //   - AST_EXPR_IDENT of String   → wrap with rae_string_borrow
-        //                                  to clear is_owned (the local
-        //                                  still owns the data; we don't
-        //                                  want str_interp to free it)
-        //   - everything else            → emit_to_string_expr, which
-        //                                  produces an owned heap result
-        //                                  that str_interp consumes.
+        // Interpolation formats every part straight into one buffer (a
+        // stack RaeFmt, see rae_runtime.h) and makes a single owned
+        // String from it, registered with the per-statement string pool.
+        // The result gets flushed at end-of-statement unless a
+        // let/assign/etc. explicitly takes ownership via
+        // rae_string_pool_take(...). Parts are appended in source order;
+        // none of them allocates a String of its own (emit_fmt_part).
         AstInterpPart* part = expr->as.interp.parts;
         if (!part) { fprintf(out, "(rae_String){(uint8_t*)\"\", 0, 0, 0}"); break; }
-        int count = 0;
-        for (AstInterpPart* p = part; p; p = p->next) count++;
-
-        fprintf(out, "rae_ext_rae_str_interp(%d", count);
+        int fmt_id = ctx->temp_counter++;
+        fprintf(out, "(__extension__ ({ RaeFmt __fmt%d; rae_fmt_begin(&__fmt%d); ", fmt_id, fmt_id);
         for (AstInterpPart* p = part; p; p = p->next) {
-            fprintf(out, ", ");
-            if (p->value->kind == AST_EXPR_STRING) {
-                emit_expr(ctx, p->value, out, PREC_LOWEST, false, false);
-            } else if (p->value->kind == AST_EXPR_IDENT) {
-                // Identifier reference — wrap in rae_string_borrow so
-                // str_interp does NOT free the user's local at the end
-                // of interpolation. Skip the wrap when the identifier
-                // is `opt String` (a RaeAny in C, not a rae_String) or
-                // any view/mod ref — the standard emit_to_string_expr
-                // path through `rae_ext_rae_str(...)` handles those
-                // via _Generic dispatch.
-                const AstTypeRef* ptr = infer_expr_type_ref(ctx, p->value);
-                Str pbase = get_base_type_name(ptr);
-                bool plain_string = ptr && !ptr->is_opt && !ptr->is_view && !ptr->is_mod
-                                    && str_eq_cstr(pbase, "String");
-                if (plain_string) {
-                    fprintf(out, "rae_string_borrow(");
-                    emit_expr(ctx, p->value, out, PREC_LOWEST, false, false);
-                    fprintf(out, ")");
-                } else {
-                    emit_to_string_expr(ctx, p->value, out);
-                }
-            } else {
-                emit_to_string_expr(ctx, p->value, out);
-            }
+            emit_fmt_part(ctx, p->value, fmt_id, out);
         }
-        fprintf(out, ")");
+        fprintf(out, "rae_fmt_finish(&__fmt%d); }))", fmt_id);
         break;
     }
     case AST_EXPR_MATCH: {
@@ -866,6 +866,55 @@ static bool emit_if(CFuncContext* ctx, const AstStmt* stmt, FILE* out) {
     return true;
 }
 
+// Can evaluating `e` register String temporaries in the temp pool?
+// Conservative: only leaves, and operators over them that don't build a
+// String, answer no. Loop conditions that can get their own mark/flush.
+static bool expr_makes_no_string_temps(CFuncContext* ctx, const AstExpr* e) {
+    if (!e) return true;
+    switch (e->kind) {
+        case AST_EXPR_IDENT:
+        case AST_EXPR_INTEGER:
+        case AST_EXPR_FLOAT:
+        case AST_EXPR_STRING:
+        case AST_EXPR_CHAR:
+        case AST_EXPR_BOOL:
+        case AST_EXPR_NONE:
+            return true;
+        case AST_EXPR_UNARY: return expr_makes_no_string_temps(ctx, e->as.unary.operand);
+        case AST_EXPR_CAST: return expr_makes_no_string_temps(ctx, e->as.cast.operand);
+        case AST_EXPR_MEMBER: return expr_makes_no_string_temps(ctx, e->as.member.object);
+        case AST_EXPR_BINARY: {
+            if (e->as.binary.op == AST_BIN_ADD) {
+                const AstTypeRef* tr = infer_expr_type_ref(ctx, e);
+                if (!tr || str_eq_cstr(get_base_type_name(tr), "String")) return false;
+            }
+            return expr_makes_no_string_temps(ctx, e->as.binary.lhs) &&
+                   expr_makes_no_string_temps(ctx, e->as.binary.rhs);
+        }
+        default: return false;
+    }
+}
+
+// Open a loop body: every iteration is a String temp pool scope, so the
+// temporaries of lets, ifs and nested calls in the body are freed per
+// iteration instead of piling up until the function returns.
+static void emit_loop_body(CFuncContext* ctx, const AstStmt* stmt, size_t saved_locals,
+                           const char* indent, FILE* out) {
+    int mark_id = ctx->temp_counter++;
+    fprintf(out, "%sint __rae_spm_iter%d = rae_string_pool_mark();\n", indent, mark_id);
+    if (ctx->loop_depth < 32) {
+        ctx->loop_body_local_start[ctx->loop_depth] = saved_locals;
+        ctx->loop_pool_mark[ctx->loop_depth] = mark_id;
+    }
+    ctx->loop_depth++;
+    if (stmt->as.loop_stmt.body) {
+        for (const AstStmt* s = stmt->as.loop_stmt.body->first; s; s = s->next) emit_stmt(ctx, s, out);
+    }
+    ctx->loop_depth--;
+    emit_implicit_drops_for_body(ctx, out, saved_locals);
+    fprintf(out, "%srae_string_pool_flush(__rae_spm_iter%d);\n", indent, mark_id);
+}
+
 static bool emit_loop(CFuncContext* ctx, const AstStmt* stmt, FILE* out) {
     if (stmt->as.loop_stmt.is_range) {
         const AstStmt* binding = stmt->as.loop_stmt.init;
@@ -950,16 +999,7 @@ static bool emit_loop(CFuncContext* ctx, const AstStmt* stmt, FILE* out) {
         // break/continue drop back to here (before the element binding), so a
         // non-local exit drops the current element too, matching the per-
         // iteration drop below.
-        if (ctx->loop_depth < 32) ctx->loop_body_local_start[ctx->loop_depth] = saved_locals;
-        ctx->loop_depth++;
-        if (stmt->as.loop_stmt.body) {
-            for (const AstStmt* body_stmt = stmt->as.loop_stmt.body->first;
-                 body_stmt; body_stmt = body_stmt->next) {
-                emit_stmt(ctx, body_stmt, out);
-            }
-        }
-        ctx->loop_depth--;
-        emit_implicit_drops_for_body(ctx, out, saved_locals);
+        emit_loop_body(ctx, stmt, saved_locals, "      ", out);
         ctx->local_count = saved_locals;
         fprintf(out, "    }\n  }\n");
         return true;
@@ -980,19 +1020,25 @@ static bool emit_loop(CFuncContext* ctx, const AstStmt* stmt, FILE* out) {
         }
     }
     fprintf(out, "; ");
-    if (stmt->as.loop_stmt.condition) emit_expr(ctx, stmt->as.loop_stmt.condition, out, PREC_LOWEST, false, false);
+    const AstExpr* condition = stmt->as.loop_stmt.condition;
+    if (condition && !expr_makes_no_string_temps(ctx, condition)) {
+        // The condition runs once per iteration too; give it its own
+        // mark so its temps (`loop line != "{prefix}end"`) go right away.
+        int cond_id = ctx->temp_counter++;
+        fprintf(out, "({ int __rae_spm_cond%d = rae_string_pool_mark(); bool __rae_cond%d = ",
+                cond_id, cond_id);
+        emit_expr(ctx, condition, out, PREC_LOWEST, false, false);
+        fprintf(out, "; rae_string_pool_flush(__rae_spm_cond%d); __rae_cond%d; })",
+                cond_id, cond_id);
+    } else if (condition) {
+        emit_expr(ctx, condition, out, PREC_LOWEST, false, false);
+    }
     fprintf(out, "; ");
     if (stmt->as.loop_stmt.increment) emit_expr(ctx, stmt->as.loop_stmt.increment, out, PREC_LOWEST, false, false);
     fprintf(out, ") {\n");
     // break/continue drop owned locals back to the loop body start (the C for
     // init-let, an Int counter, is not tracked here and needs no drop).
-    if (ctx->loop_depth < 32) ctx->loop_body_local_start[ctx->loop_depth] = saved_locals;
-    ctx->loop_depth++;
-    if (stmt->as.loop_stmt.body) {
-        for (const AstStmt* s = stmt->as.loop_stmt.body->first; s; s = s->next) emit_stmt(ctx, s, out);
-    }
-    ctx->loop_depth--;
-    emit_implicit_drops_for_body(ctx, out, saved_locals);
+    emit_loop_body(ctx, stmt, saved_locals, "  ", out);
     ctx->local_count = saved_locals;
     fprintf(out, "  }\n");
     return true;
@@ -1088,7 +1134,7 @@ bool emit_stmt(CFuncContext* ctx, const AstStmt* stmt, FILE* out) {
     if (!stmt) return true;
     switch (stmt->kind) {
         case AST_STMT_EXPR: {
-            // Stage 4: wrap with string-pool mark/flush. `rae_ext_rae_str_interp`
+            // Stage 4: wrap with string-pool mark/flush. `rae_fmt_finish`
             // registers each interp result; flush at the end of this expression
             // statement cleans up any temps the expression created (the common
             // case: `log("iter {i}")` where the interp result is consumed by log
@@ -1818,6 +1864,7 @@ bool emit_stmt(CFuncContext* ctx, const AstStmt* stmt, FILE* out) {
                     && stmt->as.ret_stmt.values->value->kind == AST_EXPR_NONE) {
                     fprintf(out, "NULL;\n");
                     emit_implicit_drops_for_body(ctx, out, ctx->func_first_let_idx);
+                    emit_prof_zone_leave(ctx, out);
                     fprintf(out, "    return __ret_val;\n  }\n");
                     break;
                 }
@@ -2042,6 +2089,10 @@ bool emit_stmt(CFuncContext* ctx, const AstStmt* stmt, FILE* out) {
                 }
             }
 
+            // `--instrument`: the zone closes after the value, defers and
+            // drops, so all of the function's own work is inside it.
+            emit_prof_zone_leave(ctx, out);
+
             if (has_value) {
                 fprintf(out, "    return __ret_val;\n");
             } else if (is_main_fn) {
@@ -2110,6 +2161,10 @@ bool emit_stmt(CFuncContext* ctx, const AstStmt* stmt, FILE* out) {
             if (ctx->loop_depth > 0) {
                 emit_implicit_drops_for_body(
                     ctx, out, ctx->loop_body_local_start[ctx->loop_depth - 1]);
+                if (ctx->loop_depth <= 32) {
+                    fprintf(out, "  rae_string_pool_flush(__rae_spm_iter%d);\n",
+                            ctx->loop_pool_mark[ctx->loop_depth - 1]);
+                }
             }
             fprintf(out, stmt->kind == AST_STMT_BREAK ? "  break;\n" : "  continue;\n");
             break;
@@ -41,6 +41,7 @@
 #include "vm_raylib.h"
 #include "vm_tinyexpr.h"
 #include "raepack.h"
+#include "scenepack.h"
 #include "sys_thread.h"
 #include "vm_natives_core.h"
 #include "../runtime/rae_runtime.h"
@@ -60,6 +61,8 @@ typedef struct {
   int profile;
   bool no_implicit;
   bool zero_config;  // entry was inferred from the cwd (folder `rae run`/`watch`)
+  InstrumentOptions instrument;
+  int log_level;     // `--log-level`: lib/logging.rae calls below it are not emitted
 } RunOptions;
 
 typedef struct {
@@ -70,11 +73,14 @@ typedef struct {
   int target;
   int profile;
   bool no_implicit;
+  InstrumentOptions instrument;
+  int log_level;
 } BuildOptions;
 
 typedef struct {
   const char* file_path;
   const char* target_id;
+  const char* out_path;
   bool json;
 } PackOptions;
 
@@ -158,6 +164,9 @@ static bool build_c_backend_output(const char* entry_file,
                                    const char* project_root,
                                    const char* out_file,
                                    bool no_implicit,
+                                   const InstrumentOptions* instrument,
+                                   int log_level,
+                                   bool bench,
                                    bool* out_uses_raylib,
                                    bool* out_uses_sdl3,
                                    bool* out_uses_webgpu,
@@ -265,6 +274,49 @@ static const char* manifest_entry_in_cwd(void) {
   return entry;
 }
 
+/* `--instrument[=PATTERNS]` and `--instrument-min-size N`, shared by run and
+ * build. Returns how many arguments it consumed: 0 if `argv[i]` is not one of
+ * them, -1 on a malformed value. */
+static int parse_instrument_arg(int argc, char** argv, int i, InstrumentOptions* io) {
+  const char* arg = argv[i];
+  if (strcmp(arg, "--instrument") == 0) {
+    io->enabled = true;
+    io->filter = NULL;
+    return 1;
+  }
+  if (strncmp(arg, "--instrument=", 13) == 0) {
+    io->enabled = true;
+    io->filter = arg + 13;
+    return 1;
+  }
+  if (strcmp(arg, "--instrument-min-size") == 0) {
+    if (i + 1 >= argc || argv[i + 1][0] < '0' || argv[i + 1][0] > '9') {
+      fprintf(stderr, "error: --instrument-min-size expects a statement count\n");
+      return -1;
+    }
+    io->min_size = atoi(argv[i + 1]);
+    return 2;
+  }
+  return 0;
+}
+
+/* `--log-level <debug|info|warn|error|off>`, shared by run and build: the
+ * lib/logging.rae calls below the level are left out of the emitted C.
+ * Returns how many arguments it consumed: 0 if `argv[i]` is not it, -1 on a
+ * bad level. */
+static int parse_log_level_arg(int argc, char** argv, int i, int* level) {
+  static const char* names[] = {"debug", "info", "warn", "error", "off"};
+  if (strcmp(argv[i], "--log-level") != 0) return 0;
+  for (int l = 0; i + 1 < argc && l < 5; l++) {
+    if (strcmp(argv[i + 1], names[l]) == 0) {
+      *level = l;
+      return 2;
+    }
+  }
+  fprintf(stderr, "error: --log-level expects debug, info, warn, error or off\n");
+  return -1;
+}
+
 static bool parse_run_args(int argc, char** argv, RunOptions* opts) {
   opts->watch = false;
   opts->input_path = NULL;
@@ -274,6 +326,8 @@ static bool parse_run_args(int argc, char** argv, RunOptions* opts) {
   opts->profile = BUILD_PROFILE_RELEASE;
   opts->no_implicit = false;
   opts->zero_config = false;
+  opts->instrument = (InstrumentOptions){.enabled = false, .filter = NULL, .min_size = 4};
+  opts->log_level = 0;
 
   int i = 0;
   while (i < argc) {
@@ -283,6 +337,18 @@ static bool parse_run_args(int argc, char** argv, RunOptions* opts) {
       i += 1;
       continue;
     }
+    int used = parse_instrument_arg(argc, argv, i, &opts->instrument);
+    if (used < 0) return false;
+    if (used > 0) {
+      i += used;
+      continue;
+    }
+    used = parse_log_level_arg(argc, argv, i, &opts->log_level);
+    if (used < 0) return false;
+    if (used > 0) {
+      i += used;
+      continue;
+    }
     // Build profile for the compiled target: release (-O2 -DNDEBUG) or
     // dev/debug (-O0 -g). Ignored by the live (bytecode) target. The
     // `--release` / `--debug` aliases mirror the common convention.
@@ -413,6 +479,8 @@ static bool parse_build_args(int argc, char** argv, BuildOptions* opts) {
   opts->target = BUILD_TARGET_COMPILED;
   opts->profile = BUILD_PROFILE_RELEASE;
   opts->no_implicit = false;
+  opts->instrument = (InstrumentOptions){.enabled = false, .filter = NULL, .min_size = 4};
+  opts->log_level = 0;
 
   const char* entry_from_flag = NULL;
   const char* entry_positional = NULL;
@@ -425,6 +493,18 @@ static bool parse_build_args(int argc, char** argv, BuildOptions* opts) {
       i += 1;
       continue;
     }
+    int used = parse_instrument_arg(argc, argv, i, &opts->instrument);
+    if (used < 0) return false;
+    if (used > 0) {
+      i += used;
+      continue;
+    }
+    used = parse_log_level_arg(argc, argv, i, &opts->log_level);
+    if (used < 0) return false;
+    if (used > 0) {
+      i += used;
+      continue;
+    }
     if (strcmp(arg, "--emit-c") == 0) {
       opts->emit_c = true;
       i += 1;
@@ -547,6 +627,7 @@ static bool parse_build_args(int argc, char** argv, BuildOptions* opts) {
 static bool parse_pack_args(int argc, char** argv, PackOptions* opts) {
   opts->file_path = NULL;
   opts->target_id = NULL;
+  opts->out_path = NULL;
   opts->json = false;
 
   int i = 0;
@@ -566,6 +647,15 @@ static bool parse_pack_args(int argc, char** argv, PackOptions* opts) {
       i += 2;
       continue;
     }
+    if (strcmp(arg, "-o") == 0 || strcmp(arg, "--out") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "error: %s expects an output path\n", arg);
+        return false;
+      }
+      opts->out_path = argv[i + 1];
+      i += 2;
+      continue;
+    }
     if (arg[0] == '-') {
       fprintf(stderr, "error: unknown pack option '%s'\n", arg);
       return false;
@@ -2061,12 +2151,47 @@ static void print_usage(const char* prog) {
   fprintf(stderr, "                           compiled target: dev=-O0 -g, release=-O2 -DNDEBUG)\n");
   fprintf(stderr, "  pack <file>     Validate and summarize a .raepack file\n");
   fprintf(stderr, "                 (options: --json, --target <id>)\n");
+  fprintf(stderr, "  pack <file.raescene> [-o <out>]\n");
+  fprintf(stderr, "                  Precompile a JSON scene into the binary\n");
+  fprintf(stderr, "                  .raescene.bin format (default: <file>.bin)\n");
   fprintf(stderr,
           "  build [opts]    Build Rae source (Compiled C, Live, Hybrid, or browser WASM)\n");
   fprintf(stderr,
           "                  Options: --entry <file>, --project <dir>, --out <file>\n");
   fprintf(stderr,
           "                           --target <live|compiled|hybrid|wasm>, --profile <dev|release>\n");
+  fprintf(stderr,
+          "                           --instrument[=<patterns>] wraps functions in profiler\n");
+  fprintf(stderr,
+          "                           zones (`module.func` globs, comma-separated; also on run),\n");
+  fprintf(stderr,
+          "                           --instrument-min-size <n> skips loop-free functions\n");
+  fprintf(stderr,
+          "                           under n statements (default 4)\n");
+  fprintf(stderr,
+          "                           --log-level <debug|info|warn|error|off> leaves the\n");
+  fprintf(stderr,
+          "                           lib/logging calls below it out of the build (also on run)\n");
+  fprintf(stderr,
+          "  bench <file> [opts]\n");
+  fprintf(stderr,
+          "                  Build <file> in release mode and run its `bench` functions\n");
+  fprintf(stderr,
+          "                  (func name(n: view Int) bench ret Int) with warmup, calibrated\n");
+  fprintf(stderr,
+          "                  iteration counts, outlier rejection and 95%% intervals, plus\n");
+  fprintf(stderr,
+          "                  IPC and misses per iteration where perf counters are available.\n");
+  fprintf(stderr,
+          "                  Options: --filter <text>, --samples <n>, --sample-ms <ms>,\n");
+  fprintf(stderr,
+          "                           --warmup-ms <ms>, --save <baseline.json>,\n");
+  fprintf(stderr,
+          "                           --baseline <baseline.json>, --threshold <percent>\n");
+  fprintf(stderr,
+          "                           (exit 1 on a significant regression), --keep <binary>,\n");
+  fprintf(stderr,
+          "                           --log-level <level>, --no-counters\n");
   fprintf(stderr,
           "  watch <file>    Compiled hot-reload supervisor. Builds and runs <file>,\n");
   fprintf(stderr,
@@ -2203,8 +2328,23 @@ static void dump_raepack_json(const RaePack* pack, const RaePackTarget* selected
   printf("\n}\n");
 }
 
+static bool path_has_suffix(const char* path, const char* suffix) {
+  size_t n = strlen(path);
+  size_t m = strlen(suffix);
+  return n >= m && strcmp(path + n - m, suffix) == 0;
+}
+
 static int run_raepack_file(const PackOptions* opts) {
   if (!opts || !opts->file_path) return 1;
+  if (path_has_suffix(opts->file_path, ".raescene")) {
+    char default_out[4096];
+    const char* out_path = opts->out_path;
+    if (!out_path) {
+      snprintf(default_out, sizeof(default_out), "%s.bin", opts->file_path);
+      out_path = default_out;
+    }
+    return scenepack_pack_file(opts->file_path, out_path, true) ? 0 : 1;
+  }
   RaePack pack;
   if (!raepack_parse_file(opts->file_path, &pack, true)) {
     return 1;
@@ -2293,6 +2433,9 @@ static bool build_c_backend_output(const char* entry_file,
                                    const char* project_root,
                                    const char* out_file,
                                    bool no_implicit,
+                                   const InstrumentOptions* instrument,
+                                   int log_level,
+                                   bool bench,
                                    bool* out_uses_raylib,
                                    bool* out_uses_sdl3,
                                    bool* out_uses_webgpu,
@@ -2384,6 +2527,9 @@ static bool build_c_backend_output(const char* entry_file,
 
   CompilerContext ctx;
   compiler_init(&ctx, arena);
+  ctx.instrument = instrument;
+  ctx.log_level = log_level;
+  ctx.bench = bench;
   
   if (!sema_analyze_module(&ctx, &merged)) {
       module_graph_free(&graph);
@@ -2725,10 +2871,20 @@ static bool gcc_link_c_to_binary(const char* entry_rae_file,
     }
   }
 
+#ifdef __APPLE__
+  const char* std_flags = "-std=c11";
+  const char* platform_libs = "-framework Foundation -framework ImageIO -framework CoreGraphics";
+#else
+  // Elsewhere (Linux CI boxes running `rae bench`): the runtime needs the
+  // POSIX declarations strict c11 hides, and libm/pthreads/dl are separate.
+  const char* std_flags = "-std=gnu11";
+  const char* platform_libs = "-lm -lpthread -ldl";
+#endif
+
   char cmd[PATH_MAX * 4];
-  snprintf(cmd, sizeof(cmd), "gcc -std=c11 %s -w %s %s %s -I%s -I/opt/homebrew/include -L/opt/homebrew/lib -framework Foundation -framework ImageIO -framework CoreGraphics %s %s/rae_runtime.c%s -o %s",
-           opt_flags, raylib_flags, sdl3_flags, wgpu_flags, runtime_dir,
-           c_path, runtime_dir, extra_c_files, out_bin);
+  snprintf(cmd, sizeof(cmd), "gcc %s %s -w %s %s %s -I%s -I/opt/homebrew/include -L/opt/homebrew/lib %s %s/rae_runtime.c%s %s -o %s",
+           std_flags, opt_flags, raylib_flags, sdl3_flags, wgpu_flags, runtime_dir,
+           c_path, runtime_dir, extra_c_files, platform_libs, out_bin);
 
   if (system(cmd) != 0) {
     fprintf(stderr, "error: failed to compile C output\n");
@@ -2961,7 +3117,7 @@ static int run_compiled_file(const RunOptions* run_opts, const char* project_roo
   bool uses_raylib = false;
   bool uses_sdl3 = false;
   bool uses_webgpu = false;
-  if (!build_c_backend_output(file_path, project_root, temp_c, run_opts->no_implicit, &uses_raylib, &uses_sdl3, &uses_webgpu, NULL)) {
+  if (!build_c_backend_output(file_path, project_root, temp_c, run_opts->no_implicit, &run_opts->instrument, run_opts->log_level, false, &uses_raylib, &uses_sdl3, &uses_webgpu, NULL)) {
     if (chdired && have_saved) { if (chdir(saved_cwd) != 0) {} }
     return 1;
   }
@@ -2995,6 +3151,107 @@ static int run_compiled_file(const RunOptions* run_opts, const char* project_roo
   return (result == 0) ? 0 : 1;
 }
 
+/* `rae bench <file> [--keep <binary>] [--log-level <l>] [--no-implicit]
+ * [harness options]`: build <file> in release mode with the bench main
+ * (c_backend.c), which runs its `bench` functions through the runtime
+ * harness, and run it. Every option not listed here goes to the harness
+ * (runtime_bench.c: --filter, --samples, --sample-ms, --warmup-ms, --save,
+ * --baseline, --threshold). The harness runs by fork + exec, so they
+ * reach it as given, with no shell in between. The exit status is the
+ * harness's: 1 when a benchmark regressed against --baseline. */
+static int cmd_bench(int argc, char** argv) {
+  const char* input_path = NULL;
+  const char* keep_path = NULL;
+  bool no_implicit = false;
+  int log_level = 0;
+  // argv for the harness: [0] is the binary, filled in once it is built.
+  const char** harness_argv = calloc((size_t)argc + 2, sizeof(const char*));
+  if (!harness_argv) return 1;
+  int harness_argc = 1;
+  int rc = 1;
+  for (int i = 0; i < argc; i++) {
+    int used = parse_log_level_arg(argc, argv, i, &log_level);
+    if (used < 0) goto done;
+    if (used > 0) {
+      i += used - 1;
+      continue;
+    }
+    if (strcmp(argv[i], "--no-implicit") == 0) {
+      no_implicit = true;
+    } else if (strcmp(argv[i], "--keep") == 0 && i + 1 < argc) {
+      keep_path = argv[++i];
+    } else if (argv[i][0] != '-' && !input_path) {
+      input_path = argv[i];
+    } else {
+      // A harness option and its value (--no-counters has none).
+      int take = (strcmp(argv[i], "--no-counters") != 0 && i + 1 < argc) ? 2 : 1;
+      for (int k = 0; k < take; k++) harness_argv[harness_argc++] = argv[i + k];
+      i += take - 1;
+    }
+  }
+  if (!input_path) {
+    fprintf(stderr, "error: bench expects a .rae file with `bench` functions\n");
+    print_usage("rae");
+    goto done;
+  }
+  char abs_entry[PATH_MAX];
+  if (!realpath(input_path, abs_entry)) {
+    fprintf(stderr, "error: entry file '%s' not found\n", input_path);
+    goto done;
+  }
+  char project_root[PATH_MAX];
+  snprintf(project_root, sizeof(project_root), "%s", abs_entry);
+  char* slash = strrchr(project_root, '/');
+  if (slash) *slash = '\0';
+  char lib_root[PATH_MAX];
+  find_lib_root(project_root, lib_root, sizeof(lib_root));
+  char probe[PATH_MAX + sizeof("/lib/core.rae")];
+  snprintf(probe, sizeof(probe), "%s/lib/core.rae", lib_root);
+  const char* root = file_exists(probe) ? lib_root : project_root;
+
+  const char* tmp_dir = getenv("TMPDIR");
+  if (!tmp_dir) tmp_dir = "/tmp";
+  char temp_c[PATH_MAX];
+  char temp_bin[PATH_MAX];
+  snprintf(temp_c, sizeof(temp_c), "%s/rae_bench_%d.c", tmp_dir, getpid());
+  snprintf(temp_bin, sizeof(temp_bin), "%s/rae_bench_%d.bin", tmp_dir, getpid());
+  const char* bin = keep_path ? keep_path : temp_bin;
+
+  bool uses_raylib = false, uses_sdl3 = false, uses_webgpu = false;
+  InstrumentOptions instrument = {.enabled = false, .filter = NULL, .min_size = 4};
+  if (!build_c_backend_output(abs_entry, root, temp_c, no_implicit, &instrument, log_level, true,
+                              &uses_raylib, &uses_sdl3, &uses_webgpu, NULL)) {
+    goto done;
+  }
+  bool linked = gcc_link_c_to_binary(abs_entry, temp_c, bin, uses_raylib, uses_sdl3, uses_webgpu,
+                                     BUILD_PROFILE_RELEASE);
+  unlink(temp_c);
+  if (!linked) goto done;
+
+  // A bare --keep name is a path, not a PATH lookup.
+  char bin_path[PATH_MAX + 2];
+  snprintf(bin_path, sizeof(bin_path), "%s%s", strchr(bin, '/') ? "" : "./", bin);
+  harness_argv[0] = bin_path;
+  harness_argv[harness_argc] = NULL;
+  fflush(NULL);
+  pid_t pid = fork();
+  if (pid < 0) {
+    fprintf(stderr, "error: could not start the bench harness: %s\n", strerror(errno));
+    rc = 2;
+  } else if (pid == 0) {
+    execv(bin_path, (char* const*)harness_argv);
+    fprintf(stderr, "error: execv(%s) failed (%s)\n", bin_path, strerror(errno));
+    _exit(127);
+  } else {
+    int status = 0;
+    rc = (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)) ? 2 : WEXITSTATUS(status);
+  }
+  if (!keep_path) unlink(temp_bin);
+done:
+  free(harness_argv);
+  return rc;
+}
+
 /* ===================================================================
  * `rae watch` — Phase 3 compiled-mode hot-reload supervisor.
  *
@@ -3768,6 +4025,9 @@ static int run_command(const char* cmd, int argc, char** argv) {
                                           final_root,
                                           build_opts.out_path,
                                           build_opts.no_implicit,
+                                          &build_opts.instrument,
+                                          build_opts.log_level,
+                                          false,
                                           &b_raylib,
                                           &b_sdl3,
                                           &b_webgpu,
@@ -3803,6 +4063,9 @@ static int run_command(const char* cmd, int argc, char** argv) {
                                           final_root,
                                           temp_c,
                                           build_opts.no_implicit,
+                                          &build_opts.instrument,
+                                          build_opts.log_level,
+                                          false,
                                           &b_raylib,
                                           &b_sdl3,
                                           &b_webgpu,
@@ -4107,6 +4370,9 @@ int main(int argc, char** argv) {
   if (strcmp(cmd, "bindgen") == 0) {
     return bindgen_run(argc - 2, argv + 2);
   }
+  if (strcmp(cmd, "bench") == 0) {
+    return cmd_bench(argc - 2, argv + 2);
+  }
 
   fprintf(stderr, "error: unknown command '%s'\n", cmd);
   print_usage(argv[0]);
@@ -0,0 +1,393 @@
+#include "scenepack.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* JsonKind ordinals, in lib/json.rae declaration order. */
+enum {
+  SP_KIND_NULL = 0,
+  SP_KIND_BOOL,
+  SP_KIND_NUMBER,
+  SP_KIND_STRING,
+  SP_KIND_ARRAY,
+  SP_KIND_OBJECT
+};
+
+typedef struct {
+  int64_t* data;
+  size_t len;
+  size_t cap;
+} SpInts;
+
+typedef struct {
+  int64_t kind;
+  float number;
+  int64_t a;
+  int64_t b;
+} SpValue;
+
+typedef struct {
+  /* Parsed pools. */
+  SpValue* values;
+  size_t value_count;
+  size_t value_cap;
+  SpInts children;
+  SpInts field_keys;
+  SpInts field_values;
+  /* Deduplicated string table: offsets into `bytes`, plus an open
+   * addressing index over them. */
+  SpInts str_offsets;
+  char* bytes;
+  size_t bytes_len;
+  size_t bytes_cap;
+  int64_t* str_index;
+  size_t str_index_cap;
+  /* Cursor. */
+  const char* src;
+  size_t len;
+  size_t pos;
+  const char* path;
+  bool ok;
+} ScenePacker;
+
+static void sp_ints_push(SpInts* ints, int64_t v) {
+  if (ints->len == ints->cap) {
+    ints->cap = ints->cap ? ints->cap * 2 : 64;
+    ints->data = realloc(ints->data, ints->cap * sizeof(int64_t));
+  }
+  ints->data[ints->len++] = v;
+}
+
+static int64_t sp_push_value(ScenePacker* sp, int64_t kind, float number, int64_t a, int64_t b) {
+  if (sp->value_count == sp->value_cap) {
+    sp->value_cap = sp->value_cap ? sp->value_cap * 2 : 64;
+    sp->values = realloc(sp->values, sp->value_cap * sizeof(SpValue));
+  }
+  sp->values[sp->value_count] = (SpValue){kind, number, a, b};
+  return (int64_t)sp->value_count++;
+}
+
+static uint64_t sp_hash(const char* s, size_t n) {
+  uint64_t h = 1469598103934665603ULL;
+  for (size_t i = 0; i < n; i++) {
+    h ^= (uint8_t)s[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+static size_t sp_string_count(const ScenePacker* sp) {
+  return sp->str_offsets.len - 1;
+}
+
+static void sp_index_rehash(ScenePacker* sp) {
+  size_t cap = sp->str_index_cap ? sp->str_index_cap * 2 : 256;
+  int64_t* index = malloc(cap * sizeof(int64_t));
+  for (size_t i = 0; i < cap; i++) index[i] = -1;
+  for (size_t s = 0; s < sp_string_count(sp); s++) {
+    size_t start = (size_t)sp->str_offsets.data[s];
+    size_t n = (size_t)sp->str_offsets.data[s + 1] - start;
+    size_t slot = (size_t)sp_hash(sp->bytes + start, n) & (cap - 1);
+    while (index[slot] >= 0) slot = (slot + 1) & (cap - 1);
+    index[slot] = (int64_t)s;
+  }
+  free(sp->str_index);
+  sp->str_index = index;
+  sp->str_index_cap = cap;
+}
+
+/* Intern `n` bytes and return their string-table index. */
+static int64_t sp_intern(ScenePacker* sp, const char* s, size_t n) {
+  if ((sp_string_count(sp) + 1) * 2 > sp->str_index_cap) sp_index_rehash(sp);
+  size_t mask = sp->str_index_cap - 1;
+  size_t slot = (size_t)sp_hash(s, n) & mask;
+  while (sp->str_index[slot] >= 0) {
+    int64_t idx = sp->str_index[slot];
+    size_t start = (size_t)sp->str_offsets.data[idx];
+    size_t have = (size_t)sp->str_offsets.data[idx + 1] - start;
+    if (have == n && memcmp(sp->bytes + start, s, n) == 0) return idx;
+    slot = (slot + 1) & mask;
+  }
+  if (sp->bytes_len + n > sp->bytes_cap) {
+    sp->bytes_cap = (sp->bytes_len + n) * 2 + 256;
+    sp->bytes = realloc(sp->bytes, sp->bytes_cap);
+  }
+  if (n > 0) memcpy(sp->bytes + sp->bytes_len, s, n);
+  sp->bytes_len += n;
+  int64_t idx = (int64_t)sp_string_count(sp);
+  sp_ints_push(&sp->str_offsets, (int64_t)sp->bytes_len);
+  sp->str_index[slot] = idx;
+  return idx;
+}
+
+static void sp_fail(ScenePacker* sp, const char* message) {
+  if (!sp->ok) return;
+  sp->ok = false;
+  size_t line = 1;
+  size_t col = 1;
+  for (size_t i = 0; i < sp->pos && i < sp->len; i++) {
+    if (sp->src[i] == '\n') { line++; col = 1; } else { col++; }
+  }
+  fprintf(stderr, "%s:%zu:%zu: error: %s\n", sp->path, line, col, message);
+}
+
+static void sp_skip_ws(ScenePacker* sp) {
+  while (sp->pos < sp->len && isspace((unsigned char)sp->src[sp->pos])) sp->pos++;
+}
+
+static char sp_peek(const ScenePacker* sp) {
+  return sp->pos < sp->len ? sp->src[sp->pos] : '\0';
+}
+
+/* Same escape handling as lib/json.rae's parseString, including passing
+ * `\uXXXX` through as a literal `u` so both load paths agree byte for
+ * byte. Returns the interned string index, or -1 on error. */
+static int64_t sp_parse_string(ScenePacker* sp) {
+  if (sp_peek(sp) != '"') {
+    sp_fail(sp, "expected string");
+    return -1;
+  }
+  sp->pos++;
+  size_t out_cap = 64;
+  size_t out_len = 0;
+  char* out = malloc(out_cap);
+  while (sp->pos < sp->len) {
+    char c = sp->src[sp->pos];
+    if (c == '"') {
+      sp->pos++;
+      int64_t idx = sp_intern(sp, out, out_len);
+      free(out);
+      return idx;
+    }
+    if (c == '\\') {
+      sp->pos++;
+      if (sp->pos >= sp->len) break;
+      char esc = sp->src[sp->pos];
+      switch (esc) {
+        case 'n': c = '\n'; break;
+        case 't': c = '\t'; break;
+        case 'r': c = '\r'; break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        default: c = esc; break;
+      }
+    }
+    if (out_len == out_cap) {
+      out_cap *= 2;
+      out = realloc(out, out_cap);
+    }
+    out[out_len++] = c;
+    sp->pos++;
+  }
+  free(out);
+  sp_fail(sp, "unterminated string");
+  return -1;
+}
+
+static bool sp_is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static float sp_parse_number(ScenePacker* sp) {
+  size_t start = sp->pos;
+  if (sp_peek(sp) == '-') sp->pos++;
+  while (sp_is_digit(sp_peek(sp))) sp->pos++;
+  if (sp_peek(sp) == '.') {
+    sp->pos++;
+    while (sp_is_digit(sp_peek(sp))) sp->pos++;
+  }
+  if (sp_peek(sp) == 'e' || sp_peek(sp) == 'E') {
+    sp->pos++;
+    if (sp_peek(sp) == '+' || sp_peek(sp) == '-') sp->pos++;
+    while (sp_is_digit(sp_peek(sp))) sp->pos++;
+  }
+  /* The Rae side converts with atof on the literal and narrows to Float;
+   * do the same so packed numbers are bit-identical. */
+  char lit[64];
+  size_t n = sp->pos - start;
+  if (n >= sizeof(lit)) n = sizeof(lit) - 1;
+  memcpy(lit, sp->src + start, n);
+  lit[n] = '\0';
+  return (float)atof(lit);
+}
+
+static bool sp_keyword(ScenePacker* sp, const char* kw) {
+  size_t n = strlen(kw);
+  if (sp->pos + n > sp->len || memcmp(sp->src + sp->pos, kw, n) != 0) return false;
+  sp->pos += n;
+  return true;
+}
+
+/* Mirrors parseValue: children are pushed before their container, and an
+ * object's fields (an array's elements) land contiguously in the shared
+ * pool when it closes. */
+static int64_t sp_parse_value(ScenePacker* sp) {
+  sp_skip_ws(sp);
+  if (!sp->ok) return -1;
+  char c = sp_peek(sp);
+  if (c == '{' || c == '[') {
+    bool is_object = (c == '{');
+    char close = is_object ? '}' : ']';
+    sp->pos++;
+    SpInts keys = {0};
+    SpInts vals = {0};
+    sp_skip_ws(sp);
+    if (sp_peek(sp) == close) {
+      sp->pos++;
+    } else {
+      for (;;) {
+        sp_skip_ws(sp);
+        if (is_object) {
+          int64_t key = sp_parse_string(sp);
+          sp_skip_ws(sp);
+          if (sp->ok && sp_peek(sp) != ':') sp_fail(sp, "expected ':'");
+          if (!sp->ok) break;
+          sp->pos++;
+          sp_ints_push(&keys, key);
+        }
+        int64_t v = sp_parse_value(sp);
+        if (!sp->ok) break;
+        sp_ints_push(&vals, v);
+        sp_skip_ws(sp);
+        if (sp_peek(sp) == ',') {
+          sp->pos++;
+          continue;
+        }
+        if (sp_peek(sp) == close) {
+          sp->pos++;
+          break;
+        }
+        sp_fail(sp, is_object ? "expected ',' or '}'" : "expected ',' or ']'");
+        break;
+      }
+    }
+    int64_t result = -1;
+    if (sp->ok) {
+      SpInts* pool = is_object ? &sp->field_values : &sp->children;
+      int64_t first = (int64_t)pool->len;
+      for (size_t i = 0; i < vals.len; i++) {
+        if (is_object) sp_ints_push(&sp->field_keys, keys.data[i]);
+        sp_ints_push(pool, vals.data[i]);
+      }
+      result = sp_push_value(sp, is_object ? SP_KIND_OBJECT : SP_KIND_ARRAY, 0.0f, first, (int64_t)vals.len);
+    }
+    free(keys.data);
+    free(vals.data);
+    return result;
+  }
+  if (c == '"') {
+    int64_t s = sp_parse_string(sp);
+    if (!sp->ok) return -1;
+    return sp_push_value(sp, SP_KIND_STRING, 0.0f, s, 0);
+  }
+  if (sp_keyword(sp, "true")) return sp_push_value(sp, SP_KIND_BOOL, 0.0f, 0, 1);
+  if (sp_keyword(sp, "false")) return sp_push_value(sp, SP_KIND_BOOL, 0.0f, 0, 0);
+  if (sp_keyword(sp, "null")) return sp_push_value(sp, SP_KIND_NULL, 0.0f, 0, 0);
+  if (c == '-' || sp_is_digit(c)) {
+    float n = sp_parse_number(sp);
+    return sp_push_value(sp, SP_KIND_NUMBER, n, 0, 0);
+  }
+  sp_fail(sp, "unexpected character");
+  return -1;
+}
+
+static void sp_write_i64(FILE* f, int64_t v) {
+  uint8_t b[8];
+  for (int i = 0; i < 8; i++) b[i] = (uint8_t)((uint64_t)v >> (8 * i));
+  fwrite(b, 1, 8, f);
+}
+
+static void sp_write_ints(FILE* f, const SpInts* ints) {
+  for (size_t i = 0; i < ints->len; i++) sp_write_i64(f, ints->data[i]);
+}
+
+static bool sp_write(const ScenePacker* sp, int64_t root, const char* out_path) {
+  FILE* f = fopen(out_path, "wb");
+  if (!f) {
+    fprintf(stderr, "error: could not write '%s'\n", out_path);
+    return false;
+  }
+  size_t v = sp->value_count;
+  sp_write_i64(f, SCENEPACK_MAGIC);
+  sp_write_i64(f, SCENEPACK_VERSION);
+  sp_write_i64(f, (int64_t)v);
+  sp_write_i64(f, (int64_t)sp->children.len);
+  sp_write_i64(f, (int64_t)sp->field_keys.len);
+  sp_write_i64(f, (int64_t)sp_string_count(sp));
+  sp_write_i64(f, (int64_t)sp->bytes_len);
+  sp_write_i64(f, root);
+  for (size_t i = 0; i < v; i++) sp_write_i64(f, sp->values[i].kind);
+  for (size_t i = 0; i < v; i++) {
+    uint32_t bits;
+    memcpy(&bits, &sp->values[i].number, 4);
+    uint8_t b[4] = {(uint8_t)bits, (uint8_t)(bits >> 8), (uint8_t)(bits >> 16), (uint8_t)(bits >> 24)};
+    fwrite(b, 1, 4, f);
+  }
+  if (v % 2 == 1) {
+    static const uint8_t pad[4] = {0};
+    fwrite(pad, 1, 4, f);
+  }
+  for (size_t i = 0; i < v; i++) sp_write_i64(f, sp->values[i].a);
+  for (size_t i = 0; i < v; i++) sp_write_i64(f, sp->values[i].b);
+  sp_write_ints(f, &sp->children);
+  sp_write_ints(f, &sp->field_keys);
+  sp_write_ints(f, &sp->field_values);
+  sp_write_ints(f, &sp->str_offsets);
+  if (sp->bytes_len > 0) fwrite(sp->bytes, 1, sp->bytes_len, f);
+  bool ok = (ferror(f) == 0);
+  if (fclose(f) != 0) ok = false;
+  if (!ok) fprintf(stderr, "error: could not write '%s'\n", out_path);
+  return ok;
+}
+
+static char* sp_read_file(const char* path, size_t* out_len) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (len < 0) {
+    fclose(f);
+    return NULL;
+  }
+  char* data = malloc((size_t)len + 1);
+  size_t got = fread(data, 1, (size_t)len, f);
+  fclose(f);
+  data[got] = '\0';
+  *out_len = got;
+  return data;
+}
+
+bool scenepack_pack_file(const char* in_path, const char* out_path, bool verbose) {
+  size_t len = 0;
+  char* src = sp_read_file(in_path, &len);
+  if (!src) {
+    fprintf(stderr, "error: could not read '%s'\n", in_path);
+    return false;
+  }
+  ScenePacker sp = {0};
+  sp.src = src;
+  sp.len = len;
+  sp.path = in_path;
+  sp.ok = true;
+  sp_ints_push(&sp.str_offsets, 0);
+  int64_t root = sp_parse_value(&sp);
+  sp_skip_ws(&sp);
+  if (sp.ok && sp.pos < sp.len) sp_fail(&sp, "trailing characters after the root value");
+  bool ok = sp.ok && sp_write(&sp, root, out_path);
+  if (ok && verbose) {
+    printf("packed %s -> %s (%zu values, %zu fields, %zu strings)\n",
+           in_path, out_path, sp.value_count, sp.field_keys.len, sp_string_count(&sp));
+  }
+  free(sp.values);
+  free(sp.children.data);
+  free(sp.field_keys.data);
+  free(sp.field_values.data);
+  free(sp.str_offsets.data);
+  free(sp.bytes);
+  free(sp.str_index);
+  free(src);
+  return ok;
+}
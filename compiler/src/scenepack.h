@@ -0,0 +1,34 @@
+#ifndef SCENEPACK_H
+#define SCENEPACK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Packed scene format (`.raescene.bin`), produced by `rae pack` from a
+ * `.raescene` JSON source and read by lib/ui/scene_bin.rae.
+ *
+ * The file is the parsed JSON document laid out as flat little-endian
+ * columns, in exactly the pool order lib/json.rae's parseJson builds, so
+ * a loader can bulk-copy each column into its List instead of tokenizing.
+ * Every section is 8-byte aligned:
+ *
+ *   header   8 x i64: magic, version, valueCount, childCount, fieldCount,
+ *            stringCount, stringBytes, rootIdx
+ *   kind     valueCount x i64 (JsonKind ordinal)
+ *   number   valueCount x f32, padded to 8 bytes
+ *   a        valueCount x i64 (string index, or range start)
+ *   b        valueCount x i64 (bool, or range length)
+ *   children childCount x i64
+ *   fieldKey fieldCount x i64 (string index)
+ *   fieldVal fieldCount x i64
+ *   strOff   (stringCount + 1) x i64, byte offsets into the string bytes
+ *   strings  stringBytes bytes, deduplicated, not NUL-terminated
+ */
+#define SCENEPACK_MAGIC 0x31424e4353454152LL /* "RAESCNB1" */
+#define SCENEPACK_VERSION 1
+
+/* Pack `in_path` into `out_path`. Prints a diagnostic and returns false on
+ * a read, parse, or write error. */
+bool scenepack_pack_file(const char* in_path, const char* out_path, bool verbose);
+
+#endif /* SCENEPACK_H */
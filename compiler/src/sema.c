@@ -1007,6 +1007,30 @@ static void sema_analyze_decl(CompilerContext* ctx, AstModule* module, SymbolTab
                     diag_error(err_file, (int)pt->line, (int)pt->column, buffer);
                     module->had_error = true;
                 }
+                // `bench` functions are called by the `rae bench` harness as
+                // `int64_t f(int64_t n)`: run the workload n times, return a
+                // checksum.
+                bool is_bench = false;
+                for (const AstProperty* prop = decl->as.func_decl.properties; prop; prop = prop->next) {
+                    if (str_eq_cstr(prop->name, "bench")) is_bench = true;
+                }
+                if (is_bench) {
+                    const AstParam* bp = decl->as.func_decl.params;
+                    const AstReturnItem* br = decl->as.func_decl.returns;
+                    bool shape_ok = !decl->as.func_decl.generic_params && bp && !bp->next && bp->type &&
+                                    !bp->type->is_mod && !bp->type->is_opt && bp->type->parts &&
+                                    str_eq_cstr(bp->type->parts->text, "Int") &&
+                                    br && !br->next && br->type && !br->type->is_opt && br->type->parts &&
+                                    str_eq_cstr(br->type->parts->text, "Int");
+                    if (!shape_ok) {
+                        char buffer[256];
+                        snprintf(buffer, sizeof(buffer),
+                            "bench function '%.*s' must have the shape (n: view Int) ret Int",
+                            (int)decl->as.func_decl.name.len, decl->as.func_decl.name.data);
+                        diag_error(err_file, (int)decl->line, (int)decl->column, buffer);
+                        module->had_error = true;
+                    }
+                }
             }
             AstParam* param = decl->as.func_decl.params;
             while (param) {
@@ -1100,6 +1100,27 @@ static bool native_rae_ext_rae_buf_free(struct VM* vm, VmNativeResult* out_resul
   return true;
 }
 
+/* A fresh buffer holding the old one's items, as alloc + copy would; other
+ * holders of the old buffer keep seeing it unchanged. */
+static bool native_rae_ext_rae_buf_resize(struct VM* vm, VmNativeResult* out_result, const Value* args, size_t arg_count, void* user_data) {
+  (void)vm; (void)arg_count; (void)user_data;
+  const Value* buf_val = deref_value(&args[0]);
+  const Value* val_size = deref_value(&args[1]);
+  if (val_size->type != VAL_INT) return false;
+  Value fresh = value_buffer(val_size->as.int_value > 0 ? (size_t)val_size->as.int_value : 0);
+  if (buf_val->type == VAL_BUFFER && buf_val->as.buffer_value) {
+    ValueBuffer* src = buf_val->as.buffer_value;
+    ValueBuffer* dst = fresh.as.buffer_value;
+    for (size_t i = 0; i < src->count && i < dst->count; i++) {
+      value_free(&dst->items[i]);
+      dst->items[i] = value_copy(&src->items[i]);
+    }
+  }
+  out_result->has_value = true;
+  out_result->value = fresh;
+  return true;
+}
+
 static bool native_rae_ext_rae_buf_copy(struct VM* vm, VmNativeResult* out_result, const Value* args, size_t arg_count, void* user_data) {
   (void)vm; (void)arg_count; (void)user_data;
   const Value* src_val = deref_value(&args[0]);
@@ -1328,6 +1349,7 @@ bool register_default_natives(VmRegistry* registry, TickCounter* tick_counter) {
   ok = vm_registry_register_native(registry, "rae_ext_rae_buf_alloc", native_rae_ext_rae_buf_alloc, NULL) && ok;
   ok = vm_registry_register_native(registry, "rae_ext_rae_buf_free", native_rae_ext_rae_buf_free, NULL) && ok;
   ok = vm_registry_register_native(registry, "rae_ext_rae_buf_copy", native_rae_ext_rae_buf_copy, NULL) && ok;
+  ok = vm_registry_register_native(registry, "rae_ext_rae_buf_resize", native_rae_ext_rae_buf_resize, NULL) && ok;
   ok = vm_registry_register_native(registry, "rae_ext_rae_buf_set", native_rae_ext_rae_buf_set, NULL) && ok;
   ok = vm_registry_register_native(registry, "rae_ext_rae_buf_get", native_rae_ext_rae_buf_get, NULL) && ok;
   ok = vm_registry_register_native(registry, "rae_ext_rae_buf_drop_at", native_rae_ext_rae_buf_drop_at, NULL) && ok;
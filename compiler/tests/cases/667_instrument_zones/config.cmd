@@ -0,0 +1 @@
+run --instrument=classify,with*,traced*,cleanup*,tiny
@@ -0,0 +1 @@
+run --log-level info
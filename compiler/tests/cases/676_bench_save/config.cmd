@@ -0,0 +1 @@
+bench --samples 21 --sample-ms 1 --warmup-ms 0 --no-counters --save {{TMP_OUTPUT}}
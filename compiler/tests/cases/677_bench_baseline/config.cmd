@@ -0,0 +1 @@
+bench --samples 20 --sample-ms 5 --warmup-ms 0 --no-counters --baseline tests/cases/677_bench_baseline/baseline.json
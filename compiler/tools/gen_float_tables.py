@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Generate compiler/runtime/runtime_float_tables.h.
+
+Two tables of 128-bit powers of five, each entry stored as {low, high}
+64-bit words:
+
+  rae_f2t_pow5[i], rae_f2t_pow5_inv[q]
+      Ryu's DOUBLE_POW5_SPLIT / DOUBLE_POW5_INV_SPLIT (125-bit precision):
+      5^i truncated to its top 125 bits, and floor(2^(len(5^q) - 1 + 125) / 5^q) + 1.
+      Float32 formatting uses their high words as 61-bit values.
+
+  rae_t2f_pow5[q + 348], q in [-348, 347]
+      Eisel-Lemire's table: the top 128 bits of 10^q (the same bits as
+      5^q), rounded down, so bit 127 is set.
+
+Run from compiler/:  python3 tools/gen_float_tables.py > runtime/runtime_float_tables.h
+"""
+
+POW5_BITCOUNT = 125
+POW5_INV_BITCOUNT = 125
+POW5_TABLE_SIZE = 326
+POW5_INV_TABLE_SIZE = 342
+T2F_MIN_Q = -348
+T2F_MAX_Q = 347
+
+MASK64 = (1 << 64) - 1
+
+
+def entry(v):
+    assert 0 <= v < (1 << 128)
+    return "{ 0x%016xu, 0x%016xu }" % (v & MASK64, v >> 64)
+
+
+def ryu_pow5(i):
+    p = 5 ** i
+    shift = p.bit_length() - POW5_BITCOUNT
+    return p >> shift if shift >= 0 else p << -shift
+
+
+def ryu_pow5_inv(q):
+    p = 5 ** q
+    j = p.bit_length() - 1 + POW5_INV_BITCOUNT
+    return (1 << j) // p + 1
+
+
+def lemire_pow5(q):
+    p = 5 ** abs(q)
+    if q >= 0:
+        shift = p.bit_length() - 128
+        return p >> shift if shift >= 0 else p << -shift
+    return (1 << (127 + p.bit_length())) // p
+
+
+def emit(name, values, comment):
+    print("/* %s */" % comment)
+    print("static const uint64_t %s[%d][2] = {" % (name, len(values)))
+    for v in values:
+        print("  %s," % entry(v))
+    print("};")
+    print()
+
+
+def main():
+    print("/* Generated by compiler/tools/gen_float_tables.py; do not edit. */")
+    print("/* Powers of five for float <-> text conversion (runtime_float_text.c). */")
+    print()
+    emit("rae_f2t_pow5", [ryu_pow5(i) for i in range(POW5_TABLE_SIZE)],
+         "5^i, top %d bits (formatting, e2 < 0)" % POW5_BITCOUNT)
+    emit("rae_f2t_pow5_inv", [ryu_pow5_inv(q) for q in range(POW5_INV_TABLE_SIZE)],
+         "2^(len(5^q) - 1 + %d) / 5^q + 1 (formatting, e2 >= 0)" % POW5_INV_BITCOUNT)
+    emit("rae_t2f_pow5", [lemire_pow5(q) for q in range(T2F_MIN_Q, T2F_MAX_Q + 1)],
+         "10^q for q in [%d, %d], top 128 bits rounded down (parsing)" % (T2F_MIN_Q, T2F_MAX_Q))
+
+
+if __name__ == "__main__":
+    main()